@@ -0,0 +1,42 @@
+#pragma once
+
+#include <torch/torch.h>
+
+#include "configs/configs.h"
+#include "env/task_manager.h"
+#include "storage/observation_buffer.h"
+#include "utils/types.h"
+
+namespace bench {
+
+// Environments, observation history and result tensors laid out as OnPolicyRunner does on the
+// host, the configuration is updated with the observation and action sizes
+struct Rollout {
+  const configs::CfgPointer cfg;
+  const env::EnvPointer env;
+  storage::ObservationBuffer observation_buffer;
+  env::Results results;
+  Tensor actions;
+
+  explicit Rollout(const configs::CfgPointer& cfg)
+    : cfg(cfg),
+      env(env::TaskManager::create(cfg->env_cfg.task, cfg->env_cfg, torch::kCPU)),
+      observation_buffer(cfg, this->env->get_actor_obs_size(), this->env->get_critic_obs_size(),
+                         this->env->get_action_size(), torch::kCPU) {
+    this->cfg->update(this->observation_buffer.get_actor_obs_size(),
+                      this->observation_buffer.get_critic_obs_size(), this->env->get_action_min(),
+                      this->env->get_action_max());
+    this->env->initialize();
+    const int64_t num_envs = cfg->env_cfg.num_envs;
+    this->results.actor_obs = torch::zeros({num_envs, this->env->get_actor_obs_size()});
+    this->results.critic_obs = torch::zeros({num_envs, this->env->get_critic_obs_size()});
+    this->results.rewards = torch::zeros({num_envs});
+    this->results.terminated = torch::zeros({num_envs}, torch::kBool);
+    this->results.truncated = torch::zeros({num_envs}, torch::kBool);
+    this->actions = torch::zeros({num_envs, this->env->get_action_size()});
+    this->env->reset(this->results);
+    this->observation_buffer.reset(this->results);
+  }
+};
+
+}  // namespace bench
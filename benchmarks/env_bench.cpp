@@ -0,0 +1,23 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_utils.h"
+
+static void env_sizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgName("num_envs")->RangeMultiplier(8)->Range(64, 32768);
+}
+
+static void BM_EnvStep(benchmark::State& state, const string& task, const string& integrator) {
+  torch::NoGradGuard no_grad;
+  bench::Rollout rollout(configs::make_default_cfg(task, state.range(0), integrator));
+  for (auto _ : state) {
+    rollout.env->step(rollout.results, rollout.actions);
+    benchmark::DoNotOptimize(rollout.results.rewards.data_ptr());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(BM_EnvStep, pendulum_euler, "pendulum", "euler")->Apply(env_sizes);
+BENCHMARK_CAPTURE(BM_EnvStep, pendulum_rk2, "pendulum", "rk2")->Apply(env_sizes);
+BENCHMARK_CAPTURE(BM_EnvStep, pendulum_rk4, "pendulum", "rk4")->Apply(env_sizes);
+BENCHMARK_CAPTURE(BM_EnvStep, pendulum_cart_euler, "pendulum_cart", "euler")->Apply(env_sizes);
+BENCHMARK_CAPTURE(BM_EnvStep, pendulum_cart_rk2, "pendulum_cart", "rk2")->Apply(env_sizes);
+BENCHMARK_CAPTURE(BM_EnvStep, pendulum_cart_rk4, "pendulum_cart", "rk4")->Apply(env_sizes);
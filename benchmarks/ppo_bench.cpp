@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+
+#include "algorithms/ppo.h"
+#include "bench_utils.h"
+#include "modules/distributions/beta.h"
+#include "modules/distributions/normal.h"
+
+static void BM_PPOAct(benchmark::State& state) {
+  torch::NoGradGuard no_grad;
+  bench::Rollout rollout(configs::make_default_cfg("pendulum", state.range(0)));
+  algorithms::PPO ppo(rollout.cfg, torch::kCPU);
+  ppo.train();
+  for (auto _ : state)
+    ppo.act(rollout.actions, rollout.observation_buffer.get_actor_obs(),
+            rollout.observation_buffer.get_critic_obs());
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PPOAct)->ArgName("num_envs")->RangeMultiplier(8)->Range(64, 32768);
+
+// One learning iteration on a freshly collected rollout, the collection is not timed
+static void BM_PPOUpdateActorCritic(benchmark::State& state) {
+  bench::Rollout rollout(configs::make_default_cfg("pendulum", state.range(0)));
+  algorithms::PPO ppo(rollout.cfg, torch::kCPU);
+  ppo.train();
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      torch::NoGradGuard no_grad;
+      for (unsigned int step = 0; step < rollout.cfg->runner_cfg.num_steps_per_env; ++step) {
+        ppo.act(rollout.actions, rollout.observation_buffer.get_actor_obs(),
+                rollout.observation_buffer.get_critic_obs());
+        rollout.env->step(rollout.results, rollout.actions);
+        rollout.observation_buffer.memorize(rollout.results, rollout.actions);
+        ppo.process_step(rollout.results.rewards, rollout.results.terminated,
+                         rollout.results.truncated);
+      }
+      ppo.compute_returns(rollout.observation_buffer.get_critic_obs());
+    }
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(ppo.update_actor_critic());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          rollout.cfg->runner_cfg.num_steps_per_env);
+}
+BENCHMARK(BM_PPOUpdateActorCritic)
+  ->ArgName("num_envs")
+  ->Arg(256)
+  ->Arg(4096)
+  ->Unit(benchmark::kMillisecond);
+
+template <typename Distribution>
+static std::shared_ptr<Distribution> make_distribution(const int64_t& num_actions) {
+  configs::DistributionCfg cfg{0.5f, ""};
+  cfg.update(-torch::ones({num_actions}), torch::ones({num_actions}));
+  return std::make_shared<Distribution>(cfg);
+}
+
+template <typename Distribution>
+static void BM_DistributionSample(benchmark::State& state) {
+  torch::NoGradGuard no_grad;
+  const std::shared_ptr<Distribution>& distribution = make_distribution<Distribution>(4);
+  distribution->update(0.25f + 0.5f * torch::rand({state.range(0), 4}));
+  for (auto _ : state) benchmark::DoNotOptimize(distribution->sample());
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Log-probability, entropy and KL as queried by the learner for every minibatch
+template <typename Distribution>
+static void BM_DistributionTerms(benchmark::State& state) {
+  torch::NoGradGuard no_grad;
+  const std::shared_ptr<Distribution>& distribution = make_distribution<Distribution>(4);
+  const Tensor& hidden_output = 0.25f + 0.5f * torch::rand({state.range(0), 4});
+  distribution->update(hidden_output);
+  const Tensor& actions = distribution->sample();
+  const DictTensor& kl_params = distribution->get_kl_params();
+  for (auto _ : state) {
+    // Drops the terms cached since the previous update, as every forward pass does
+    distribution->update(hidden_output);
+    benchmark::DoNotOptimize(distribution->get_terms(actions, kl_params));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void batch_sizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgName("batch_size")->RangeMultiplier(8)->Range(256, 32768);
+}
+BENCHMARK_TEMPLATE(BM_DistributionSample, modules::Normal)->Apply(batch_sizes);
+BENCHMARK_TEMPLATE(BM_DistributionSample, modules::Beta)->Apply(batch_sizes);
+BENCHMARK_TEMPLATE(BM_DistributionTerms, modules::Normal)->Apply(batch_sizes);
+BENCHMARK_TEMPLATE(BM_DistributionTerms, modules::Beta)->Apply(batch_sizes);
@@ -0,0 +1,99 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_utils.h"
+#include "storage/rollout.h"
+
+static void buffer_sizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"num_envs", "memory_length"})
+    ->ArgsProduct({{256, 4096}, {1, 4, 16}});
+}
+
+static void rollout_sizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"num_envs", "num_steps"})->ArgsProduct({{256, 4096}, {32}});
+}
+
+static void BM_ObservationBufferMemorize(benchmark::State& state) {
+  torch::NoGradGuard no_grad;
+  bench::Rollout rollout(
+    configs::make_default_cfg("pendulum", state.range(0), "rk4", state.range(1)));
+  for (auto _ : state) rollout.observation_buffer.memorize(rollout.results, rollout.actions);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ObservationBufferMemorize)->Apply(buffer_sizes);
+
+static void BM_ObservationBufferReset(benchmark::State& state) {
+  torch::NoGradGuard no_grad;
+  bench::Rollout rollout(
+    configs::make_default_cfg("pendulum", state.range(0), "rk4", state.range(1)));
+  // Every other environment finished its episode
+  const Tensor& done_ids = torch::arange(state.range(0)).remainder(2).to(torch::kBool);
+  for (auto _ : state) rollout.observation_buffer.reset(rollout.results, done_ids);
+  state.SetItemsProcessed(state.iterations() * state.range(0) / 2);
+}
+BENCHMARK(BM_ObservationBufferReset)->Apply(buffer_sizes);
+
+// Storage filled with random transitions of the pendulum sizes
+struct FilledStorage {
+  bench::Rollout rollout;
+  storage::RolloutStorage storage;
+  storage::Transition transition;
+
+  explicit FilledStorage(const configs::CfgPointer& cfg)
+    : rollout(cfg), storage(cfg, torch::kCPU) {
+    const int64_t num_envs = cfg->env_cfg.num_envs;
+    const int64_t action_size = cfg->actor_cfg.mlp_cfg.num_outputs;
+    this->storage.initialize({{"mean", torch::zeros({action_size})},
+                              {"std", torch::zeros({action_size})}});
+    this->transition.actor_obs = torch::rand({num_envs, cfg->actor_cfg.mlp_cfg.num_inputs});
+    this->transition.critic_obs = torch::rand({num_envs, cfg->critic_cfg.mlp_cfg.num_inputs});
+    this->transition.actions = torch::rand({num_envs, action_size});
+    this->transition.rewards = torch::rand({num_envs, 1});
+    this->transition.dones = (torch::rand({num_envs, 1}) < 0.01f).to(torch::kFloat);
+    this->transition.values = torch::rand({num_envs, 1});
+    this->transition.log_probs = torch::rand({num_envs, 1});
+    this->transition.kl_params = {{"mean", torch::rand({num_envs, action_size})},
+                                  {"std", torch::rand({num_envs, action_size})}};
+    for (unsigned int step = 0; step < cfg->runner_cfg.num_steps_per_env; ++step)
+      this->storage.push_back(this->transition);
+  }
+};
+
+static void BM_RolloutStoragePushBack(benchmark::State& state) {
+  torch::NoGradGuard no_grad;
+  FilledStorage filled(
+    configs::make_default_cfg("pendulum", state.range(0), "rk4", 1, state.range(1)));
+  int64_t step = state.range(1);
+  for (auto _ : state) {
+    if (step == state.range(1)) {
+      filled.storage.clear();
+      step = 0;
+    }
+    filled.storage.push_back(filled.transition);
+    ++step;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RolloutStoragePushBack)->Apply(rollout_sizes);
+
+static void BM_RolloutStorageComputeAdvantage(benchmark::State& state) {
+  torch::NoGradGuard no_grad;
+  FilledStorage filled(
+    configs::make_default_cfg("pendulum", state.range(0), "rk4", 1, state.range(1)));
+  const Tensor& last_values = torch::rand({state.range(0), 1});
+  for (auto _ : state) filled.storage.compute_advantage(last_values.clone(), 0.99f, 0.95f);
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+BENCHMARK(BM_RolloutStorageComputeAdvantage)->Apply(rollout_sizes);
+
+static void BM_RolloutStorageUpdateBatches(benchmark::State& state) {
+  torch::NoGradGuard no_grad;
+  FilledStorage filled(
+    configs::make_default_cfg("pendulum", state.range(0), "rk4", 1, state.range(1)));
+  std::vector<storage::Transition> batches;
+  for (auto _ : state) {
+    filled.storage.update_batches(batches);
+    benchmark::DoNotOptimize(batches.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+BENCHMARK(BM_RolloutStorageUpdateBatches)->Apply(rollout_sizes);
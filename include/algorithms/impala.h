@@ -0,0 +1,68 @@
+#pragma once
+
+#include <torch/torch.h>
+
+#include <atomic>
+
+#include "configs/configs.h"
+#include "modules/actor_critic.h"
+#include "ppo.h"
+#include "storage/trajectory.h"
+#include "utils/types.h"
+
+namespace algorithms {
+
+// Immutable copy of the learner weights, shared with the actors
+struct PolicySnapshot {
+  const unsigned int version;
+  const ListTensor state;
+
+  PolicySnapshot(const unsigned int& version, const ListTensor& state)
+    : version(version), state(state) {}
+};
+
+using PolicySnapshotPointer = std::shared_ptr<const PolicySnapshot>;
+
+// V-trace targets (Espeholt et al., 2018) over time-major [num_steps, num_envs, 1] tensors, with
+// bootstrap_values [num_envs, 1] of the observations after the last step
+void compute_vtrace(const Tensor& log_rhos, const Tensor& rewards, const Tensor& dones,
+                    const Tensor& values, const Tensor& bootstrap_values, const float& gamma,
+                    const float& lam, const float& rho_clip, const float& c_clip, Tensor& vs,
+                    Tensor& advantages);
+
+// Learner side of IMPALA: actor-critic updates on off-policy trajectories with V-trace targets.
+// Weights are published after every update by atomically swapping the snapshot pointer.
+class IMPALA {
+ public:
+  IMPALA(const configs::CfgPointer& cfg, const Device& device);
+
+  const LossMetrics update(const storage::Trajectory& trajectory);
+  const PolicySnapshotPointer get_snapshot() const { return std::atomic_load(&this->snapshot_); }
+  const std::function<Tensor(const Tensor&)> get_inference_policy() const {
+    return this->actor_critic_->get_inference_policy();
+  }
+  const modules::ActorCriticPointer& get_actor_critic() const { return this->actor_critic_; }
+  const Tensor& get_action_std() const { return this->actor_critic_->get_action_std(); };
+  float get_learning_rate() const {
+    return static_cast<float>(this->optimizer_->param_groups()[0].options().get_lr());
+  }
+  void train() { this->actor_critic_->train(); }
+  void eval() { this->actor_critic_->eval(); }
+  // Copies the models and optimizer state, the checkpoint writer builds the archive from them
+  storage::ArchiveWriter snapshot_models() const;
+  void load_models(torch::serialize::InputArchive& archive, const bool& load_optimizer);
+
+ private:
+  void publish_snapshot_();
+
+  const configs::CfgPointer cfg_;
+  modules::ActorCriticPointer actor_critic_;
+  AdamPointer optimizer_;
+
+  const Device device_;
+  unsigned int version_ = 0;
+  PolicySnapshotPointer snapshot_;
+};
+
+using IMPALAPointer = std::unique_ptr<algorithms::IMPALA>;
+}  // namespace algorithms
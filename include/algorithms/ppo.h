@@ -2,9 +2,17 @@
 
 #include <torch/torch.h>
 
+#include <array>
+
 #include "configs/configs.h"
+#include "distributed/process_group.h"
 #include "modules/actor_critic.h"
+#include "modules/scripted_policy.h"
+#include "ppo_loss.h"
+#include "storage/checkpoint_manager.h"
+#include "storage/mmap_checkpoint.h"
 #include "storage/rollout.h"
+#include "utils/memory.h"
 #include "utils/utils.h"
 
 namespace algorithms {
@@ -35,32 +43,72 @@ struct LossMetrics {
 
 class PPO {
  public:
-  PPO(const configs::CfgPointer& cfg, const Device& device);
+  PPO(const configs::CfgPointer& cfg, const Device& device,
+      const distributed::ProcessGroupPointer& process_group = nullptr);
 
   void act(Tensor& actions, const Tensor& actor_obs, const Tensor& critic_obs);
   void process_step(const Tensor& rewards, const Tensor& terminated, const Tensor& truncated);
   void compute_returns(const Tensor critic_obs);
   const LossMetrics update_actor_critic();
+  void swap_rollouts();
   const std::function<Tensor(const Tensor&)> get_inference_policy() const {
     return this->actor_critic_->get_inference_policy();
   }
+  const modules::ActorCriticPointer& get_actor_critic() const { return this->actor_critic_; }
   const Tensor& get_action_std() const { return this->actor_critic_->get_action_std(); };
-  float get_learning_rate() const { return this->optimizer_->param_groups()[0].options().get_lr(); }
-  void train() { this->actor_critic_->train(); }
-  void eval() { this->actor_critic_->eval(); }
-  void save_models(torch::serialize::OutputArchive& archive) const;
+  float get_learning_rate() const { return this->learning_rate_.item<float>(); }
+  // Rollouts, minibatches materialised by the last update, policies and Adam moments
+  const utils::MemoryReport memory_report() const;
+  void train();
+  void eval();
+  // Copies the models and optimizer state, the checkpoint writer builds the archive from them
+  storage::ArchiveWriter snapshot_models() const;
   void load_models(torch::serialize::InputArchive& archive, const bool& load_optimizer);
+  // Actor weights and normalizer statistics only, enough for play and evaluation
+  void load_inference_models(const storage::MmapCheckpoint& checkpoint);
 
  private:
   void initialize_();
+  void update_normalizers_();
+  // frozen is a 0-dim bool mask, true keeps the learning rate
+  void update_learning_rate_(const Tensor& kl, const Tensor& frozen);
+  // active is a 0-dim float mask, 0 skips the step entirely
+  void optimizer_step_(const Tensor& active);
+  torch::optim::AdamParamState& adam_state_(const Tensor& parameter);
+  void sync_adam_steps_() const;
+  void all_reduce_gradients_(Tensor& kl);
+  void broadcast_models_();
+  // With overlapping collection, rollouts are gathered by a frozen copy of the policy into one
+  // storage while the learner updates on the other
+  modules::ActorCritic& behaviour_actor_critic_() const {
+    return this->behaviour_actor_critic_pointer_ ? *this->behaviour_actor_critic_pointer_
+                                                 : *this->actor_critic_;
+  }
+  const storage::RolloutStoragePointer& collection_storage_() const {
+    return this->rollout_storages_[this->collection_index_];
+  }
+  const storage::RolloutStoragePointer& learning_storage_() const {
+    return this->rollout_storages_[this->learning_index_];
+  }
 
   const configs::CfgPointer cfg_;
   modules::ActorCriticPointer actor_critic_;
-  storage::RolloutStoragePointer rollout_storage_;
+  modules::ActorCriticPointer behaviour_actor_critic_pointer_;
+  // Rollout forward pass as one TorchScript graph, reads the weights of the behaviour policy
+  modules::ScriptedPolicyPointer scripted_policy_;
+  std::array<storage::RolloutStoragePointer, 2> rollout_storages_;
+  unsigned int collection_index_ = 0;
+  unsigned int learning_index_ = 0;
   AdamPointer optimizer_;
+  const distributed::ProcessGroupPointer process_group_;
+  const AllReduceFn all_reduce_;
 
   const Device device_;
   storage::Transition transition_;
+  Tensor learning_rate_;
+  // Adam steps taken, on device so that masked minibatches do not count
+  Tensor step_count_;
+  int64_t minibatch_bytes_ = 0;
 };
 
 using PPOPointer = std::unique_ptr<algorithms::PPO>;
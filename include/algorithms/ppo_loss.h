@@ -0,0 +1,24 @@
+#pragma once
+
+#include <torch/torch.h>
+
+#include "configs/configs.h"
+#include "utils/types.h"
+
+namespace algorithms {
+
+using AutogradContext = torch::autograd::AutogradContext;
+using VariableList = torch::autograd::variable_list;
+
+// Clipped surrogate, (clipped) value loss and entropy bonus as a single autograd node.
+// Outputs the scalar loss and the non-differentiable [surrogate, value, entropy] means.
+class PPOLoss : public torch::autograd::Function<PPOLoss> {
+ public:
+  static VariableList forward(AutogradContext* ctx, const Tensor& log_probs, const Tensor& values,
+                              const Tensor& entropy, const Tensor& old_log_probs,
+                              const Tensor& old_values, const Tensor& advantages,
+                              const Tensor& returns, const configs::PPOCfg& cfg);
+  static VariableList backward(AutogradContext* ctx, VariableList grad_outputs);
+};
+
+}  // namespace algorithms
@@ -28,9 +28,16 @@ struct MLPCfg {
   unsigned int width;
   const unsigned int depth;
   const string activation;
+  const string precision;
+  const string backend;
 
-  MLPCfg(const unsigned int& width, const unsigned int& depth, const string& activation)
-    : width(width), depth(depth), activation(activation) {}
+  MLPCfg(const unsigned int& width, const unsigned int& depth, const string& activation,
+         const string& precision = "float32", const string& backend = "torch")
+    : width(width),
+      depth(depth),
+      activation(activation),
+      precision(precision),
+      backend(backend) {}
 
   void update(const unsigned int& num_obs, const unsigned int& action_size) {
     this->num_inputs = num_obs;
@@ -44,7 +51,9 @@ struct MLPCfg {
        << std::endl;
     os << "         width: " << cfg.width << " (modified depending on env)" << std::endl;
     os << "         depth: " << cfg.depth << std::endl;
-    os << "         activation: " << cfg.activation;
+    os << "         activation: " << cfg.activation << std::endl;
+    os << "         precision: " << cfg.precision << std::endl;
+    os << "         backend: " << cfg.backend;
     return os;
   }
 };
@@ -135,6 +144,7 @@ struct PPOCfg {
   const bool use_clipped_value_loss;
   // -- Surrogate loss
   const float desired_kl;
+  const float max_kl;
   const float entropy_coef;
   const float gamma;
   const float lam;
@@ -146,16 +156,21 @@ struct PPOCfg {
   const unsigned int num_epochs;
   const unsigned int num_batches;
   const string learning_rate_schedule;
+  // -- Execution
+  const bool fused_actor_critic;
 
   PPOCfg(const float& value_loss_coef, const float& clip_param, const bool& use_clipped_value_loss,
-         const float& desired_kl, const float& entropy_coef, const float& gamma, const float& lam,
-         const float& max_grad_norm, const float& learning_rate, const float& min_learning_rate,
+         const float& desired_kl, const float& max_kl, const float& entropy_coef,
+         const float& gamma, const float& lam, const float& max_grad_norm,
+         const float& learning_rate, const float& min_learning_rate,
          const float& max_learning_rate, const unsigned int& num_epochs,
-         const unsigned int& num_batches, const string& learning_rate_schedule)
+         const unsigned int& num_batches, const string& learning_rate_schedule,
+         const bool& fused_actor_critic)
     : value_loss_coef(value_loss_coef),
       clip_param(clip_param),
       use_clipped_value_loss(use_clipped_value_loss),
       desired_kl(desired_kl),
+      max_kl(max_kl),
       entropy_coef(entropy_coef),
       gamma(gamma),
       lam(lam),
@@ -165,13 +180,15 @@ struct PPOCfg {
       max_learning_rate(max_learning_rate),
       num_epochs(num_epochs),
       num_batches(num_batches),
-      learning_rate_schedule(learning_rate_schedule) {}
+      learning_rate_schedule(learning_rate_schedule),
+      fused_actor_critic(fused_actor_critic) {}
 
   friend std::ostream& operator<<(std::ostream& os, const PPOCfg& cfg) {
     os << "    value_loss_coef: " << cfg.value_loss_coef << std::endl;
     os << "    clip_param: " << cfg.clip_param << std::endl;
     os << "    use_clipped_value_loss: " << cfg.use_clipped_value_loss << std::endl;
     os << "    desired_kl: " << cfg.desired_kl << std::endl;
+    os << "    max_kl: " << cfg.max_kl << std::endl;
     os << "    entropy_coef: " << cfg.entropy_coef << std::endl;
     os << "    gamma: " << cfg.gamma << std::endl;
     os << "    lam: " << cfg.lam << std::endl;
@@ -181,7 +198,8 @@ struct PPOCfg {
     os << "    max_learning_rate: " << cfg.max_learning_rate << std::endl;
     os << "    num_epochs: " << cfg.num_epochs << std::endl;
     os << "    num_batches: " << cfg.num_batches << std::endl;
-    os << "    learning_rate_schedule: " << cfg.learning_rate_schedule;
+    os << "    learning_rate_schedule: " << cfg.learning_rate_schedule << std::endl;
+    os << "    fused_actor_critic: " << (cfg.fused_actor_critic ? "true" : "false");
     return os;
   }
 };
@@ -192,23 +210,55 @@ struct RunnerCfg {
   const unsigned int num_steps_per_env;
   const unsigned int observation_memory_length;
   const bool observation_memory_store_action;
+  const bool overlap_collection;
+  const bool scripted_step;
   // -- Saving
   const unsigned int save_interval;
+  const unsigned int max_checkpoints;
   // -- Logging
   const unsigned int logging_buffer;
   const unsigned int logging_warmup;
+  const unsigned int console_verbosity;
+  const float console_interval;
+  // -- Tracing
+  const std::vector<std::pair<unsigned int, unsigned int>> trace_windows;
+  const bool trace_autograd;
+  const bool perf_counters;
+  const bool memory_accounting;
+  // -- Architecture
+  const string type;
 
   RunnerCfg(const unsigned int& max_iterations, const unsigned int& num_steps_per_env,
             const unsigned int& observation_memory_length,
-            const bool& observation_memory_store_action, const unsigned int& save_interval,
-            const unsigned int& logging_buffer, const unsigned int& logging_warmup)
+            const bool& observation_memory_store_action, const bool& overlap_collection,
+            const bool& scripted_step, const unsigned int& save_interval,
+            const unsigned int& max_checkpoints, const unsigned int& logging_buffer,
+            const unsigned int& logging_warmup, const unsigned int& console_verbosity,
+            const float& console_interval,
+            const std::vector<std::pair<unsigned int, unsigned int>>& trace_windows,
+            const bool& trace_autograd, const bool& perf_counters, const bool& memory_accounting,
+            const string& type)
     : max_iterations(max_iterations),
       num_steps_per_env(num_steps_per_env),
       observation_memory_length(observation_memory_length),
       observation_memory_store_action(observation_memory_store_action),
+      overlap_collection(overlap_collection),
+      scripted_step(scripted_step),
       save_interval(save_interval),
+      max_checkpoints(max_checkpoints),
       logging_buffer(logging_buffer),
-      logging_warmup(logging_warmup) {}
+      logging_warmup(logging_warmup),
+      console_verbosity(console_verbosity),
+      console_interval(console_interval),
+      trace_windows(trace_windows),
+      trace_autograd(trace_autograd),
+      perf_counters(perf_counters),
+      memory_accounting(memory_accounting),
+      type(type) {
+    // The allocation counter and the legacy autograd profiler share one thread-local slot
+    if (this->memory_accounting && this->trace_autograd)
+      throw std::invalid_argument("memory_accounting cannot be combined with trace_autograd");
+  }
 
   friend std::ostream& operator<<(std::ostream& os, const RunnerCfg& cfg) {
     os << "    max_iterations: " << cfg.max_iterations << std::endl;
@@ -216,9 +266,22 @@ struct RunnerCfg {
     os << "    observation_memory_length: " << cfg.observation_memory_length << std::endl;
     os << "    observation_memory_store_action: "
        << (cfg.observation_memory_store_action ? "true" : "false") << std::endl;
+    os << "    overlap_collection: " << (cfg.overlap_collection ? "true" : "false") << std::endl;
+    os << "    scripted_step: " << (cfg.scripted_step ? "true" : "false") << std::endl;
     os << "    save_interval: " << cfg.save_interval << std::endl;
+    os << "    max_checkpoints: " << cfg.max_checkpoints << std::endl;
     os << "    logging_buffer: " << cfg.logging_buffer << std::endl;
-    os << "    logging_warmup: " << cfg.logging_warmup;
+    os << "    logging_warmup: " << cfg.logging_warmup << std::endl;
+    os << "    console_verbosity: " << cfg.console_verbosity << std::endl;
+    os << "    console_interval: " << cfg.console_interval << std::endl;
+    os << "    trace_windows: ";
+    for (const auto& [start, length] : cfg.trace_windows)
+      os << "[" << start << ", " << length << "] ";
+    os << std::endl;
+    os << "    trace_autograd: " << (cfg.trace_autograd ? "true" : "false") << std::endl;
+    os << "    perf_counters: " << (cfg.perf_counters ? "true" : "false") << std::endl;
+    os << "    memory_accounting: " << (cfg.memory_accounting ? "true" : "false") << std::endl;
+    os << "    type: " << cfg.type;
     return os;
   }
 };
@@ -242,6 +305,14 @@ struct EnvCfg {
       integrator(integrator),
       dt(dt) {}
 
+  const EnvCfg shard(const unsigned int& rank, const unsigned int& world_size) const {
+    if (this->num_envs % world_size != 0)
+      throw std::invalid_argument("num_envs must be divisible by the number of shards");
+    return EnvCfg(this->run_id, this->task, this->num_envs / world_size,
+                  this->seed < 0 ? this->seed : this->seed + static_cast<int>(rank),
+                  this->max_iterations, this->integrator, this->dt);
+  }
+
   friend std::ostream& operator<<(std::ostream& os, const EnvCfg& cfg) {
     os << "    run_id: " << cfg.run_id << std::endl;
     os << "    task: " << cfg.task << std::endl;
@@ -254,20 +325,127 @@ struct EnvCfg {
   }
 };
 
+struct DistributedCfg {
+  const unsigned int world_size;
+  const unsigned int rank;
+  const unsigned int master_port;
+
+  DistributedCfg(const unsigned int& world_size = 1, const unsigned int& rank = 0,
+                 const unsigned int& master_port = 29500)
+    : world_size(world_size), rank(rank), master_port(master_port) {}
+
+  bool is_main() const { return this->rank == 0; }
+
+  friend std::ostream& operator<<(std::ostream& os, const DistributedCfg& cfg) {
+    os << "    world_size: " << cfg.world_size << std::endl;
+    os << "    rank: " << cfg.rank << std::endl;
+    os << "    master_port: " << cfg.master_port;
+    return os;
+  }
+};
+
+struct ImpalaCfg {
+  const unsigned int num_actors;
+  const unsigned int queue_size;
+  const float rho_clip;
+  const float c_clip;
+
+  ImpalaCfg(const unsigned int& num_actors = 4, const unsigned int& queue_size = 8,
+            const float& rho_clip = 1.f, const float& c_clip = 1.f)
+    : num_actors(num_actors), queue_size(queue_size), rho_clip(rho_clip), c_clip(c_clip) {}
+
+  friend std::ostream& operator<<(std::ostream& os, const ImpalaCfg& cfg) {
+    os << "    num_actors: " << cfg.num_actors << std::endl;
+    os << "    queue_size: " << cfg.queue_size << std::endl;
+    os << "    rho_clip: " << cfg.rho_clip << std::endl;
+    os << "    c_clip: " << cfg.c_clip;
+    return os;
+  }
+};
+
+struct ServerCfg {
+  const string socket_path;
+  const unsigned int max_batch_size;
+  const unsigned int max_wait_us;
+  const float reload_interval;
+  const float report_interval;
+
+  ServerCfg(const string& socket_path = "/tmp/cpp_rl.sock", const unsigned int& max_batch_size = 64,
+            const unsigned int& max_wait_us = 500, const float& reload_interval = 2.f,
+            const float& report_interval = 10.f)
+    : socket_path(socket_path),
+      max_batch_size(max_batch_size),
+      max_wait_us(max_wait_us),
+      reload_interval(reload_interval),
+      report_interval(report_interval) {
+    if (this->max_batch_size == 0) throw std::invalid_argument("max_batch_size must be positive");
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const ServerCfg& cfg) {
+    os << "    socket_path: " << cfg.socket_path << std::endl;
+    os << "    max_batch_size: " << cfg.max_batch_size << std::endl;
+    os << "    max_wait_us: " << cfg.max_wait_us << std::endl;
+    os << "    reload_interval: " << cfg.reload_interval << std::endl;
+    os << "    report_interval: " << cfg.report_interval;
+    return os;
+  }
+};
+
+struct QuantizationCfg {
+  const unsigned int num_episodes;
+  const float max_action_error;
+  const float max_return_drop;
+
+  QuantizationCfg(const unsigned int& num_episodes = 10, const float& max_action_error = 0.05f,
+                  const float& max_return_drop = 0.05f)
+    : num_episodes(num_episodes),
+      max_action_error(max_action_error),
+      max_return_drop(max_return_drop) {
+    if (this->num_episodes == 0) throw std::invalid_argument("num_episodes must be positive");
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const QuantizationCfg& cfg) {
+    os << "    num_episodes: " << cfg.num_episodes << std::endl;
+    os << "    max_action_error: " << cfg.max_action_error << std::endl;
+    os << "    max_return_drop: " << cfg.max_return_drop;
+    return os;
+  }
+};
+
 struct Cfg {
   const EnvCfg env_cfg;
   const RunnerCfg runner_cfg;
   const PPOCfg ppo_cfg;
   ActorCfg actor_cfg;
   CriticCfg critic_cfg;
+  const DistributedCfg distributed_cfg;
+  const ImpalaCfg impala_cfg;
+  const ServerCfg server_cfg;
+  const QuantizationCfg quantization_cfg;
 
   Cfg(const EnvCfg& env_cfg, const RunnerCfg& runner_cfg, const PPOCfg& ppo_cfg,
-      const ActorCfg& actor_cfg, const CriticCfg& critic_cfg)
+      const ActorCfg& actor_cfg, const CriticCfg& critic_cfg,
+      const DistributedCfg& distributed_cfg = DistributedCfg(),
+      const ImpalaCfg& impala_cfg = ImpalaCfg(), const ServerCfg& server_cfg = ServerCfg(),
+      const QuantizationCfg& quantization_cfg = QuantizationCfg())
     : env_cfg(env_cfg),
       runner_cfg(runner_cfg),
       ppo_cfg(ppo_cfg),
       actor_cfg(actor_cfg),
-      critic_cfg(critic_cfg) {}
+      critic_cfg(critic_cfg),
+      distributed_cfg(distributed_cfg),
+      impala_cfg(impala_cfg),
+      server_cfg(server_cfg),
+      quantization_cfg(quantization_cfg) {}
+
+  // Same configuration restricted to one of num_shards slices of the environments
+  const std::shared_ptr<Cfg> shard(const unsigned int& index,
+                                   const unsigned int& num_shards) const {
+    return std::make_shared<Cfg>(this->env_cfg.shard(index, num_shards), this->runner_cfg,
+                                 this->ppo_cfg, this->actor_cfg, this->critic_cfg,
+                                 this->distributed_cfg, this->impala_cfg, this->server_cfg,
+                                 this->quantization_cfg);
+  }
 
   void update(const unsigned int& num_actor_obs, const unsigned int& num_critic_obs,
               const Tensor& action_min, const Tensor& action_max) {
@@ -281,10 +459,35 @@ struct Cfg {
     os << "ppo: \n" << cfg.ppo_cfg << std::endl;
     os << "actor: \n" << cfg.actor_cfg << std::endl;
     os << "critic: \n" << cfg.critic_cfg << std::endl;
+    os << "distributed: \n" << cfg.distributed_cfg << std::endl;
+    os << "impala: \n" << cfg.impala_cfg << std::endl;
+    os << "server: \n" << cfg.server_cfg << std::endl;
+    os << "quantization: \n" << cfg.quantization_cfg << std::endl;
     return os;
   }
 };
 
 using CfgPointer = std::shared_ptr<Cfg>;
 
+// Defaults of yaml/train.yaml with small networks and the given sizes, independent of the working
+// directory. Shared by the tests and benchmarks so that the positional constructors are spelled
+// out in one place.
+inline CfgPointer make_default_cfg(const string& task, const unsigned int& num_envs,
+                                   const string& integrator = "rk4",
+                                   const unsigned int& memory_length = 1,
+                                   const unsigned int& num_steps_per_env = 32,
+                                   const bool& store_action = false) {
+  const EnvCfg env_cfg{0, task, num_envs, 0, 500, integrator, 0.02f};
+  const RunnerCfg runner_cfg{1,     num_steps_per_env, memory_length, store_action, false,
+                             false, 100000000,         0,             100,          100,
+                             0,     0.f,               {},            false,        false,
+                             false, "on_policy"};
+  const PPOCfg ppo_cfg{1.f,  0.2f,  true,  0.01f, 0.f, 0.f, 0.99f,      0.95f,
+                       1.f,  1e-3f, 1e-6f, 1e-2f, 2,   8,   "adaptive", false};
+  const ActorCfg actor_cfg{NormalizerCfg{"identity"}, MLPCfg{2, 2, "elu"},
+                           DistributionCfg{2.f, "normal"}};
+  const CriticCfg critic_cfg{NormalizerCfg{"identity"}, MLPCfg{2, 2, "elu"}};
+  return std::make_shared<Cfg>(env_cfg, runner_cfg, ppo_cfg, actor_cfg, critic_cfg);
+}
+
 }  // namespace configs
\ No newline at end of file
@@ -8,40 +8,66 @@
 
 namespace configs {
 
-inline const CfgPointer load_config(const string& task, const bool& play) {
-  const string task_path = "data/" + task;
-  int last_train_run_id = utils::last_run_id(task_path);
-  const string last_train_run_path = task_path + "/run_" + std::to_string(last_train_run_id);
-
-  const string train_config_path = play ? last_train_run_path + "/config.yaml" : "yaml/train.yaml";
-  const string play_config_path = "yaml/play.yaml";
-
-  YAML::Node train_config = YAML::LoadFile(train_config_path);
-  YAML::Node play_config = YAML::LoadFile(play_config_path);
-
-  int play_run_id = play_config["run_id"].as<int>();
-
-  play_run_id = play_run_id < 0 ? last_train_run_id : play_run_id;
+// Configuration of already parsed train and play documents, run_id names the run folder
+inline const CfgPointer load_config(const string& task, const YAML::Node& train_config,
+                                    const YAML::Node& play_config, const bool& play,
+                                    const int& run_id, const unsigned int& rank = 0) {
+  // Distributed Configuration
+  const auto& distributed_yaml = train_config["distributed"];
+  const DistributedCfg distributed_cfg{
+    !play && distributed_yaml ? distributed_yaml["world_size"].as<unsigned int>() : 1, rank,
+    distributed_yaml ? distributed_yaml["master_port"].as<unsigned int>() : 29500};
 
-  // Env Configuration
+  // Env Configuration, each process steps its own shard of the environments
   const auto& env_yaml = train_config["env"];
-  const EnvCfg env_cfg{play ? play_run_id : last_train_run_id,
-                       task,
-                       play ? 1 : env_yaml["num_envs"].as<unsigned int>(),
-                       play ? -1 : env_yaml["seed"].as<int>(),
-                       env_yaml["max_iterations"].as<int>(),
-                       env_yaml["integrator"] ? env_yaml["integrator"].as<std::string>() : "",
-                       env_yaml["dt"] ? env_yaml["dt"].as<float>() : POS_INF_F};
+  const EnvCfg env_cfg =
+    EnvCfg{run_id,
+           task,
+           play ? 1 : env_yaml["num_envs"].as<unsigned int>(),
+           play ? -1 : env_yaml["seed"].as<int>(),
+           env_yaml["max_iterations"].as<int>(),
+           env_yaml["integrator"] ? env_yaml["integrator"].as<std::string>() : "",
+           env_yaml["dt"] ? env_yaml["dt"].as<float>() : POS_INF_F}
+      .shard(distributed_cfg.rank, distributed_cfg.world_size);
 
   // Runner Configuration
   const auto& runner_yaml = train_config["runner"];
+  // Each window is [first iteration, number of iterations]
+  std::vector<std::pair<unsigned int, unsigned int>> trace_windows;
+  if (runner_yaml["trace_windows"])
+    for (const auto& window : runner_yaml["trace_windows"])
+      trace_windows.emplace_back(window[0].as<unsigned int>(), window[1].as<unsigned int>());
   const RunnerCfg runner_cfg{runner_yaml["max_iterations"].as<unsigned int>(),
                              runner_yaml["num_steps_per_env"].as<unsigned int>(),
                              runner_yaml["observation_memory_length"].as<unsigned int>(),
                              runner_yaml["observation_memory_store_action"].as<bool>(),
+                             runner_yaml["overlap_collection"]
+                               ? runner_yaml["overlap_collection"].as<bool>()
+                               : false,
+                             runner_yaml["scripted_step"] ? runner_yaml["scripted_step"].as<bool>()
+                                                          : false,
                              runner_yaml["save_interval"].as<unsigned int>(),
+                             runner_yaml["max_checkpoints"]
+                               ? runner_yaml["max_checkpoints"].as<unsigned int>()
+                               : 0,
                              runner_yaml["logging_buffer"].as<unsigned int>(),
-                             runner_yaml["logging_warmup"].as<unsigned int>()};
+                             runner_yaml["logging_warmup"].as<unsigned int>(),
+                             runner_yaml["console_verbosity"]
+                               ? runner_yaml["console_verbosity"].as<unsigned int>()
+                               : 2,
+                             runner_yaml["console_interval"]
+                               ? runner_yaml["console_interval"].as<float>()
+                               : 0.f,
+                             trace_windows,
+                             runner_yaml["trace_autograd"]
+                               ? runner_yaml["trace_autograd"].as<bool>()
+                               : false,
+                             runner_yaml["perf_counters"] ? runner_yaml["perf_counters"].as<bool>()
+                                                          : false,
+                             runner_yaml["memory_accounting"]
+                               ? runner_yaml["memory_accounting"].as<bool>()
+                               : false,
+                             runner_yaml["type"] ? runner_yaml["type"].as<string>() : "on_policy"};
 
   // PPO Configuration
   const auto& ppo_yaml = train_config["ppo"];
@@ -49,6 +75,7 @@ inline const CfgPointer load_config(const string& task, const bool& play) {
                        ppo_yaml["clip_param"].as<float>(),
                        ppo_yaml["use_clipped_value_loss"].as<bool>(),
                        ppo_yaml["desired_kl"].as<float>(),
+                       ppo_yaml["max_kl"] ? ppo_yaml["max_kl"].as<float>() : 0.f,
                        ppo_yaml["entropy_coef"].as<float>(),
                        ppo_yaml["gamma"].as<float>(),
                        ppo_yaml["lam"].as<float>(),
@@ -58,7 +85,9 @@ inline const CfgPointer load_config(const string& task, const bool& play) {
                        ppo_yaml["max_learning_rate"].as<float>(),
                        ppo_yaml["num_epochs"].as<unsigned int>(),
                        ppo_yaml["num_batches"].as<unsigned int>(),
-                       ppo_yaml["learning_rate_schedule"].as<string>()};
+                       ppo_yaml["learning_rate_schedule"].as<string>(),
+                       ppo_yaml["fused_actor_critic"] ? ppo_yaml["fused_actor_critic"].as<bool>()
+                                                      : false};
 
   // Actor-Critic Configuration
   const auto& actor_normalizer_yaml = train_config["actor"]["normalizer"];
@@ -66,7 +95,13 @@ inline const CfgPointer load_config(const string& task, const bool& play) {
   const auto& actor_mlp_yaml = train_config["actor"]["mlp"];
   const MLPCfg actor_mlp_cfg{actor_mlp_yaml["width"].as<unsigned int>(),
                              actor_mlp_yaml["depth"].as<unsigned int>(),
-                             actor_mlp_yaml["activation"].as<string>()};
+                             actor_mlp_yaml["activation"].as<string>(),
+                             actor_mlp_yaml["precision"]
+                               ? actor_mlp_yaml["precision"].as<string>()
+                               : "float32",
+                             actor_mlp_yaml["backend"]
+                               ? actor_mlp_yaml["backend"].as<string>()
+                               : "torch"};
   const auto& actor_distribution_yaml = train_config["actor"]["distribution"];
   const DistributionCfg actor_distribution_cfg{
     actor_distribution_yaml["init_noise_std"].as<float>(),
@@ -78,10 +113,63 @@ inline const CfgPointer load_config(const string& task, const bool& play) {
   const auto& critic_mlp_yaml = train_config["critic"]["mlp"];
   const MLPCfg critic_mlp_cfg{critic_mlp_yaml["width"].as<unsigned int>(),
                               critic_mlp_yaml["depth"].as<unsigned int>(),
-                              critic_mlp_yaml["activation"].as<string>()};
+                              critic_mlp_yaml["activation"].as<string>(),
+                              critic_mlp_yaml["precision"]
+                                ? critic_mlp_yaml["precision"].as<string>()
+                                : "float32",
+                              critic_mlp_yaml["backend"]
+                                ? critic_mlp_yaml["backend"].as<string>()
+                                : "torch"};
   const CriticCfg critic_cfg{critic_normalizer_cfg, critic_mlp_cfg};
 
-  return std::make_shared<Cfg>(env_cfg, runner_cfg, ppo_cfg, actor_cfg, critic_cfg);
+  // IMPALA Configuration
+  const auto& impala_yaml = train_config["impala"];
+  const ImpalaCfg impala_cfg =
+    impala_yaml ? ImpalaCfg{impala_yaml["num_actors"].as<unsigned int>(),
+                            impala_yaml["queue_size"].as<unsigned int>(),
+                            impala_yaml["rho_clip"].as<float>(), impala_yaml["c_clip"].as<float>()}
+                : ImpalaCfg();
+
+  // Policy Server Configuration
+  const auto& server_yaml = play_config["server"];
+  const ServerCfg server_cfg =
+    server_yaml ? ServerCfg{server_yaml["socket_path"].as<string>(),
+                            server_yaml["max_batch_size"].as<unsigned int>(),
+                            server_yaml["max_wait_us"].as<unsigned int>(),
+                            server_yaml["reload_interval"].as<float>(),
+                            server_yaml["report_interval"].as<float>()}
+                : ServerCfg();
+
+  // Quantization Configuration
+  const auto& quantization_yaml = play_config["quantization"];
+  const QuantizationCfg quantization_cfg =
+    quantization_yaml ? QuantizationCfg{quantization_yaml["num_episodes"].as<unsigned int>(),
+                                        quantization_yaml["max_action_error"].as<float>(),
+                                        quantization_yaml["max_return_drop"].as<float>()}
+                      : QuantizationCfg();
+
+  return std::make_shared<Cfg>(env_cfg, runner_cfg, ppo_cfg, actor_cfg, critic_cfg,
+                               distributed_cfg, impala_cfg, server_cfg, quantization_cfg);
+}
+
+inline const CfgPointer load_config(const string& task, const bool& play,
+                                    const unsigned int& rank = 0) {
+  const string task_path = "data/" + task;
+  int last_train_run_id = utils::last_run_id(task_path);
+  const string last_train_run_path = task_path + "/run_" + std::to_string(last_train_run_id);
+
+  const string train_config_path = play ? last_train_run_path + "/config.yaml" : "yaml/train.yaml";
+  const string play_config_path = "yaml/play.yaml";
+
+  YAML::Node train_config = YAML::LoadFile(train_config_path);
+  YAML::Node play_config = YAML::LoadFile(play_config_path);
+
+  int play_run_id = play_config["run_id"].as<int>();
+
+  play_run_id = play_run_id < 0 ? last_train_run_id : play_run_id;
+
+  return load_config(task, train_config, play_config, play,
+                     play ? play_run_id : last_train_run_id, rank);
 }
 
-}  // namespace configs
\ No newline at end of file
+}  // namespace configs
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <sys/types.h>
+#include <torch/torch.h>
+
+#include <vector>
+
+#ifdef USE_C10D_GLOO
+#include <torch/csrc/distributed/c10d/Backend.hpp>
+#endif
+
+#include "configs/configs.h"
+#include "utils/types.h"
+
+namespace distributed {
+
+// Forks world_size - 1 worker processes, must run before libtorch spins up its thread pools.
+// Rank 0 owns the workers: destroyed before join(), e.g. by an exception, it terminates and reaps
+// them instead of leaving them blocked in a collective.
+class WorkerGroup {
+ public:
+  explicit WorkerGroup(const unsigned int& world_size);
+  ~WorkerGroup();
+
+  WorkerGroup(const WorkerGroup&) = delete;
+  WorkerGroup& operator=(const WorkerGroup&) = delete;
+
+  // Waits for every worker to exit
+  void join();
+  unsigned int get_rank() const { return this->rank_; }
+
+ private:
+  unsigned int rank_ = 0;
+  std::vector<pid_t> workers_;
+};
+
+// Gloo process group over localhost, rank 0 hosts the rendezvous store
+class ProcessGroup {
+ public:
+  explicit ProcessGroup(const configs::DistributedCfg& cfg);
+
+  void all_reduce(Tensor& tensor) const;
+  void broadcast(Tensor& tensor, const unsigned int& root = 0) const;
+  void barrier() const;
+  const AllReduceFn get_all_reduce() const {
+    return [this](Tensor& tensor) { this->all_reduce(tensor); };
+  }
+  unsigned int get_rank() const { return this->rank_; }
+  unsigned int get_world_size() const { return this->world_size_; }
+  bool is_main() const { return this->rank_ == 0; }
+
+ private:
+  const unsigned int rank_;
+  const unsigned int world_size_;
+#ifdef USE_C10D_GLOO
+  c10::intrusive_ptr<c10d::Store> store_;
+  c10::intrusive_ptr<c10d::Backend> backend_;
+#endif
+};
+
+using ProcessGroupPointer = std::shared_ptr<ProcessGroup>;
+}  // namespace distributed
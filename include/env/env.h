@@ -3,6 +3,8 @@
 #include <torch/torch.h>
 
 #include "configs/configs.h"
+#include "utils/memory.h"
+#include "utils/script.h"
 #include "utils/types.h"
 
 namespace env {
@@ -14,6 +16,12 @@ struct Results {
   Tensor terminated;
   Tensor truncated;
   DictTensor info;
+
+  int64_t memory_bytes() const {
+    return utils::tensor_bytes(this->actor_obs) + utils::tensor_bytes(this->critic_obs) +
+           utils::tensor_bytes(this->rewards) + utils::tensor_bytes(this->terminated) +
+           utils::tensor_bytes(this->truncated) + utils::tensor_bytes(this->info);
+  }
 };
 
 class Env {
@@ -45,6 +53,15 @@ class Env {
     return torch::full((this->get_action_size()), POS_INF_F, this->device_);
   }
   virtual const Tensor sample_action() const = 0;
+  // Per-env state, the results tensors are owned by the caller
+  int64_t memory_bytes() const {
+    return utils::tensor_bytes(this->state_) + utils::tensor_bytes(this->iteration_) +
+           utils::tensor_bytes(this->all_indices_);
+  }
+  // Same before initialize(), which already writes the render files
+  int64_t predicted_memory_bytes() const {
+    return this->cfg_.num_envs * ((this->get_state_size_() + 1) * sizeof(float) + sizeof(bool));
+  }
   virtual void update_render_trajectory(const Results& results) const = 0;
   virtual void render() const = 0;
 
@@ -61,10 +78,19 @@ class Env {
 
   void step(Results& results, const Tensor& action) {
     this->iteration_ += 1;
+    if (this->step_unit_) return this->scripted_step_(results, action);
     this->update_state_(action);
     this->update_results_(results);
   }
 
+  // Runs the dynamics, observations and rewards of every step as one TorchScript graph
+  void enable_scripted_step() {
+    const string source = this->step_script_();
+    if (source.empty())
+      throw std::invalid_argument("Scripted step is not supported by " + this->task_name_());
+    this->step_unit_ = utils::compile_script(source);
+  }
+
  protected:
   virtual unsigned int get_state_size_() const = 0;
   virtual void reset_state_(const int& num_resets, const Tensor& indices) = 0;
@@ -93,12 +119,33 @@ class Env {
   virtual void initialize_render_() = 0;
   virtual string task_name_() const = 0;
 
+  // TorchScript source defining step(state, action, iteration) -> (state, actor_obs, critic_obs,
+  // rewards, terminated, truncated, applied_action), empty when the task cannot be scripted
+  virtual string step_script_() const { return ""; }
+  virtual void update_applied_action_(const Tensor& applied_action) { return; }
+  void scripted_step_(Results& results, const Tensor& action) {
+    // Fusion is decided when the profiling executor optimizes the graph during the first runs
+    const utils::FuserGuard fuser_guard;
+    const auto& outputs =
+      this->step_unit_->run_method("step", this->state_, action, this->iteration_).toTuple();
+    // Outputs land in the fixed state and results buffers
+    this->state_.copy_(outputs->elements()[0].toTensor());
+    results.actor_obs.copy_(outputs->elements()[1].toTensor());
+    results.critic_obs.copy_(outputs->elements()[2].toTensor());
+    results.rewards.copy_(outputs->elements()[3].toTensor());
+    results.terminated.copy_(outputs->elements()[4].toTensor());
+    results.truncated.copy_(outputs->elements()[5].toTensor());
+    this->update_applied_action_(outputs->elements()[6].toTensor());
+    this->update_info_(results);
+  }
+
   const configs::EnvCfg cfg_;
   const Device device_;
   Tensor iteration_;
   Tensor state_;
   const Tensor all_indices_;
   unsigned int max_iterations_;
+  utils::CompilationUnitPointer step_unit_;
 };
 
 using EnvPointer = std::unique_ptr<Env>;
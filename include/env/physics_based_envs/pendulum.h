@@ -36,6 +36,11 @@ class PendulumEnv : public PhysicsBasedEnv {
   void update_critic_obs_(Results& results) override;
   void update_rewards_(Results& results) override;
 
+  string model_script_() const override;
+  void update_applied_action_(const Tensor& applied_action) override {
+    this->applied_torque_.copy_(applied_action);
+  }
+
   void initialize_render_() override;
   string task_name_() const override { return "pendulum"; }
 
@@ -37,6 +37,11 @@ class PendulumCartEnv : public PhysicsBasedEnv {
   void update_rewards_(Results& results) override;
   void update_terminated_(Results& results) override;
 
+  string model_script_() const override;
+  void update_applied_action_(const Tensor& applied_action) override {
+    this->applied_force_.copy_(applied_action);
+  }
+
   void initialize_render_() override;
   string task_name_() const override { return "pendulum_cart"; }
 
@@ -36,6 +36,48 @@ class PhysicsBasedEnv : public Env {
     this->state_.add_(this->dt_ / 6. * (k1 + 2. * k2 + 2. * k3 + k4));
   }
 
+  // TorchScript source of the task model, empty when the task cannot be scripted:
+  //   actuate(action) -> applied_action
+  //   dynamics(state, applied_action) -> state derivative
+  //   constrain(state) -> state
+  //   observe(state, applied_action) -> (actor_obs, critic_obs, terminated, rewards)
+  virtual string model_script_() const { return ""; }
+
+  // Integrator and truncation wrapped around the task model, mirroring the eager step
+  string step_script_() const override {
+    const string model = this->model_script_();
+    if (model.empty()) return "";
+
+    const string dt = utils::script_literal(this->dt_);
+    string integrate;
+    if (this->cfg_.integrator == "euler")
+      integrate = "    state = state + " + dt + " * dynamics(state, applied_action)\n";
+    else if (this->cfg_.integrator == "rk2")
+      integrate = "    k1 = dynamics(state, applied_action)\n"
+                  "    k2 = dynamics(state + " + dt + " * k1, applied_action)\n"
+                  "    state = state + 0.5 * " + dt + " * (k1 + k2)\n";
+    else if (this->cfg_.integrator == "rk4")
+      integrate = "    k1 = dynamics(state, applied_action)\n"
+                  "    k2 = dynamics(state + 0.5 * " + dt + " * k1, applied_action)\n"
+                  "    k3 = dynamics(state + 0.5 * " + dt + " * k2, applied_action)\n"
+                  "    k4 = dynamics(state + " + dt + " * k3, applied_action)\n"
+                  "    state = state + " + dt + " / 6.0 * (k1 + 2.0 * k2 + 2.0 * k3 + k4)\n";
+    else
+      throw std::invalid_argument("Invalid integrator: " + this->cfg_.integrator);
+
+    return model +
+           "\n"
+           "def step(state: Tensor, action: Tensor, iteration: Tensor) -> Tuple[Tensor, Tensor, "
+           "Tensor, Tensor, Tensor, Tensor, Tensor]:\n"
+           "    applied_action = actuate(action)\n" +
+           integrate +
+           "    state = constrain(state)\n"
+           "    actor_obs, critic_obs, terminated, rewards = observe(state, applied_action)\n"
+           "    truncated = iteration >= " + utils::script_literal(this->max_iterations_) + "\n"
+           "    return state, actor_obs, critic_obs, rewards, terminated, truncated, "
+           "applied_action\n";
+  }
+
   float dt_;
 };
 
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "configs/configs.h"
+#include "modules/actor_critic.h"
+#include "policy_file.h"
+#include "utils/types.h"
+
+namespace inference {
+
+// Snapshot of the deterministic actor (normalizer, MLP and distribution) for PolicyEvaluator
+const PolicyFile to_policy_file(const modules::ActorCritic& actor_critic,
+                                const configs::ActorCfg& actor_cfg);
+
+// Writes the actor to path and returns the cmake flags building cpp_rl_infer for it
+const string export_policy(const modules::ActorCritic& actor_critic,
+                           const configs::ActorCfg& actor_cfg, const string& path);
+
+}  // namespace inference
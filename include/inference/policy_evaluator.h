@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "policy_file.h"
+
+namespace inference {
+
+// Deterministic actor (normalizer, MLP and distribution mode) with the layer sizes and the
+// activation fixed at compile time. Header-only and free of libtorch; act() never allocates.
+// Sizes are {num_obs, hidden..., num_actions}, as printed by the export mode. The parameters
+// live inline, so allocate evaluators once (see create) and reuse them.
+template <Activation A, size_t... Sizes>
+class PolicyEvaluator {
+  static_assert(sizeof...(Sizes) >= 2, "At least the input and output sizes are required");
+
+  static constexpr size_t kNumLayers = sizeof...(Sizes) - 1;
+  static constexpr std::array<size_t, sizeof...(Sizes)> kSizes{Sizes...};
+
+  static constexpr size_t offset_(const size_t& layer) {
+    size_t offset = 0;
+    for (size_t i = 0; i < layer; ++i) offset += kSizes[i] * kSizes[i + 1] + kSizes[i + 1];
+    return offset;
+  }
+  static constexpr size_t max_width_() {
+    size_t width = 0;
+    for (const size_t& size : kSizes) width = std::max(width, size);
+    return width;
+  }
+
+ public:
+  static constexpr size_t kNumInputs = kSizes.front();
+  static constexpr size_t kNumActions = kSizes.back();
+
+  static std::unique_ptr<PolicyEvaluator> create(const std::string& path) {
+    auto evaluator = std::make_unique<PolicyEvaluator>();
+    evaluator->load(PolicyFile::load(path));
+    return evaluator;
+  }
+
+  void load(const PolicyFile& policy) {
+    if (policy.activation != A)
+      throw std::invalid_argument("Policy activation is " +
+                                  std::string(activation_name(policy.activation)));
+    if (!std::equal(policy.sizes.begin(), policy.sizes.end(), kSizes.begin(), kSizes.end()))
+      throw std::invalid_argument("Policy layer sizes do not match the evaluator");
+
+    this->distribution_ = policy.distribution;
+    for (size_t i = 0; i < kNumInputs; ++i) {
+      // Folded into one multiply-add: (x - mean) / (std + eps)
+      this->scale_[i] =
+        policy.normalize ? 1.f / (std::sqrt(policy.var[i]) + std::numeric_limits<float>::epsilon())
+                         : 1.f;
+      this->shift_[i] = policy.normalize ? -policy.mean[i] * this->scale_[i] : 0.f;
+    }
+
+    // Weights are stored transposed (in x out) so the inner loop runs over contiguous outputs
+    for (size_t layer = 0; layer < kNumLayers; ++layer) {
+      const size_t in = kSizes[layer];
+      const size_t out = kSizes[layer + 1];
+      float* weight_t = this->parameters_.data() + offset_(layer);
+      for (size_t o = 0; o < out; ++o)
+        for (size_t k = 0; k < in; ++k) weight_t[k * out + o] = policy.weights[layer][o * in + k];
+      std::copy(policy.biases[layer].begin(), policy.biases[layer].end(), weight_t + in * out);
+    }
+
+    std::copy(policy.std.begin(), policy.std.end(), this->std_.begin());
+    std::copy(policy.action_min.begin(), policy.action_min.end(), this->action_min_.begin());
+    std::copy(policy.action_max.begin(), policy.action_max.end(), this->action_max_.begin());
+  }
+
+  // actions[kNumActions] = mode of the policy distribution for observations[kNumInputs]
+  void act(const float* observations, float* actions) const {
+    std::array<std::array<float, kWidth>, 2> buffers;
+    for (size_t i = 0; i < kNumInputs; ++i)
+      buffers[0][i] = observations[i] * this->scale_[i] + this->shift_[i];
+    this->forward_(buffers, std::make_index_sequence<kNumLayers>{});
+
+    const float* outputs = buffers[kNumLayers % 2].data();
+    if (this->distribution_ == Distribution::Normal) {
+      std::copy(outputs, outputs + kNumActions, actions);
+      return;
+    }
+    for (size_t i = 0; i < kNumActions; ++i)
+      actions[i] = beta_mode(outputs[i], this->std_[i], this->action_min_[i], this->action_max_[i]);
+  }
+
+ private:
+  static constexpr size_t kWidth = max_width_();
+
+  template <size_t... Layers>
+  void forward_(std::array<std::array<float, kWidth>, 2>& buffers,
+                std::index_sequence<Layers...>) const {
+    (this->layer_<Layers>(buffers[Layers % 2].data(), buffers[(Layers + 1) % 2].data()), ...);
+  }
+
+  template <size_t Layer>
+  void layer_(const float* x, float* y) const {
+    constexpr size_t in = kSizes[Layer];
+    constexpr size_t out = kSizes[Layer + 1];
+    const float* weight_t = this->parameters_.data() + offset_(Layer);
+    const float* bias = weight_t + in * out;
+
+    std::array<float, out> accumulator;
+    std::copy(bias, bias + out, accumulator.begin());
+    for (size_t k = 0; k < in; ++k) {
+      const float value = x[k];
+      const float* w = weight_t + k * out;
+      for (size_t o = 0; o < out; ++o) accumulator[o] += value * w[o];
+    }
+
+    if constexpr (Layer + 1 == kNumLayers)
+      std::copy(accumulator.begin(), accumulator.end(), y);
+    else
+      for (size_t o = 0; o < out; ++o) y[o] = activate_(accumulator[o]);
+  }
+
+  static float activate_(const float& value) {
+    if constexpr (A == Activation::ELU)
+      return value > 0.f ? value : std::expm1(value);
+    else if constexpr (A == Activation::ReLU)
+      return value > 0.f ? value : 0.f;
+    else if constexpr (A == Activation::Tanh)
+      return std::tanh(value);
+    else
+      return 1.f / (1.f + std::exp(-value));
+  }
+
+  std::array<float, offset_(kNumLayers)> parameters_{};
+  std::array<float, kNumInputs> scale_{};
+  std::array<float, kNumInputs> shift_{};
+  std::array<float, kNumActions> std_{};
+  std::array<float, kNumActions> action_min_{};
+  std::array<float, kNumActions> action_max_{};
+  Distribution distribution_ = Distribution::Normal;
+};
+
+}  // namespace inference
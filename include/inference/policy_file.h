@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Flat binary description of a trained actor, readable without libtorch.
+// Layout (native endianness, every field 32 bits):
+//   magic "CPPRLPOL", version, activation, distribution, normalize, num_layers,
+//   sizes[num_layers + 1], mean[sizes[0]], var[sizes[0]],
+//   for every layer: weight[out * in] (row-major, out x in), bias[out],
+//   std[num_actions], action_min[num_actions], action_max[num_actions]
+namespace inference {
+
+enum class Activation : uint32_t { ELU = 0, ReLU = 1, Tanh = 2, Sigmoid = 3 };
+enum class Distribution : uint32_t { Normal = 0, Beta = 1 };
+
+constexpr char kPolicyMagic[8] = {'C', 'P', 'P', 'R', 'L', 'P', 'O', 'L'};
+constexpr uint32_t kPolicyVersion = 1;
+constexpr uint32_t kMaxLayers = 64;
+
+constexpr Activation to_activation(const std::string_view& name) {
+  if (name == "elu") return Activation::ELU;
+  if (name == "relu") return Activation::ReLU;
+  if (name == "tanh") return Activation::Tanh;
+  if (name == "sigmoid") return Activation::Sigmoid;
+  throw std::invalid_argument("Invalid activation function");
+}
+
+constexpr std::string_view activation_name(const Activation& activation) {
+  switch (activation) {
+    case Activation::ELU:
+      return "elu";
+    case Activation::ReLU:
+      return "relu";
+    case Activation::Tanh:
+      return "tanh";
+    default:
+      return "sigmoid";
+  }
+}
+
+// Raw native-endian I/O shared by the policy file formats
+template <typename T>
+inline void write_binary(std::ofstream& file, const T& value) {
+  file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+template <typename T>
+inline void write_binary(std::ofstream& file, const std::vector<T>& values) {
+  file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+template <typename T>
+inline T read_binary(std::ifstream& file) {
+  T value{};
+  file.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return value;
+}
+template <typename T>
+inline std::vector<T> read_binary(std::ifstream& file, const size_t& size) {
+  std::vector<T> values(size);
+  file.read(reinterpret_cast<char*>(values.data()), size * sizeof(T));
+  return values;
+}
+
+// Mode of the beta distribution for one network output, mirrors Beta::update and Beta::get_mode
+inline float beta_mode(const float& output, const float& std, const float& min, const float& max) {
+  const float mean = std::clamp(output, min, max);
+  const float var = std * std;
+  const float total = (min * max - (min + max) * mean + mean * mean + var) / var / (max - min);
+  const float alpha = (min - mean) * total;
+  const float beta = (mean - max) * total;
+  return min + (max - min) * (alpha - 1.f) / (alpha + beta - 2.f);
+}
+
+struct PolicyFile {
+  Activation activation = Activation::ELU;
+  Distribution distribution = Distribution::Normal;
+  bool normalize = false;
+  std::vector<uint32_t> sizes;
+  std::vector<float> mean;
+  std::vector<float> var;
+  std::vector<std::vector<float>> weights;
+  std::vector<std::vector<float>> biases;
+  std::vector<float> std;
+  std::vector<float> action_min;
+  std::vector<float> action_max;
+
+  // Bytes taken by the normalizer, weights and biases
+  size_t num_bytes() const {
+    size_t num_floats = this->mean.size() + this->var.size();
+    for (size_t i = 0; i < this->weights.size(); ++i)
+      num_floats += this->weights[i].size() + this->biases[i].size();
+    return num_floats * sizeof(float);
+  }
+
+  void save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Cannot open " + path);
+    file.write(kPolicyMagic, sizeof(kPolicyMagic));
+    write_binary(file, kPolicyVersion);
+    write_binary(file, static_cast<uint32_t>(this->activation));
+    write_binary(file, static_cast<uint32_t>(this->distribution));
+    write_binary(file, static_cast<uint32_t>(this->normalize));
+    write_binary(file, static_cast<uint32_t>(this->weights.size()));
+    write_binary(file, this->sizes);
+    write_binary(file, this->mean);
+    write_binary(file, this->var);
+    for (size_t i = 0; i < this->weights.size(); ++i) {
+      write_binary(file, this->weights[i]);
+      write_binary(file, this->biases[i]);
+    }
+    write_binary(file, this->std);
+    write_binary(file, this->action_min);
+    write_binary(file, this->action_max);
+    if (!file) throw std::runtime_error("Cannot write " + path);
+  }
+
+  static PolicyFile load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Cannot open " + path);
+    char magic[sizeof(kPolicyMagic)];
+    file.read(magic, sizeof(magic));
+    if (!file || std::memcmp(magic, kPolicyMagic, sizeof(magic)) != 0)
+      throw std::runtime_error(path + " is not a policy file");
+    if (read_binary<uint32_t>(file) != kPolicyVersion)
+      throw std::runtime_error("Unsupported policy file version in " + path);
+
+    PolicyFile policy;
+    policy.activation = static_cast<Activation>(read_binary<uint32_t>(file));
+    policy.distribution = static_cast<Distribution>(read_binary<uint32_t>(file));
+    policy.normalize = read_binary<uint32_t>(file) != 0;
+    const uint32_t num_layers = read_binary<uint32_t>(file);
+    if (!file || num_layers == 0 || num_layers > kMaxLayers)
+      throw std::runtime_error("Invalid number of layers in " + path);
+    policy.sizes = read_binary<uint32_t>(file, num_layers + 1);
+    policy.mean = read_binary<float>(file, policy.sizes.front());
+    policy.var = read_binary<float>(file, policy.sizes.front());
+    for (uint32_t i = 0; i < num_layers; ++i) {
+      policy.weights.push_back(read_binary<float>(file, policy.sizes[i + 1] * policy.sizes[i]));
+      policy.biases.push_back(read_binary<float>(file, policy.sizes[i + 1]));
+    }
+    policy.std = read_binary<float>(file, policy.sizes.back());
+    policy.action_min = read_binary<float>(file, policy.sizes.back());
+    policy.action_max = read_binary<float>(file, policy.sizes.back());
+    if (!file) throw std::runtime_error("Truncated policy file " + path);
+    return policy;
+  }
+};
+
+}  // namespace inference
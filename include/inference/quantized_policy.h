@@ -0,0 +1,296 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "policy_file.h"
+
+// Int8 post-training quantization of an exported actor, readable without libtorch.
+// Weights are symmetric int8 per output channel, layer inputs are asymmetric uint8 per tensor
+// with ranges calibrated from recorded observations. The empirical normalizer stays in float and
+// runs before the first layer: normalized features share a range, so a single input scale does not
+// crush the features with a small spread.
+namespace inference {
+
+constexpr char kQuantizedPolicyMagic[8] = {'C', 'P', 'P', 'R', 'L', 'I', 'N', '8'};
+constexpr uint32_t kQuantizedPolicyVersion = 2;
+
+struct QuantizedLayer {
+  uint32_t in = 0;
+  uint32_t out = 0;
+  float input_scale = 1.f;
+  int32_t input_zero_point = 0;
+  std::vector<float> weight_scales;
+  std::vector<int8_t> weights;
+  std::vector<float> biases;
+  // Sum of every weight row, removes the input zero point from the int32 accumulators
+  std::vector<int32_t> weight_sums;
+
+  void update_weight_sums() {
+    this->weight_sums.assign(this->out, 0);
+    for (uint32_t o = 0; o < this->out; ++o)
+      for (uint32_t k = 0; k < this->in; ++k)
+        this->weight_sums[o] += this->weights[o * this->in + k];
+  }
+};
+
+class QuantizedPolicy {
+ public:
+  // observations holds num_observations x sizes[0] raw (unnormalized) observations
+  static QuantizedPolicy calibrate(const PolicyFile& policy,
+                                   const std::vector<float>& observations) {
+    const size_t num_inputs = policy.sizes.front();
+    if (observations.empty() || observations.size() % num_inputs != 0)
+      throw std::invalid_argument("Calibration needs whole observations");
+    const size_t num_observations = observations.size() / num_inputs;
+    const size_t num_layers = policy.weights.size();
+    const std::vector<std::vector<float>>& weights = policy.weights;
+    const std::vector<std::vector<float>>& biases = policy.biases;
+
+    QuantizedPolicy quantized;
+    if (policy.normalize) {
+      quantized.mean_ = policy.mean;
+      quantized.inverse_std_.resize(num_inputs);
+      for (size_t k = 0; k < num_inputs; ++k)
+        quantized.inverse_std_[k] =
+          1.f / (std::sqrt(policy.var[k]) + std::numeric_limits<float>::epsilon());
+    }
+
+    // Input range of every layer over the calibration set, always including zero
+    std::vector<float> minimums(num_layers, 0.f);
+    std::vector<float> maximums(num_layers, 0.f);
+    std::vector<float> x;
+    std::vector<float> y;
+    for (size_t n = 0; n < num_observations; ++n) {
+      x.assign(observations.begin() + n * num_inputs, observations.begin() + (n + 1) * num_inputs);
+      quantized.normalize_(x.data(), x.data(), num_inputs);
+      for (size_t l = 0; l < num_layers; ++l) {
+        const auto& [minimum, maximum] = std::minmax_element(x.begin(), x.end());
+        minimums[l] = std::min(minimums[l], *minimum);
+        maximums[l] = std::max(maximums[l], *maximum);
+        linear_(weights[l], biases[l], x, y);
+        if (l + 1 < num_layers)
+          for (float& value : y) value = activate_(policy.activation, value);
+        std::swap(x, y);
+      }
+    }
+
+    quantized.activation_ = policy.activation;
+    quantized.distribution_ = policy.distribution;
+    quantized.std_ = policy.std;
+    quantized.action_min_ = policy.action_min;
+    quantized.action_max_ = policy.action_max;
+    for (size_t l = 0; l < num_layers; ++l) {
+      QuantizedLayer layer;
+      layer.in = policy.sizes[l];
+      layer.out = policy.sizes[l + 1];
+      layer.input_scale = std::max(maximums[l] - minimums[l], 1e-8f) / 255.f;
+      layer.input_zero_point = static_cast<int32_t>(
+        std::clamp(std::round(-minimums[l] / layer.input_scale), 0.f, 255.f));
+      layer.biases = biases[l];
+      layer.weights.resize(layer.out * layer.in);
+      layer.weight_scales.resize(layer.out);
+      for (uint32_t o = 0; o < layer.out; ++o) {
+        const float* row = weights[l].data() + o * layer.in;
+        float max_abs = 0.f;
+        for (uint32_t k = 0; k < layer.in; ++k) max_abs = std::max(max_abs, std::abs(row[k]));
+        layer.weight_scales[o] = max_abs > 0.f ? max_abs / 127.f : 1.f;
+        for (uint32_t k = 0; k < layer.in; ++k)
+          layer.weights[o * layer.in + k] = static_cast<int8_t>(
+            std::clamp(std::round(row[k] / layer.weight_scales[o]), -127.f, 127.f));
+      }
+      layer.update_weight_sums();
+      quantized.layers_.push_back(std::move(layer));
+    }
+    return quantized;
+  }
+
+  // Mode of the policy for batch_size observations, both buffers are row-major. Not thread-safe:
+  // the scratch buffers are shared, concurrent callers need one policy each.
+  void act(const float* observations, float* actions, const size_t& batch_size = 1) {
+    const size_t num_inputs = this->layers_.front().in;
+    const size_t num_actions = this->layers_.back().out;
+    this->normalized_.resize(num_inputs);
+    for (size_t n = 0; n < batch_size; ++n) {
+      const float* x = observations + n * num_inputs;
+      if (!this->mean_.empty()) {
+        this->normalize_(x, this->normalized_.data(), num_inputs);
+        x = this->normalized_.data();
+      }
+      for (size_t l = 0; l < this->layers_.size(); ++l) {
+        const QuantizedLayer& layer = this->layers_[l];
+        this->quantize_(layer, x);
+        this->outputs_.resize(layer.out);
+        // Local pointers: 8-bit types may alias anything, members would be reloaded every iteration
+        const uint8_t* inputs = this->inputs_.data();
+        float* outputs = this->outputs_.data();
+        for (uint32_t o = 0; o < layer.out; ++o) {
+          const int8_t* row = layer.weights.data() + o * layer.in;
+          // uint8 x int8 products summed in int32, the pattern of the VNNI dot product instructions
+          int32_t accumulator = 0;
+          for (uint32_t k = 0; k < layer.in; ++k)
+            accumulator += static_cast<int32_t>(row[k]) * static_cast<int32_t>(inputs[k]);
+          outputs[o] = dequantize_(layer, o, accumulator);
+        }
+        if (l + 1 < this->layers_.size())
+          for (uint32_t o = 0; o < layer.out; ++o)
+            outputs[o] = activate_(this->activation_, outputs[o]);
+        x = outputs;
+      }
+
+      float* action = actions + n * num_actions;
+      for (size_t i = 0; i < num_actions; ++i)
+        action[i] = this->distribution_ == Distribution::Beta
+                      ? beta_mode(x[i], this->std_[i], this->action_min_[i], this->action_max_[i])
+                      : x[i];
+    }
+  }
+
+  uint32_t num_inputs() const { return this->layers_.front().in; }
+  uint32_t num_actions() const { return this->layers_.back().out; }
+
+  // Bytes taken by the weights, biases and quantization parameters
+  size_t num_bytes() const {
+    size_t bytes = 0;
+    for (const QuantizedLayer& layer : this->layers_)
+      bytes += layer.weights.size() * sizeof(int8_t) +
+               (layer.biases.size() + layer.weight_scales.size()) * sizeof(float) +
+               sizeof(layer.input_scale) + sizeof(layer.input_zero_point);
+    return bytes + (this->mean_.size() + this->inverse_std_.size()) * sizeof(float);
+  }
+
+  void save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Cannot open " + path);
+    file.write(kQuantizedPolicyMagic, sizeof(kQuantizedPolicyMagic));
+    write_binary(file, kQuantizedPolicyVersion);
+    write_binary(file, static_cast<uint32_t>(this->activation_));
+    write_binary(file, static_cast<uint32_t>(this->distribution_));
+    write_binary(file, static_cast<uint32_t>(this->layers_.size()));
+    for (const QuantizedLayer& layer : this->layers_) {
+      write_binary(file, layer.in);
+      write_binary(file, layer.out);
+      write_binary(file, layer.input_scale);
+      write_binary(file, layer.input_zero_point);
+      write_binary(file, layer.weight_scales);
+      write_binary(file, layer.weights);
+      write_binary(file, layer.biases);
+    }
+    write_binary(file, this->std_);
+    write_binary(file, this->action_min_);
+    write_binary(file, this->action_max_);
+    write_binary(file, static_cast<uint32_t>(!this->mean_.empty()));
+    write_binary(file, this->mean_);
+    write_binary(file, this->inverse_std_);
+    if (!file) throw std::runtime_error("Cannot write " + path);
+  }
+
+  static QuantizedPolicy load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Cannot open " + path);
+    char magic[sizeof(kQuantizedPolicyMagic)];
+    file.read(magic, sizeof(magic));
+    if (!file || std::memcmp(magic, kQuantizedPolicyMagic, sizeof(magic)) != 0)
+      throw std::runtime_error(path + " is not a quantized policy file");
+    if (read_binary<uint32_t>(file) != kQuantizedPolicyVersion)
+      throw std::runtime_error("Unsupported quantized policy file version in " + path);
+
+    QuantizedPolicy quantized;
+    quantized.activation_ = static_cast<Activation>(read_binary<uint32_t>(file));
+    quantized.distribution_ = static_cast<Distribution>(read_binary<uint32_t>(file));
+    const uint32_t num_layers = read_binary<uint32_t>(file);
+    if (!file || num_layers == 0 || num_layers > kMaxLayers)
+      throw std::runtime_error("Invalid number of layers in " + path);
+    for (uint32_t l = 0; l < num_layers; ++l) {
+      QuantizedLayer layer;
+      layer.in = read_binary<uint32_t>(file);
+      layer.out = read_binary<uint32_t>(file);
+      layer.input_scale = read_binary<float>(file);
+      layer.input_zero_point = read_binary<int32_t>(file);
+      layer.weight_scales = read_binary<float>(file, layer.out);
+      layer.weights = read_binary<int8_t>(file, layer.out * layer.in);
+      layer.biases = read_binary<float>(file, layer.out);
+      layer.update_weight_sums();
+      quantized.layers_.push_back(std::move(layer));
+    }
+    const uint32_t num_actions = quantized.layers_.back().out;
+    quantized.std_ = read_binary<float>(file, num_actions);
+    quantized.action_min_ = read_binary<float>(file, num_actions);
+    quantized.action_max_ = read_binary<float>(file, num_actions);
+    if (read_binary<uint32_t>(file) != 0) {
+      const uint32_t num_inputs = quantized.layers_.front().in;
+      quantized.mean_ = read_binary<float>(file, num_inputs);
+      quantized.inverse_std_ = read_binary<float>(file, num_inputs);
+    }
+    if (!file) throw std::runtime_error("Truncated quantized policy file " + path);
+    return quantized;
+  }
+
+ private:
+  // (x - mean) / (std + eps) in float, a copy when the policy has no normalizer
+  void normalize_(const float* x, float* normalized, const size_t& num_inputs) const {
+    for (size_t k = 0; k < num_inputs; ++k)
+      normalized[k] =
+        this->mean_.empty() ? x[k] : (x[k] - this->mean_[k]) * this->inverse_std_[k];
+  }
+
+  void quantize_(const QuantizedLayer& layer, const float* x) {
+    this->inputs_.resize(layer.in);
+    uint8_t* inputs = this->inputs_.data();
+    const float inverse_scale = 1.f / layer.input_scale;
+    const float zero_point = static_cast<float>(layer.input_zero_point);
+    for (uint32_t k = 0; k < layer.in; ++k)
+      inputs[k] = static_cast<uint8_t>(
+        std::clamp(std::nearbyint(x[k] * inverse_scale) + zero_point, 0.f, 255.f));
+  }
+
+  static float dequantize_(const QuantizedLayer& layer, const uint32_t& o,
+                           const int32_t& accumulator) {
+    return layer.input_scale * layer.weight_scales[o] *
+             static_cast<float>(accumulator - layer.input_zero_point * layer.weight_sums[o]) +
+           layer.biases[o];
+  }
+
+  static void linear_(const std::vector<float>& weights, const std::vector<float>& biases,
+                      const std::vector<float>& x, std::vector<float>& y) {
+    y.assign(biases.begin(), biases.end());
+    for (size_t o = 0; o < y.size(); ++o)
+      for (size_t k = 0; k < x.size(); ++k) y[o] += weights[o * x.size() + k] * x[k];
+  }
+
+  static float activate_(const Activation& activation, const float& value) {
+    switch (activation) {
+      case Activation::ELU:
+        return value > 0.f ? value : std::expm1(value);
+      case Activation::ReLU:
+        return value > 0.f ? value : 0.f;
+      case Activation::Tanh:
+        return std::tanh(value);
+      default:
+        return 1.f / (1.f + std::exp(-value));
+    }
+  }
+
+  Activation activation_ = Activation::ELU;
+  Distribution distribution_ = Distribution::Normal;
+  std::vector<QuantizedLayer> layers_;
+  std::vector<float> std_;
+  std::vector<float> action_min_;
+  std::vector<float> action_max_;
+  // Empty without an empirical normalizer
+  std::vector<float> mean_;
+  std::vector<float> inverse_std_;
+  // Scratch buffers reused across calls
+  std::vector<float> normalized_;
+  std::vector<uint8_t> inputs_;
+  std::vector<float> outputs_;
+};
+
+}  // namespace inference
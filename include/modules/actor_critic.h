@@ -2,6 +2,7 @@
 
 #include "configs/configs.h"
 #include "distribution.h"
+#include "fused_mlp.h"
 #include "mlp.h"
 #include "normalizer.h"
 #include "utils/types.h"
@@ -12,8 +13,15 @@ class Actor : public NNModule {
  public:
   explicit Actor(const configs::ActorCfg& cfg);
 
-  const Tensor forward(const Tensor& actor_obs);
+  const Tensor forward(const Tensor& actor_obs) {
+    return this->forward_distribution(this->network_->forward(this->normalize(actor_obs)));
+  }
   const Tensor forward_inference(const Tensor& actor_obs);
+  const Tensor forward_distribution(const Tensor& network_outputs);
+  const Tensor normalize(const Tensor& actor_obs) { return this->normalizer_->forward(actor_obs); }
+  const NormalizerPointer& get_normalizer() const { return this->normalizer_; }
+  const MLPPointer& get_network() const { return this->network_; }
+  const DistributionPointer& get_distribution() const { return this->distribution_; }
   const Tensor& get_mean() const { return this->distribution_->get_mean(); }
   const Tensor& get_std() const { return this->distribution_->get_std(); }
   const Tensor get_log_prob(const Tensor& actions) const {
@@ -24,6 +32,13 @@ class Actor : public NNModule {
     return this->distribution_->get_kl(old_kl_params);
   }
   const DictTensor get_kl_params() const { return this->distribution_->get_kl_params(); }
+  const DistributionTerms get_terms(const Tensor& actions,
+                                    const DictTensor& old_kl_params = {}) const {
+    return this->distribution_->get_terms(actions, old_kl_params);
+  }
+  void update_normalizer(const Tensor& actor_obs, const AllReduceFn& all_reduce) {
+    this->normalizer_->update(actor_obs, all_reduce);
+  }
   void train();
   void eval();
 
@@ -39,7 +54,15 @@ class Critic : public NNModule {
   explicit Critic(const configs::CriticCfg& cfg);
 
   const Tensor forward(const Tensor& critic_obs) {
-    return this->network_->forward(this->normalizer_->forward(critic_obs));
+    return this->network_->forward(this->normalize(critic_obs));
+  }
+  const Tensor normalize(const Tensor& critic_obs) {
+    return this->normalizer_->forward(critic_obs);
+  }
+  const NormalizerPointer& get_normalizer() const { return this->normalizer_; }
+  const MLPPointer& get_network() const { return this->network_; }
+  void update_normalizer(const Tensor& critic_obs, const AllReduceFn& all_reduce) {
+    this->normalizer_->update(critic_obs, all_reduce);
   }
 
  private:
@@ -50,12 +73,19 @@ class Critic : public NNModule {
 using ActorPointer = std::shared_ptr<Actor>;
 using CriticPointer = std::shared_ptr<Critic>;
 
+// Parameters and buffers the actor needs for inference, by name prefix within an ActorCritic
+inline const std::vector<string> kInferencePrefixes{"actor.network.", "actor.normalizer.",
+                                                    "actor.distribution.std"};
+
 class ActorCritic : public NNModule {
  public:
-  ActorCritic(const configs::ActorCfg& actor_cfg, const configs::CriticCfg& critic_cfg);
+  ActorCritic(const configs::ActorCfg& actor_cfg, const configs::CriticCfg& critic_cfg,
+              const bool& fused = false);
 
   const Tensor forward(const Tensor& actor_obs) { return this->actor_->forward(actor_obs); }
   const Tensor evaluate(const Tensor& critic_obs) { return this->critic_->forward(critic_obs); }
+  // Actions and values in one pass, through the fused networks when enabled
+  const TensorTuple forward_evaluate(const Tensor& actor_obs, const Tensor& critic_obs);
   const Tensor& get_action_std() const { return this->actor_->get_std(); }
   const Tensor get_actions_log_prob(const Tensor& actions) const {
     return this->actor_->get_log_prob(actions).sum(/*dim=*/-1,
@@ -66,15 +96,34 @@ class ActorCritic : public NNModule {
     return this->actor_->get_kl(old_kl_params).sum(/*dim=*/-1);
   }
   const DictTensor get_distribution_kl_params() const { return this->actor_->get_kl_params(); }
+  // Log-probabilities, entropies and detached KL summed over the action dimensions like above
+  const DistributionTerms get_actions_terms(const Tensor& actions,
+                                            const DictTensor& old_kl_params = {}) const {
+    DistributionTerms terms = this->actor_->get_terms(actions, old_kl_params);
+    terms.log_prob = terms.log_prob.sum(/*dim=*/-1, /*keepdim=*/true);
+    terms.entropy = terms.entropy.sum(/*dim=*/-1);
+    if (terms.kl.defined()) terms.kl = terms.kl.sum(/*dim=*/-1);
+    return terms;
+  }
+  void update_normalizers(const Tensor& actor_obs, const Tensor& critic_obs,
+                          const AllReduceFn& all_reduce = nullptr) {
+    this->actor_->update_normalizer(actor_obs, all_reduce);
+    this->critic_->update_normalizer(critic_obs, all_reduce);
+  }
   const std::function<Tensor(const Tensor&)> get_inference_policy() const {
     return [this](const Tensor& actor_obs) { return this->actor_->forward_inference(actor_obs); };
   }
+  const ActorPointer& get_actor() const { return this->actor_; }
+  const CriticPointer& get_critic() const { return this->critic_; }
+  const ListTensor get_state() const;
+  void set_state(const ListTensor& state);
   void train() { this->actor_->train(); }
   void eval() { this->actor_->eval(); }
 
  private:
   ActorPointer actor_;
   CriticPointer critic_;
+  FusedMLPPointer fused_network_;
 };
 
 using ActorCriticPointer = std::unique_ptr<modules::ActorCritic>;
@@ -5,6 +5,35 @@
 
 namespace modules {
 
+// Log-probability of given actions, entropy and KL terms of the current distribution
+struct DistributionTerms {
+  Tensor log_prob;
+  Tensor entropy;
+  // Detached, undefined when no previous KL parameters were given
+  Tensor kl;
+  DictTensor kl_params;
+};
+
+// Tensor derived from the distribution parameters, computed at most once between two update()
+// calls. A value cached without autograd is recomputed when it is needed with autograd.
+class CachedTerm {
+ public:
+  template <typename Compute>
+  const Tensor& get(const Compute& compute) {
+    const bool grad_mode = torch::GradMode::is_enabled();
+    if (!this->value_.defined() || (grad_mode && !this->grad_mode_)) {
+      this->value_ = compute();
+      this->grad_mode_ = grad_mode;
+    }
+    return this->value_;
+  }
+  void clear() { this->value_ = Tensor(); }
+
+ private:
+  Tensor value_;
+  bool grad_mode_ = false;
+};
+
 class Distribution : public NNModule {
  public:
   Distribution(const configs::DistributionCfg& cfg)
@@ -25,6 +54,17 @@ class Distribution : public NNModule {
   virtual const Tensor get_entropy() const = 0;
   virtual const Tensor get_kl(const DictTensor& old_kl_params) const = 0;
   virtual const DictTensor get_kl_params() const = 0;
+  // Single query for the learner, the special-function terms are shared between the parts
+  const DistributionTerms get_terms(const Tensor& actions,
+                                    const DictTensor& old_kl_params = {}) const {
+    DistributionTerms terms{this->get_log_prob(actions), this->get_entropy(), Tensor(),
+                            this->get_kl_params()};
+    if (!old_kl_params.empty()) {
+      torch::NoGradGuard no_grad;
+      terms.kl = this->get_kl(old_kl_params);
+    }
+    return terms;
+  }
 
  protected:
   Tensor std_;
@@ -5,6 +5,12 @@
 
 namespace modules {
 
+// log Gamma(shape, 1) variates, batched Marsaglia-Tsang on any device. Shapes below one draw
+// Gamma(shape + 1) times U^(1/shape), in log space so that tiny shapes do not underflow.
+const Tensor sample_log_gamma(const Tensor& shape);
+// Beta(alpha, beta) variates written into output, X / (X + Y) of two gamma variates
+void sample_beta(const Tensor& alpha, const Tensor& beta, Tensor& output);
+
 class Beta : public Distribution {
  public:
   explicit Beta(const configs::DistributionCfg& cfg)
@@ -12,7 +18,8 @@ class Beta : public Distribution {
       alpha_(torch::ones({cfg.num_inputs})),
       beta_(torch::ones({cfg.num_inputs})),
       min_(cfg.action_min),
-      max_(cfg.action_max) {
+      max_(cfg.action_max),
+      log_range_(torch::log(cfg.action_max - cfg.action_min)) {
     this->register_buffer("alpha", this->alpha_);
     this->register_buffer("beta", this->beta_);
   }
@@ -20,10 +27,7 @@ class Beta : public Distribution {
   ~Beta() override = default;
 
   void update(const Tensor& hidden_output) override;
-  const Tensor sample() const override {
-    return this->scale_(
-      at::_sample_dirichlet(torch::stack({this->alpha_, this->beta_}, /*dim=*/-1)));
-  }
+  const Tensor sample() const override;
   const Tensor get_mode() const override {
     return this->scale_((this->alpha_ - 1.f) / (this->alpha_ + this->beta_ - 2.f));
   }
@@ -39,10 +43,21 @@ class Beta : public Distribution {
   const Tensor unscale_(const Tensor& actions) const {
     return (actions - this->min_) / (this->max_ - this->min_);
   }
+  // Special-function terms shared by get_log_prob, get_entropy and get_kl
+  const Tensor& log_beta_function_() const;
+  const Tensor& digamma_alpha_() const;
+  const Tensor& digamma_beta_() const;
+  const Tensor& digamma_total_() const;
+
   Tensor alpha_;
   Tensor beta_;
   const Tensor max_;
   const Tensor min_;
+  const Tensor log_range_;
+  mutable CachedTerm log_beta_function_cache_;
+  mutable CachedTerm digamma_alpha_cache_;
+  mutable CachedTerm digamma_beta_cache_;
+  mutable CachedTerm digamma_total_cache_;
 };
 
 }  // namespace modules
\ No newline at end of file
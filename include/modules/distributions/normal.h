@@ -14,22 +14,36 @@ class Normal : public Distribution {
 
   ~Normal() override = default;
 
-  void update(const Tensor& hidden_output) override { this->mean_ = hidden_output; }
+  void update(const Tensor& hidden_output) override {
+    this->mean_ = hidden_output;
+    this->var_cache_.clear();
+    this->log_normalizer_cache_.clear();
+  }
   const Tensor sample() const override {
     return at::normal(this->mean_, this->std_.expand_as(this->mean_));
   }
   const Tensor get_mode() const override { return this->mean_; }
   const Tensor get_log_prob(const Tensor& actions) const override {
-    const Tensor& var = this->std_.square();
-    return -0.5f * (torch::log(2.f * M_PI * var) + (actions - this->mean_).square() / var);
-  }
-  const Tensor get_entropy() const override {
-    return 0.5f * (1.f + torch::log(2.f * M_PI * this->std_.square()));
+    return -0.5f * (this->log_normalizer_() + (actions - this->mean_).square() / this->var_());
   }
+  const Tensor get_entropy() const override { return 0.5f * (1.f + this->log_normalizer_()); }
   const Tensor get_kl(const DictTensor& old_kl_params) const override;
   const DictTensor get_kl_params() const override {
     return {{"mean", this->mean_}, {"std", this->std_}};
   }
+
+ private:
+  const Tensor& var_() const {
+    return this->var_cache_.get([this] { return this->std_.square(); });
+  }
+  // log(2 pi var), shared by get_log_prob and get_entropy
+  const Tensor& log_normalizer_() const {
+    return this->log_normalizer_cache_.get(
+      [this] { return torch::log(2.f * M_PI * this->var_()); });
+  }
+
+  mutable CachedTerm var_cache_;
+  mutable CachedTerm log_normalizer_cache_;
 };
 
 }  // namespace modules
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <torch/torch.h>
+
+#include <utility>
+#include <vector>
+
+#include "mlp.h"
+#include "utils/types.h"
+
+namespace modules {
+
+// Evaluates two MLPs of equal depth and activation as one block-diagonal GEMM per layer.
+// The packed weights are cached for rollouts, with grad mode on the MLPs run separately.
+class FusedMLP {
+ public:
+  FusedMLP(const MLPPointer& first, const MLPPointer& second);
+
+  const TensorTuple forward(const Tensor& first_inputs, const Tensor& second_inputs);
+
+ private:
+  const Tensor forward_(const Tensor& inputs, const ListTensor& weights,
+                        const ListTensor& biases) const;
+  void pack_(ListTensor& weights, ListTensor& biases) const;
+  bool is_stale_() const;
+  void apply_activation_(Tensor& x) const;
+
+  const MLPPointer first_;
+  const MLPPointer second_;
+  const int64_t num_first_outputs_;
+  const int64_t num_second_outputs_;
+
+  ListTensor packed_weights_;
+  ListTensor packed_biases_;
+  // Storage and version of every source parameter when the cache was packed
+  std::vector<std::pair<const void*, int64_t>> packed_keys_;
+};
+
+using FusedMLPPointer = std::unique_ptr<FusedMLP>;
+}  // namespace modules
@@ -2,7 +2,10 @@
 
 #include <torch/torch.h>
 
+#include <vector>
+
 #include "configs/configs.h"
+#include "small_mlp.h"
 #include "utils/types.h"
 
 namespace modules {
@@ -11,11 +14,21 @@ class MLP : public NNModule {
  public:
   explicit MLP(const configs::MLPCfg& cfg);
 
-  const Tensor forward(const Tensor& x) { return this->network_->forward(x); }
+  const Tensor forward(const Tensor& x);
+  const std::vector<torch::nn::Linear>& get_layers() const { return this->layers_; }
+  const string& get_activation() const { return this->activation_; }
+  bool is_autocast() const { return this->autocast_; }
 
  private:
+  void add_linear_(const unsigned int& num_inputs, const unsigned int& num_outputs);
   void add_activation_(const string& activation);
   NN network_;
+  std::vector<torch::nn::Linear> layers_;
+  const string activation_;
+  // Layers run in bfloat16 with float32 master weights, outputs are returned in float32
+  bool autocast_ = false;
+  // Fused CPU kernels, float32 CPU inputs only
+  SmallMLPPointer native_;
 };
 
 using MLPPointer = std::shared_ptr<MLP>;
@@ -12,6 +12,7 @@ class Normalizer : public NNModule {
   ~Normalizer() = default;
 
   virtual const Tensor forward(const Tensor& observations) = 0;
+  virtual void update(const Tensor& observations, const AllReduceFn& all_reduce = nullptr) {}
   virtual const Tensor normalize(const Tensor& observations) const = 0;
   virtual const Tensor denormalize(const Tensor& observations) const = 0;
 
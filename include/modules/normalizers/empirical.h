@@ -17,7 +17,7 @@ class EmpiricalNormalizer : public Normalizer {
   }
 
   const Tensor forward(const Tensor& observations) override;
-  void update(const Tensor& observations);
+  void update(const Tensor& observations, const AllReduceFn& all_reduce = nullptr) override;
   const Tensor normalize(const Tensor& observations) const override;
   const Tensor denormalize(const Tensor& observations) const override;
 
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <torch/torch.h>
+
+#include "actor_critic.h"
+#include "configs/configs.h"
+#include "utils/script.h"
+#include "utils/types.h"
+
+namespace modules {
+
+struct PolicyStep {
+  Tensor actions;
+  Tensor values;
+  Tensor log_probs;
+  DictTensor kl_params;
+};
+
+// Rollout step of an ActorCritic (normalizers, MLPs, sampling and log-probabilities) compiled
+// into one TorchScript graph. The weights are graph inputs, so optimizer steps need no recompile.
+class ScriptedPolicy {
+ public:
+  ScriptedPolicy(const configs::ActorCfg& actor_cfg, const configs::CriticCfg& critic_cfg);
+
+  const PolicyStep forward(const ActorCritic& actor_critic, const Tensor& actor_obs,
+                           const Tensor& critic_obs) const;
+
+ private:
+  static const string normalizer_script_(const string& name, const configs::NormalizerCfg& cfg);
+  static const string network_script_(const string& name, const configs::MLPCfg& cfg);
+  static const string distribution_script_(const configs::DistributionCfg& cfg);
+  static const c10::List<Tensor> network_parameters_(const MLPPointer& network);
+
+  const string distribution_type_;
+  const Tensor action_min_;
+  const Tensor action_max_;
+  utils::CompilationUnitPointer unit_;
+};
+
+using ScriptedPolicyPointer = std::unique_ptr<ScriptedPolicy>;
+}  // namespace modules
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <torch/torch.h>
+
+#include <utility>
+#include <vector>
+
+#include "small_mlp_kernels.h"
+#include "utils/types.h"
+
+namespace modules {
+
+using AutogradContext = torch::autograd::AutogradContext;
+using VariableList = torch::autograd::variable_list;
+
+// Whole-network forward with the fused Linear+activation kernels as a single autograd node.
+// parameters holds [weight_0, bias_0, weight_1, bias_1, ...], weights_t their prepacked transposes.
+class SmallMLPFunction : public torch::autograd::Function<SmallMLPFunction> {
+ public:
+  static VariableList forward(AutogradContext* ctx, const Tensor& inputs,
+                              at::TensorList parameters, const ListTensor* weights_t,
+                              const int64_t& activation);
+  static VariableList backward(AutogradContext* ctx, VariableList grad_outputs);
+};
+
+// Native CPU backend of MLP for float32 inputs
+class SmallMLP {
+ public:
+  SmallMLP(const std::vector<torch::nn::Linear>& layers, const string& activation);
+
+  const Tensor forward(const Tensor& inputs);
+
+ private:
+  const Tensor forward_no_grad_(const Tensor& inputs);
+  void pack_();
+
+  const std::vector<torch::nn::Linear> layers_;
+  const kernels::Activation activation_;
+  ListTensor parameters_;
+  ListTensor weights_t_;
+  // Storage and version of every weight when it was packed
+  std::vector<std::pair<const void*, int64_t>> packed_keys_;
+  // Ping-pong hidden activations reused across no-grad calls
+  Tensor workspace_;
+  int64_t max_width_ = 0;
+};
+
+using SmallMLPPointer = std::unique_ptr<SmallMLP>;
+}  // namespace modules
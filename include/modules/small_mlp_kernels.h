@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+namespace modules {
+namespace kernels {
+
+enum class Activation : int64_t { Identity = 0, ReLU = 1, ELU = 2, Tanh = 3, Sigmoid = 4 };
+
+// Row-major float32 kernels for narrow Linear layers, torch-free so they can be tested in isolation
+
+// y[n, out] = activation(x[n, in] . weight_t[in, out] + bias[out])
+void linear_forward(const float* x, const float* weight_t, const float* bias, float* y,
+                    const int64_t& n, const int64_t& in, const int64_t& out,
+                    const Activation& activation);
+
+// grad[i] *= activation'(y[i]), the derivative is recovered from the activation output
+void activation_backward(const float* y, float* grad, const int64_t& size,
+                         const Activation& activation);
+
+// grad_weight[out, in] += grad_z^T . x, grad_bias[out] += sum(grad_z), and, when grad_x is not
+// null, grad_x[n, in] = grad_z . weight[out, in]
+void linear_backward(const float* x, const float* weight, const float* grad_z, float* grad_x,
+                     float* grad_weight, float* grad_bias, const int64_t& n, const int64_t& in,
+                     const int64_t& out);
+
+}  // namespace kernels
+}  // namespace modules
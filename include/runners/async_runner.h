@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "algorithms/impala.h"
+#include "configs/configs.h"
+#include "env/env.h"
+#include "live_metrics.h"
+#include "metrics.h"
+#include "metrics_logger.h"
+#include "modules/actor_critic.h"
+#include "on_policy_runner.h"
+#include "storage/checkpoint_manager.h"
+#include "storage/circular_buffer.h"
+#include "storage/lock_free_queue.h"
+#include "storage/observation_buffer.h"
+#include "storage/trajectory.h"
+#include "utils/types.h"
+
+namespace runners {
+
+// IMPALA-style runner: actor threads step their own env shard with the latest policy snapshot
+// and push trajectories to a lock-free queue, the learner consumes them without waiting for a
+// synchronous rollout.
+class AsyncRunner {
+ public:
+  AsyncRunner(const string& task, const configs::CfgPointer& cfg, const Device& device);
+  ~AsyncRunner() { this->stop_actors_(); }
+
+  void learn();
+  void save_models(const string& name, const bool& periodic = false) const;
+  void load_models(const string& name, const bool& load_optimizer = false);
+
+ private:
+  void update_cfg_();
+  void start_actors_();
+  void stop_actors_();
+  void actor_loop_(const unsigned int index);
+  storage::TrajectoryPointer pop_trajectory_();
+  void notify_(std::condition_variable& condition);
+  void set_phase_(const Phase& phase) {
+    if (this->live_metrics_) this->live_metrics_->set_phase(phase);
+  }
+
+  const configs::CfgPointer cfg_;
+  const string run_path_;
+  std::vector<configs::CfgPointer> actor_cfgs_;
+  std::vector<env::EnvPointer> envs_;
+  std::vector<storage::ObservationBufferPointer> observation_buffers_;
+  std::vector<modules::ActorCriticPointer> actor_critics_;
+  algorithms::IMPALAPointer train_algorithm_;
+  storage::LockFreeQueue<storage::TrajectoryPointer> queue_;
+  // Pushes and pops stay lock-free, the mutex only lets the learner sleep on an empty queue and
+  // the actors on a full one
+  std::mutex queue_mutex_;
+  std::condition_variable trajectory_ready_;
+  std::condition_variable slot_free_;
+  std::vector<std::thread> actors_;
+  std::atomic<bool> running_{false};
+  storage::CircularBufferFloatPointer reward_buffer_;
+  storage::CircularBufferIntPointer length_buffer_;
+  MetricsLoggerPointer logger_;
+  LiveMetricsWriterPointer live_metrics_;
+  storage::CheckpointManagerPointer checkpoint_manager_;
+
+  const Device device_;
+  float collection_time_ = 0.;
+  float learn_time_ = 0.;
+  float total_time_ = 0.;
+  unsigned int total_time_steps_ = 0;
+  unsigned int current_learning_iteration_ = 0;
+};
+
+using AsyncRunnerPointer = std::unique_ptr<AsyncRunner>;
+}  // namespace runners
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace runners {
+
+// Live counters of a running job, published in a POSIX shared-memory segment so that dashboards
+// and watchdogs can poll them without touching the training process. Header-only and torch-free,
+// shared by the runners and `cpp_rl_watch`.
+
+constexpr uint32_t kLiveMetricsMagic = 0x4c52504c;  // "LPRL"
+// Bumped whenever LiveCounters changes layout
+constexpr uint32_t kLiveMetricsVersion = 1;
+
+enum class Phase : uint32_t { kStarting, kCollecting, kLearning, kLogging, kSaving, kFinished };
+
+inline const char* phase_name(const Phase& phase) {
+  switch (phase) {
+    case Phase::kStarting:
+      return "starting";
+    case Phase::kCollecting:
+      return "collecting";
+    case Phase::kLearning:
+      return "learning";
+    case Phase::kLogging:
+      return "logging";
+    case Phase::kSaving:
+      return "saving";
+    case Phase::kFinished:
+      return "finished";
+  }
+  return "unknown";
+}
+
+// Plain data, copied as a whole under the seqlock
+struct LiveCounters {
+  int64_t pid = 0;
+  uint64_t iteration = 0;
+  uint64_t end_iteration = 0;
+  uint64_t total_time_steps = 0;
+  uint64_t num_episodes = 0;
+  uint64_t rss_bytes = 0;
+  // Wall-clock time of the last publish, lets readers detect a stalled writer
+  uint64_t update_time_ns = 0;
+  double total_time = 0.;
+  float fps = 0.f;
+  float collection_time = 0.f;
+  float learn_time = 0.f;
+  float mean_reward = 0.f;
+  float mean_length = 0.f;
+  float learning_rate = 0.f;
+  float kl = 0.f;
+  Phase phase = Phase::kStarting;
+};
+
+// Attempts of a reader before it reports the segment as stale, a writer that died inside an
+// update leaves the sequence odd forever
+constexpr unsigned int kLiveMetricsReadAttempts = 10000;
+
+// Shared-memory name of a training process, e.g. /cpp_rl_pendulum_4242, so that concurrent runs
+// of the same task do not share a segment
+inline std::string live_metrics_name(const std::string& task, const int64_t& pid) {
+  return "/cpp_rl_" + task + "_" + std::to_string(pid);
+}
+
+// Processes still alive that publish live metrics for a task, found under /dev/shm
+inline std::vector<int64_t> live_metrics_pids(const std::string& task) {
+  std::vector<int64_t> pids;
+  const std::string prefix = "cpp_rl_" + task + "_";
+  DIR* directory = ::opendir("/dev/shm");
+  if (!directory) return pids;
+  while (const dirent* entry = ::readdir(directory)) {
+    const std::string name = entry->d_name;
+    if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) continue;
+    const std::string suffix = name.substr(prefix.size());
+    if (suffix.find_first_not_of("0123456789") != std::string::npos) continue;
+    const int64_t pid = std::stoll(suffix);
+    if (::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM) pids.push_back(pid);
+  }
+  ::closedir(directory);
+  return pids;
+}
+
+struct LiveSegment {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t counters_size;
+  // Odd while the writer is inside an update
+  std::atomic<uint64_t> sequence;
+  LiveCounters counters;
+};
+
+// Single writer: only the thread driving the training loop publishes
+class LiveMetricsWriter {
+ public:
+  explicit LiveMetricsWriter(const std::string& name) : name_(name) {
+    const int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) throw std::runtime_error("Cannot create shared memory " + name);
+    if (::ftruncate(fd, sizeof(LiveSegment)) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Cannot resize shared memory " + name);
+    }
+    void* address =
+      ::mmap(nullptr, sizeof(LiveSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) throw std::runtime_error("Cannot map shared memory " + name);
+    this->segment_ = static_cast<LiveSegment*>(address);
+    this->segment_->sequence.store(0, std::memory_order_relaxed);
+    this->segment_->counters_size = sizeof(LiveCounters);
+    this->segment_->version = kLiveMetricsVersion;
+    this->counters_.pid = ::getpid();
+    this->publish();
+    // Readers only accept the segment once the header is complete
+    std::atomic_thread_fence(std::memory_order_release);
+    this->segment_->magic = kLiveMetricsMagic;
+  }
+
+  ~LiveMetricsWriter() {
+    this->set_phase(Phase::kFinished);
+    ::munmap(this->segment_, sizeof(LiveSegment));
+    // Mapped readers keep the final counters, new readers no longer find the segment
+    ::shm_unlink(this->name_.c_str());
+  }
+
+  LiveMetricsWriter(const LiveMetricsWriter&) = delete;
+  LiveMetricsWriter& operator=(const LiveMetricsWriter&) = delete;
+
+  // Fields set here become visible at the next publish
+  LiveCounters& counters() { return this->counters_; }
+
+  // Cheap enough to call around every phase of an iteration
+  void set_phase(const Phase& phase) {
+    this->counters_.phase = phase;
+    this->write_();
+  }
+
+  // Also samples the resident memory, once per iteration is enough
+  void publish() {
+    this->counters_.rss_bytes = resident_bytes_();
+    this->write_();
+  }
+
+ private:
+  void write_() {
+    this->counters_.update_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                       std::chrono::system_clock::now().time_since_epoch())
+                                       .count();
+    const uint64_t sequence = this->segment_->sequence.load(std::memory_order_relaxed);
+    this->segment_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(static_cast<void*>(&this->segment_->counters), &this->counters_,
+                sizeof(LiveCounters));
+    this->segment_->sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  static uint64_t resident_bytes_() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * ::sysconf(_SC_PAGESIZE);
+  }
+
+  const std::string name_;
+  LiveSegment* segment_;
+  LiveCounters counters_;
+};
+
+using LiveMetricsWriterPointer = std::unique_ptr<LiveMetricsWriter>;
+
+class LiveMetricsReader {
+ public:
+  explicit LiveMetricsReader(const std::string& name) {
+    const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) throw std::runtime_error("No live metrics at " + name + ", is the job running?");
+    void* address = ::mmap(nullptr, sizeof(LiveSegment), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) throw std::runtime_error("Cannot map shared memory " + name);
+    this->segment_ = static_cast<const LiveSegment*>(address);
+    if (this->segment_->magic != kLiveMetricsMagic ||
+        this->segment_->version != kLiveMetricsVersion ||
+        this->segment_->counters_size != sizeof(LiveCounters)) {
+      ::munmap(const_cast<LiveSegment*>(this->segment_), sizeof(LiveSegment));
+      throw std::runtime_error("Incompatible live metrics layout at " + name);
+    }
+  }
+
+  ~LiveMetricsReader() { ::munmap(const_cast<LiveSegment*>(this->segment_), sizeof(LiveSegment)); }
+
+  LiveMetricsReader(const LiveMetricsReader&) = delete;
+  LiveMetricsReader& operator=(const LiveMetricsReader&) = delete;
+
+  // Retries until it copies a snapshot no update overlapped, never blocks the writer. Empty when
+  // every attempt overlapped an update, i.e. the segment is stale.
+  std::optional<LiveCounters> read() const {
+    LiveCounters counters;
+    for (unsigned int attempt = 0; attempt < kLiveMetricsReadAttempts; ++attempt) {
+      const uint64_t before = this->segment_->sequence.load(std::memory_order_acquire);
+      if (before & 1) {
+        std::this_thread::yield();
+        continue;
+      }
+      std::memcpy(&counters, static_cast<const void*>(&this->segment_->counters),
+                  sizeof(LiveCounters));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (this->segment_->sequence.load(std::memory_order_relaxed) == before) return counters;
+    }
+    return std::nullopt;
+  }
+
+ private:
+  const LiveSegment* segment_;
+};
+
+}  // namespace runners
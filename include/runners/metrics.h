@@ -1,6 +1,7 @@
 #pragma once
 
 #include "algorithms/ppo.h"
+#include "live_metrics.h"
 #include "utils/types.h"
 #include "utils/utils.h"
 
@@ -58,21 +59,56 @@ struct TotalMetrics {
   }
 };
 
-struct ExtraMetrics {
+// Named values printed under "<Category::name> Metrics" and logged under "<Category::name>/"
+template <typename Category>
+struct MapMetrics {
   const std::map<string, float> values;
 
-  explicit ExtraMetrics(const std::map<string, float>& values) : values(values) {}
+  explicit MapMetrics(const std::map<string, float>& values) : values(values) {}
 
-  friend std::ostream& operator<<(std::ostream& os, const ExtraMetrics& metrics) {
+  void to_dict(std::map<string, float>& dict) const {
+    for (const auto& [key, value] : this->values)
+      dict[string(Category::name) + "/" + key] = value;
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const MapMetrics& metrics) {
     if (metrics.values.empty()) return os;
-    os << "\033[1mExtra Metrics:\033[0m" << std::endl;
+    os << "\033[1m" << Category::name << " Metrics:\033[0m" << std::endl;
     for (const auto& [key, value] : metrics.values) {
-      os << utils::formatOutput(key, value) << std::endl;
+      os << utils::formatOutput(key, value, Category::unit) << std::endl;
     }
     return os;
   }
 };
 
+struct ExtraCategory {
+  static constexpr const char* name = "Extra";
+  static constexpr const char* unit = "";
+};
+
+// Per-phase p50/p99 span durations in milliseconds, see utils::Tracer
+struct TimingCategory {
+  static constexpr const char* name = "Timing";
+  static constexpr const char* unit = " ms";
+};
+
+// Per-phase hardware counter ratios, see utils::PerfCounters
+struct HardwareCategory {
+  static constexpr const char* name = "Hardware";
+  static constexpr const char* unit = "";
+};
+
+// Bytes per subsystem in MB and allocations per rollout step, see utils::MemoryReport
+struct MemoryCategory {
+  static constexpr const char* name = "Memory";
+  static constexpr const char* unit = "";
+};
+
+using ExtraMetrics = MapMetrics<ExtraCategory>;
+using TimingMetrics = MapMetrics<TimingCategory>;
+using HardwareMetrics = MapMetrics<HardwareCategory>;
+using MemoryMetrics = MapMetrics<MemoryCategory>;
+
 struct TrainMetrics {
   const unsigned int current_iteration;
   const unsigned int end_iteration;
@@ -81,18 +117,64 @@ struct TrainMetrics {
   const RewardMetrics reward_metrics;
   const TotalMetrics total_metrics;
   const ExtraMetrics extra_metrics;
+  const TimingMetrics timing_metrics;
+  const HardwareMetrics hardware_metrics;
+  const MemoryMetrics memory_metrics;
 
   TrainMetrics(const unsigned int& current_iteration, const unsigned int& end_iteration,
                const ComputationMetrics& computation_metrics,
                const algorithms::LossMetrics& loss_metrics, const RewardMetrics& reward_metrics,
-               const TotalMetrics& total_metrics, const ExtraMetrics& extra_metrics)
+               const TotalMetrics& total_metrics, const ExtraMetrics& extra_metrics,
+               const TimingMetrics& timing_metrics = TimingMetrics{{}},
+               const HardwareMetrics& hardware_metrics = HardwareMetrics{{}},
+               const MemoryMetrics& memory_metrics = MemoryMetrics{{}})
     : current_iteration(current_iteration),
       end_iteration(end_iteration),
       computation_metrics(computation_metrics),
       loss_metrics(loss_metrics),
       reward_metrics(reward_metrics),
       total_metrics(total_metrics),
-      extra_metrics(extra_metrics) {}
+      extra_metrics(extra_metrics),
+      timing_metrics(timing_metrics),
+      hardware_metrics(hardware_metrics),
+      memory_metrics(memory_metrics) {}
+
+  // Copy with additional extra metrics, for values resolved after the record was built
+  TrainMetrics with_extra_values(const std::map<string, float>& values) const {
+    std::map<string, float> extra_values = this->extra_metrics.values;
+    extra_values.insert(values.begin(), values.end());
+    return TrainMetrics{this->current_iteration,   this->end_iteration,
+                        this->computation_metrics, this->loss_metrics,
+                        this->reward_metrics,      this->total_metrics,
+                        ExtraMetrics{extra_values}, this->timing_metrics,
+                        this->hardware_metrics,    this->memory_metrics};
+  }
+
+  // One-line console summary
+  const string summary() const {
+    std::ostringstream oss;
+    oss << "It " << this->current_iteration << "/" << this->end_iteration << " | fps "
+        << this->computation_metrics.fps << " | reward " << this->reward_metrics.reward
+        << " | length " << this->reward_metrics.length << " | actor loss "
+        << this->loss_metrics.actor_loss << " | critic loss " << this->loss_metrics.critic_loss;
+    return oss.str();
+  }
+
+  void to_live_counters(LiveCounters& counters) const {
+    counters.iteration = this->current_iteration;
+    counters.end_iteration = this->end_iteration;
+    counters.total_time_steps = this->total_metrics.total_time_steps;
+    counters.total_time = this->total_metrics.total_time;
+    counters.fps = this->computation_metrics.fps;
+    counters.collection_time = this->computation_metrics.collection_time;
+    counters.learn_time = this->computation_metrics.learn_time;
+    counters.mean_reward = this->reward_metrics.reward;
+    counters.mean_length = this->reward_metrics.length;
+    counters.kl = this->loss_metrics.kl_loss;
+    const auto& learning_rate = this->extra_metrics.values.find("learning_rate");
+    if (learning_rate != this->extra_metrics.values.end())
+      counters.learning_rate = learning_rate->second;
+  }
 
   const std::map<string, float> to_dict() const {
     std::map<string, float> dict;
@@ -105,7 +187,10 @@ struct TrainMetrics {
     dict["Loss/kl_loss"] = loss_metrics.kl_loss;
     dict["Train/reward"] = reward_metrics.reward;
     dict["Train/length"] = reward_metrics.length;
-    for (const auto& [key, value] : extra_metrics.values) dict["Extra/" + key] = value;
+    extra_metrics.to_dict(dict);
+    timing_metrics.to_dict(dict);
+    hardware_metrics.to_dict(dict);
+    memory_metrics.to_dict(dict);
     return dict;
   }
 
@@ -118,6 +203,9 @@ struct TrainMetrics {
     os << metric.loss_metrics << std::endl;
     os << metric.reward_metrics << std::endl;
     os << metric.extra_metrics << std::endl;
+    os << metric.timing_metrics << std::endl;
+    os << metric.hardware_metrics << std::endl;
+    os << metric.memory_metrics << std::endl;
     os << metric.total_metrics << std::endl;
     float eta = metric.total_metrics.total_time / (metric.current_iteration) *
                 (metric.end_iteration - metric.current_iteration + 1);
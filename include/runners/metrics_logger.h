@@ -0,0 +1,55 @@
+#pragma once
+
+#include <tensorboard_logger.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "configs/configs.h"
+#include "metrics.h"
+#include "storage/lock_free_queue.h"
+#include "utils/types.h"
+
+namespace runners {
+
+// Formats console output and writes tensorboard events from a background thread. The training
+// thread only pushes records into a lock-free queue; when the queue is full the record is dropped
+// and reported on stderr instead of stalling the iteration loop, except for the final iteration,
+// which waits for a free slot. Per-dimension action stds are passed as a tensor and only copied to
+// the host by the logging thread.
+class MetricsLogger {
+ public:
+  MetricsLogger(const string& event_path, const configs::RunnerCfg& cfg);
+  // Drains the queued records before returning
+  ~MetricsLogger();
+
+  MetricsLogger(const MetricsLogger&) = delete;
+  MetricsLogger& operator=(const MetricsLogger&) = delete;
+
+  void push(TrainMetrics&& metric, const Tensor& action_std = Tensor());
+
+ private:
+  struct Record {
+    std::unique_ptr<TrainMetrics> metric;
+    Tensor action_std;
+  };
+
+  void logger_loop_();
+  void write_(const Record& record);
+
+  const unsigned int warmup_;
+  const unsigned int console_verbosity_;
+  const float console_interval_;
+  TensorBoardLogger tensorboard_;
+  storage::LockFreeQueue<Record> queue_;
+  std::atomic<bool> running_{true};
+  std::atomic<unsigned int> num_dropped_{0};
+  std::chrono::steady_clock::time_point last_print_;
+  std::thread thread_;
+};
+
+using MetricsLoggerPointer = std::unique_ptr<MetricsLogger>;
+
+}  // namespace runners
@@ -1,54 +1,81 @@
 #pragma once
 
-#include <tensorboard_logger.h>
-
 #include "algorithms/ppo.h"
 #include "configs/configs.h"
+#include "distributed/process_group.h"
 #include "env/env.h"
+#include "live_metrics.h"
 #include "metrics.h"
+#include "metrics_logger.h"
 #include "modules/actor_critic.h"
+#include "storage/checkpoint_manager.h"
 #include "storage/circular_buffer.h"
 #include "storage/observation_buffer.h"
+#include "utils/memory.h"
 #include "utils/types.h"
 
 namespace runners {
 
-using TensorBoardLoggerPointer = std::unique_ptr<TensorBoardLogger>;
+// Called with the metrics of every learning iteration, training stops when it returns false
+using IterationCallback = std::function<bool(const TrainMetrics&)>;
 
 class OnPolicyRunner {
  public:
-  OnPolicyRunner(const string& task, const configs::CfgPointer& cfg, const Device& device);
+  // A headless runner writes no tensorboard events, checkpoints, live counters or traces
+  OnPolicyRunner(const string& task, const configs::CfgPointer& cfg, const Device& device,
+                 const distributed::ProcessGroupPointer& process_group = nullptr,
+                 const bool& headless = false);
 
-  void learn();
+  void learn(const IterationCallback& callback = nullptr);
   void play();
-  void save_models(const string& name) const;
+  void save_models(const string& name, const bool& periodic = false) const;
   void load_models(const string& name, const bool& load_optimizer = false);
+  void export_policy(const string& name) const;
+  // False when the int8 policy exceeds the accuracy bounds of the quantization config
+  bool quantize_policy(const string& name);
   const std::function<Tensor(const Tensor&)> get_inference_policy() const {
     return this->train_algorithm_->get_inference_policy();
   }
+  // Peak bytes per subsystem of a training run from the config alone, nothing is trained
+  static const utils::MemoryReport predict_memory(const string& task,
+                                                  const configs::CfgPointer& cfg);
+  const utils::MemoryReport memory_report() const;
 
  private:
   void update_cfg_();
   void initialize_();
-  void log_metric_(const TrainMetrics& metric) const;
+  void collect_rollout_();
+  Tensor evaluate_(const std::function<Tensor(const Tensor&)>& policy, const int& seed,
+                   std::vector<Tensor>& observations);
   void train_() { this->train_algorithm_->train(); }
   void eval_() { this->train_algorithm_->eval(); }
+  void set_phase_(const Phase& phase) {
+    if (this->live_metrics_) this->live_metrics_->set_phase(phase);
+  }
+  bool is_main_() const { return this->cfg_->distributed_cfg.is_main(); }
 
   const configs::CfgPointer cfg_;
+  const string run_path_;
+  const bool headless_;
   env::EnvPointer env_;
   storage::ObservationBufferPointer observation_buffer_;
   algorithms::PPOPointer train_algorithm_;
   storage::CircularBufferFloatPointer reward_buffer_;
   storage::CircularBufferIntPointer length_buffer_;
-  TensorBoardLoggerPointer logger_;
+  MetricsLoggerPointer logger_;
+  LiveMetricsWriterPointer live_metrics_;
+  storage::CheckpointManagerPointer checkpoint_manager_;
 
   const Device device_;
   env::Results env_results_;
+  Tensor actions_;
   Tensor current_reward_sum_;
   Tensor current_episode_length_;
   float collection_time_ = 0.;
   float learn_time_ = 0.;
   float total_time_ = 0.;
+  float allocations_per_step_ = 0.;
+  float allocated_bytes_per_step_ = 0.;
   unsigned int total_time_steps_ = 0;
   unsigned int current_learning_iteration_ = 0;
 };
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "utils/types.h"
+
+namespace runners {
+
+struct SweepPoint {
+  unsigned int num_envs;
+  unsigned int num_threads;
+  unsigned int num_steps_per_env;
+  unsigned int num_batches;
+};
+
+struct SweepResult {
+  SweepPoint point;
+  // Averages over the timed iterations
+  float fps;
+  float iteration_time;
+  float collection_time;
+  float learn_time;
+  float peak_rss_mb;
+  float tensor_mb;
+  // Throughput over linear scaling from the smallest num_envs and thread count of the sweep
+  float env_efficiency = 1.f;
+  float thread_efficiency = 1.f;
+};
+
+// Trains every combination of the sweep document (see yaml/sweep.yaml) on top of
+// yaml/train.yaml for a fixed number of iterations with a headless runner, then writes the scaling
+// report to data/<task>/<output>.csv and .md
+void run_sweep(const string& task, const string& sweep_path, const Device& device);
+
+}  // namespace runners
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "utils/types.h"
+
+namespace runners {
+
+struct TargetRun {
+  int seed;
+  bool reached = false;
+  // Wall-clock seconds and env steps until the mean episode reward crossed the target, or until
+  // the budget ran out
+  float time = 0.f;
+  unsigned int steps = 0;
+  unsigned int iterations = 0;
+  float fps = 0.f;
+  float final_reward = 0.f;
+};
+
+// Trains yaml/train.yaml once per seed of the benchmark document (see yaml/benchmark.yaml) with
+// a headless runner until the mean episode reward reaches the target or the time budget runs out,
+// then writes median and IQR of time, env steps to target and throughput to
+// data/<task>/<output>.json
+void run_target_benchmark(const string& task, const string& benchmark_path, const Device& device);
+
+}  // namespace runners
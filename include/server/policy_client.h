@@ -0,0 +1,80 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// Wire format of the policy server, native endianness over a unix stream socket:
+//   on connect the server sends uint32 num_inputs, uint32 num_actions,
+//   then every request is float[num_inputs] and every reply float[num_actions].
+namespace server {
+
+// Loops until the whole buffer went through the socket, false once the peer is gone
+inline bool write_all(const int& fd, const void* data, size_t size) {
+  const char* bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    const ssize_t written = ::send(fd, bytes, size, MSG_NOSIGNAL);
+    if (written <= 0) return false;
+    bytes += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+inline bool read_all(const int& fd, void* data, size_t size) {
+  char* bytes = static_cast<char*>(data);
+  while (size > 0) {
+    const ssize_t received = ::recv(fd, bytes, size, 0);
+    if (received <= 0) return false;
+    bytes += received;
+    size -= static_cast<size_t>(received);
+  }
+  return true;
+}
+
+// Blocking client for one process or thread, header-only and free of libtorch
+class PolicyClient {
+ public:
+  explicit PolicyClient(const std::string& socket_path) {
+    sockaddr_un address{};
+    if (socket_path.size() >= sizeof(address.sun_path))
+      throw std::invalid_argument("Socket path too long: " + socket_path);
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    this->fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (this->fd_ < 0) throw std::runtime_error("Cannot create socket");
+    if (::connect(this->fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        !read_all(this->fd_, &this->num_inputs_, sizeof(this->num_inputs_)) ||
+        !read_all(this->fd_, &this->num_actions_, sizeof(this->num_actions_))) {
+      ::close(this->fd_);
+      throw std::runtime_error("Cannot connect to the policy server at " + socket_path);
+    }
+  }
+  ~PolicyClient() { ::close(this->fd_); }
+
+  PolicyClient(const PolicyClient&) = delete;
+  PolicyClient& operator=(const PolicyClient&) = delete;
+
+  // actions[num_actions] for observations[num_inputs]
+  void act(const float* observations, float* actions) const {
+    if (!write_all(this->fd_, observations, this->num_inputs_ * sizeof(float)) ||
+        !read_all(this->fd_, actions, this->num_actions_ * sizeof(float)))
+      throw std::runtime_error("Policy server closed the connection");
+  }
+
+  uint32_t num_inputs() const { return this->num_inputs_; }
+  uint32_t num_actions() const { return this->num_actions_; }
+
+ private:
+  int fd_ = -1;
+  uint32_t num_inputs_ = 0;
+  uint32_t num_actions_ = 0;
+};
+
+}  // namespace server
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "configs/configs.h"
+#include "modules/actor_critic.h"
+#include "utils/latency_histogram.h"
+#include "utils/types.h"
+
+namespace server {
+
+using Clock = std::chrono::steady_clock;
+using ActorCriticSharedPointer = std::shared_ptr<modules::ActorCritic>;
+
+// One observation waiting for its batch, owned by the connection that received it
+struct Request {
+  const float* observations;
+  float* actions;
+  Clock::time_point arrival;
+  std::promise<void> done;
+};
+
+// Serves the actor of a trained run to local processes over a unix socket (see policy_client.h).
+// Connection threads queue single observations, one batching thread evaluates them together,
+// at most max_batch_size at a time and no later than max_wait_us after the oldest arrived.
+// A newer models_last.pt is loaded in the background and swapped in atomically between batches.
+class PolicyServer {
+ public:
+  PolicyServer(const configs::CfgPointer& cfg, const string& model_path, const Device& device);
+  ~PolicyServer();
+
+  // Blocks until stop_requested is set, e.g. by a signal handler
+  void serve(const std::atomic<bool>& stop_requested);
+
+ private:
+  ActorCriticSharedPointer load_policy_() const;
+  void connection_loop_(const int fd);
+  void batch_loop_();
+  void watch_loop_();
+  void run_batch_(std::vector<Request*>& batch);
+  // Joins the connection threads whose client has disconnected
+  void reap_connections_();
+
+  // Thread of one client, flags its own end so that the accept loop can join it
+  struct Connection {
+    std::thread thread;
+    std::atomic<bool> done{false};
+  };
+
+  const configs::CfgPointer cfg_;
+  const configs::ServerCfg& server_cfg_;
+  const string model_path_;
+  const Device device_;
+  const unsigned int num_inputs_;
+  const unsigned int num_actions_;
+
+  ActorCriticSharedPointer actor_critic_;
+  std::filesystem::file_time_type model_time_;
+  Tensor inputs_;
+
+  int listen_fd_ = -1;
+  std::atomic<bool> running_{false};
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Request*> requests_;
+  std::vector<int> client_fds_;
+  std::vector<std::thread> threads_;
+  // Only touched by the thread running serve, list nodes stay put while their threads run
+  std::list<Connection> connections_;
+
+  utils::LatencyHistogram latencies_;
+  std::atomic<uint64_t> num_requests_{0};
+  std::atomic<uint64_t> num_batches_{0};
+};
+
+}  // namespace server
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "utils/types.h"
+
+namespace storage {
+
+// Fills an archive on the writer thread, from tensors the caller has already copied
+using ArchiveWriter = std::function<void(torch::serialize::OutputArchive&)>;
+
+// CPU copies of the parameters and buffers of a module, written in the layout of Module::save
+ArchiveWriter snapshot_module(const torch::nn::Module& module);
+// CPU copies of the Adam moments, written in the layout of Optimizer::save
+ArchiveWriter snapshot_optimizer(const torch::optim::Adam& optimizer);
+
+// Writes checkpoints from a background thread. The training thread only copies the tensors to
+// the CPU, serialization happens on the writer; the file is written to a temporary path, synced
+// and renamed, so readers never see a partial checkpoint. At most max_to_keep periodic
+// checkpoints stay on disk (0 keeps all), counting those already in run_path at construction.
+class CheckpointManager {
+ public:
+  CheckpointManager(const string& run_path, const unsigned int& save_interval,
+                    const unsigned int& max_to_keep);
+  ~CheckpointManager();
+
+  CheckpointManager(const CheckpointManager&) = delete;
+  CheckpointManager& operator=(const CheckpointManager&) = delete;
+
+  // True after every save_interval completed iterations
+  bool is_due(const unsigned int& num_iterations) const {
+    return this->save_interval_ > 0 && num_iterations % this->save_interval_ == 0;
+  }
+  // Periodic checkpoints count towards max_to_keep, others (e.g. models_last.pt) never expire
+  void save(ArchiveWriter&& writer, const string& name, const bool& periodic = false);
+  void save(string&& buffer, const string& name, const bool& periodic = false);
+  // Blocks until every queued checkpoint is on disk
+  void wait();
+
+ private:
+  // Either a snapshot to serialize or an already serialized buffer
+  struct Job {
+    string name;
+    ArchiveWriter writer;
+    string buffer;
+    bool periodic;
+  };
+
+  void push_(Job&& job);
+  void writer_loop_();
+  void write_(Job& job);
+
+  const string run_path_;
+  const unsigned int save_interval_;
+  const unsigned int max_to_keep_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Job> jobs_;
+  bool writing_ = false;
+  bool stopping_ = false;
+  std::deque<string> periodic_paths_;
+  std::thread writer_;
+};
+
+using CheckpointManagerPointer = std::unique_ptr<CheckpointManager>;
+
+}  // namespace storage
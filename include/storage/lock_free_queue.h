@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace storage {
+
+// Bounded multi-producer multi-consumer queue (Vyukov). Each cell carries a sequence number that
+// tells producers and consumers whether it is free, so push and pop are a single CAS each.
+template <typename T>
+class LockFreeQueue {
+ public:
+  explicit LockFreeQueue(size_t capacity)
+    : capacity_(round_up_(capacity)),
+      mask_(round_up_(capacity) - 1),
+      cells_(std::make_unique<Cell[]>(round_up_(capacity))),
+      enqueue_position_(0),
+      dequeue_position_(0) {
+    for (size_t i = 0; i < this->capacity_; ++i)
+      this->cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  LockFreeQueue(const LockFreeQueue&) = delete;
+  LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+  // The value is only moved from on success
+  bool try_push(T&& value) {
+    Cell* cell;
+    size_t position = this->enqueue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &this->cells_[position & this->mask_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const std::ptrdiff_t difference =
+        static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+      if (difference == 0) {
+        if (this->enqueue_position_.compare_exchange_weak(position, position + 1,
+                                                          std::memory_order_relaxed))
+          break;
+      } else if (difference < 0)
+        return false;
+      else
+        position = this->enqueue_position_.load(std::memory_order_relaxed);
+    }
+    cell->value = std::move(value);
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_pop(T& value) {
+    Cell* cell;
+    size_t position = this->dequeue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &this->cells_[position & this->mask_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const std::ptrdiff_t difference =
+        static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+      if (difference == 0) {
+        if (this->dequeue_position_.compare_exchange_weak(position, position + 1,
+                                                          std::memory_order_relaxed))
+          break;
+      } else if (difference < 0)
+        return false;
+      else
+        position = this->dequeue_position_.load(std::memory_order_relaxed);
+    }
+    value = std::move(cell->value);
+    cell->sequence.store(position + this->mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t capacity() const { return this->capacity_; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  static size_t round_up_(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    return size;
+  }
+
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(64) std::atomic<size_t> enqueue_position_;
+  alignas(64) std::atomic<size_t> dequeue_position_;
+};
+
+}  // namespace storage
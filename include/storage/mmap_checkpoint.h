@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/types.h"
+
+namespace storage {
+
+// Inference checkpoint: the parameters and buffers of a module in one file, every tensor at a
+// page-aligned offset so the file is mapped once and wrapped as tensors without copying.
+// Layout (native endianness):
+//   magic "CPPRLMAP", uint32 version, uint32 num_entries,
+//   per entry: uint32 name_size, name, uint32 dtype, uint32 dim, int64 sizes[dim], uint64 offset,
+//   then the data of every entry at its offset (multiple of kCheckpointAlignment)
+class MmapCheckpoint {
+ public:
+  static constexpr size_t kCheckpointAlignment = 4096;
+
+  // File contents for module, e.g. to hand to CheckpointManager::save
+  static string serialize(const NNModule& module);
+
+  explicit MmapCheckpoint(const string& path);
+
+  // Points the parameters and buffers of module whose name starts with one of prefixes at the
+  // mapped data. Pages are copy-on-write and only read when touched; non-CPU modules get a copy.
+  void load(NNModule& module, const std::vector<string>& prefixes) const;
+
+ private:
+  struct Entry {
+    torch::ScalarType dtype;
+    std::vector<int64_t> sizes;
+    size_t offset;
+  };
+
+  const Tensor tensor_(const Entry& entry) const;
+
+  string path_;
+  std::shared_ptr<void> mapping_;
+  size_t size_ = 0;
+  std::unordered_map<string, Entry> entries_;
+};
+
+}  // namespace storage
@@ -35,6 +35,10 @@ class ObservationBuffer {
   unsigned int get_critic_obs_size() const {
     return this->buffer_critic_obs_.size(1) * this->buffer_critic_obs_.size(2);
   }
+  int64_t memory_bytes() const {
+    return utils::tensor_bytes(this->buffer_actor_obs_) +
+           utils::tensor_bytes(this->buffer_critic_obs_) + utils::tensor_bytes(this->all_indices_);
+  }
 
  private:
   void initialize_();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "configs/configs.h"
+#include "utils/memory.h"
 #include "utils/types.h"
 
 namespace storage {
@@ -17,6 +18,14 @@ struct Transition {
 
   DictTensor kl_params;
 
+  int64_t memory_bytes() const {
+    return utils::tensor_bytes(this->actor_obs) + utils::tensor_bytes(this->critic_obs) +
+           utils::tensor_bytes(this->actions) + utils::tensor_bytes(this->rewards) +
+           utils::tensor_bytes(this->advantages) + utils::tensor_bytes(this->dones) +
+           utils::tensor_bytes(this->values) + utils::tensor_bytes(this->log_probs) +
+           utils::tensor_bytes(this->kl_params);
+  }
+
   friend std::ostream& operator<<(std::ostream& os, const Transition& transition) {
     os << "actor_obs: " << transition.actor_obs.sizes() << std::endl;
     os << "critic_obs: " << transition.critic_obs.sizes() << std::endl;
@@ -35,19 +44,30 @@ struct Transition {
 
 class RolloutStorage {
  public:
-  RolloutStorage(const configs::CfgPointer& cfg, const Device& device)
-    : cfg_(cfg), device_(device) {}
+  RolloutStorage(const configs::CfgPointer& cfg, const Device& device,
+                 const AllReduceFn& all_reduce = nullptr)
+    : cfg_(cfg), device_(device), all_reduce_(all_reduce) {}
 
   void initialize(const DictTensor& kl_params);
   void clear() { this->step_ = 0; }
   void push_back(const Transition& transition);
   void compute_advantage(const Tensor& last_values, const float& gamma, const float& lambda);
   void update_batches(std::vector<storage::Transition>& batches);
+  const Tensor get_actor_obs() const {
+    return this->transitions_.actor_obs.view({-1, this->transitions_.actor_obs.size(2)});
+  }
+  const Tensor get_critic_obs() const {
+    return this->transitions_.critic_obs.view({-1, this->transitions_.critic_obs.size(2)});
+  }
+  int64_t memory_bytes() const {
+    return this->transitions_.memory_bytes() + utils::tensor_bytes(this->returns_);
+  }
 
  private:
   const configs::CfgPointer cfg_;
 
   const Device device_;
+  const AllReduceFn all_reduce_;
   Transition transitions_;
   Tensor returns_;
   int step_ = 0;
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "utils/types.h"
+
+namespace storage {
+
+// Time-major [num_steps, num_envs, ...] segment collected by one actor with a fixed policy
+struct Trajectory {
+  Tensor actor_obs;
+  Tensor critic_obs;
+  Tensor actions;
+  Tensor rewards;
+  Tensor dones;
+  Tensor log_probs;
+  Tensor last_critic_obs;
+  unsigned int policy_version = 0;
+
+  // Episodes completed during the segment
+  std::vector<float> episode_rewards;
+  std::vector<int> episode_lengths;
+};
+
+using TrajectoryPointer = std::unique_ptr<Trajectory>;
+}  // namespace storage
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ATen/autocast_mode.h>
+
+#include "types.h"
+
+namespace utils {
+
+// Scoped autocast for one device type, restores the previous (thread local) state on exit
+class AutocastGuard {
+ public:
+  AutocastGuard(const Device& device, const torch::ScalarType& dtype)
+    : device_type_(device.type()),
+      previous_enabled_(at::autocast::is_autocast_enabled(device.type())),
+      previous_dtype_(at::autocast::get_autocast_dtype(device.type())) {
+    at::autocast::set_autocast_dtype(this->device_type_, dtype);
+    at::autocast::set_autocast_enabled(this->device_type_, true);
+  }
+
+  ~AutocastGuard() {
+    at::autocast::set_autocast_enabled(this->device_type_, this->previous_enabled_);
+    at::autocast::set_autocast_dtype(this->device_type_, this->previous_dtype_);
+    // Weights change after every optimizer step, cached casts would be stale
+    if (!this->previous_enabled_) at::autocast::clear_cache();
+  }
+
+  AutocastGuard(const AutocastGuard&) = delete;
+  AutocastGuard& operator=(const AutocastGuard&) = delete;
+
+ private:
+  const c10::DeviceType device_type_;
+  const bool previous_enabled_;
+  const torch::ScalarType previous_dtype_;
+};
+
+}  // namespace utils
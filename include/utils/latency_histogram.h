@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace utils {
+
+// Log-linear histogram of latencies in nanoseconds, 8 buckets per power of two (at most 12.5%
+// relative error). Recording is a single relaxed atomic increment, safe from any thread.
+class LatencyHistogram {
+ public:
+  void record(const uint64_t& nanoseconds) {
+    this->counts_[bucket_(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint64_t count() const {
+    uint64_t count = 0;
+    for (const auto& bucket_count : this->counts_) count += bucket_count.load();
+    return count;
+  }
+
+  // Upper bound of the bucket holding the given quantile, 0 when empty
+  uint64_t percentile(const double& quantile) const {
+    const uint64_t total = this->count();
+    if (total == 0) return 0;
+    const uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      seen += this->counts_[i].load();
+      if (seen >= rank) return upper_bound_(i);
+    }
+    return upper_bound_(kNumBuckets - 1);
+  }
+
+  void reset() {
+    for (auto& bucket_count : this->counts_) bucket_count.store(0);
+  }
+
+ private:
+  static constexpr size_t kSubBuckets = 8;
+  static constexpr size_t kNumBuckets = 64 * kSubBuckets;
+
+  static size_t bucket_(const uint64_t& value) {
+    if (value < kSubBuckets) return value;
+    const size_t exponent = 63 - __builtin_clzll(value);
+    const size_t sub_bucket = (value >> (exponent - 3)) & (kSubBuckets - 1);
+    return (exponent - 2) * kSubBuckets + sub_bucket;
+  }
+
+  static uint64_t upper_bound_(const size_t& bucket) {
+    if (bucket < kSubBuckets) return bucket;
+    const size_t exponent = bucket / kSubBuckets + 2;
+    const uint64_t sub_bucket = bucket % kSubBuckets;
+    return ((kSubBuckets + sub_bucket + 1) << (exponent - 3)) - 1;
+  }
+
+  std::array<std::atomic<uint64_t>, kNumBuckets> counts_{};
+};
+
+}  // namespace utils
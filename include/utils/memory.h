@@ -0,0 +1,88 @@
+#pragma once
+
+#include <c10/core/Allocator.h>
+#include <c10/util/ThreadLocalDebugInfo.h>
+#include <torch/torch.h>
+
+#include <atomic>
+#include <vector>
+
+#include "utils/types.h"
+
+namespace utils {
+
+// Bytes viewed by a tensor, 0 when undefined
+inline int64_t tensor_bytes(const Tensor& tensor) {
+  return tensor.defined() ? static_cast<int64_t>(tensor.nbytes()) : 0;
+}
+
+inline int64_t tensor_bytes(const DictTensor& tensors) {
+  int64_t bytes = 0;
+  for (const auto& [key, value] : tensors) bytes += tensor_bytes(value);
+  return bytes;
+}
+
+// Parameters, their gradients and buffers of a module and its children
+int64_t module_bytes(const torch::nn::Module& module);
+// Adam moments held by the optimizer, empty until its first step
+int64_t optimizer_bytes(const torch::optim::Optimizer& optimizer);
+
+// Peak resident set size of the process (VmHWM), 0 when unavailable
+int64_t peak_resident_bytes();
+// Restarts the peak from the current resident set size, false when the kernel refuses
+bool reset_peak_resident_bytes();
+
+// Bytes per subsystem, in insertion order
+class MemoryReport {
+ public:
+  void add(const string& name, const int64_t& bytes) { this->entries_.emplace_back(name, bytes); }
+  void add(const MemoryReport& report) {
+    this->entries_.insert(this->entries_.end(), report.entries_.begin(), report.entries_.end());
+  }
+  int64_t total() const;
+  // "<subsystem>_mb" per entry plus "total_mb"
+  std::map<string, float> to_megabytes() const;
+
+  friend std::ostream& operator<<(std::ostream& os, const MemoryReport& report);
+
+ private:
+  std::vector<std::pair<string, int64_t>> entries_;
+};
+
+// Allocator hook: libtorch reports every allocation and free to the memory reporting info of the
+// current thread, which at::parallel_for also propagates to its workers. The hook occupies the
+// PROFILER_STATE slot that the legacy autograd profiler (RecordProfile) reads as its own state, so
+// it must never be installed while that profiler records: RunnerCfg rejects memory_accounting
+// together with trace_autograd.
+class AllocationCounter : public c10::MemoryReportingInfoBase {
+ public:
+  bool memoryProfilingEnabled() const override { return true; }
+  void reportMemoryUsage(void* ptr, int64_t alloc_size, size_t total_allocated,
+                         size_t total_reserved, c10::Device device) override;
+
+  uint64_t allocations() const { return this->allocations_.load(std::memory_order_relaxed); }
+  uint64_t allocated_bytes() const { return this->bytes_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> allocations_{0};
+  std::atomic<uint64_t> bytes_{0};
+};
+
+// Counts the allocations of the calling thread until destroyed
+class AllocationScope {
+ public:
+  AllocationScope()
+    : counter_(std::make_shared<AllocationCounter>()),
+      guard_(c10::DebugInfoKind::PROFILER_STATE, this->counter_) {}
+
+  AllocationScope(const AllocationScope&) = delete;
+  AllocationScope& operator=(const AllocationScope&) = delete;
+
+  const AllocationCounter& counter() const { return *this->counter_; }
+
+ private:
+  const std::shared_ptr<AllocationCounter> counter_;
+  const c10::DebugInfoGuard guard_;
+};
+
+}  // namespace utils
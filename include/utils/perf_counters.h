@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "utils/types.h"
+
+namespace utils {
+
+// Runner phases measured by PerfScope
+enum class PerfPhase : uint8_t { kCollection, kEnvStep, kLearning, kNumPhases };
+
+// Hardware counters from perf_event_open: cycles, instructions, last-level cache misses and branch
+// misses of the thread running a phase, plus the DRAM traffic of the uncore memory controllers
+// when the kernel exposes them (system wide, usually needs CAP_PERFMON). Torch intra-op worker
+// threads are not attributed, set torch::set_num_threads(1) for exact per-phase counts. Everything
+// missing or not permitted is skipped with a single warning.
+class PerfCounters {
+ public:
+  static PerfCounters& instance();
+
+  // False when the kernel refuses even the cycle counter
+  bool enable();
+  bool is_enabled() const { return this->enabled_.load(std::memory_order_relaxed); }
+
+  // IPC, cache and branch misses and memory bandwidth of each phase since the previous call, e.g.
+  // "env_step_ipc". Misses are per Env::step call for collection and env_step, per learning
+  // iteration for learning, e.g. "learning_cache_misses_per_iteration"
+  std::map<string, float> pop_metrics();
+
+ private:
+  friend class PerfScope;
+
+  enum Event : size_t { kCycles, kInstructions, kCacheMisses, kBranchMisses, kNumEvents };
+
+  struct Reading {
+    std::array<double, kNumEvents> values{};
+    uint64_t memory_bytes = 0;
+  };
+
+  struct Accumulator {
+    std::array<std::atomic<uint64_t>, kNumEvents> values{};
+    std::atomic<uint64_t> memory_bytes{0};
+    std::atomic<uint64_t> time_ns{0};
+    std::atomic<uint64_t> count{0};
+  };
+
+  // Counter group of one thread, opened on its first measured phase
+  struct ThreadGroup {
+    int leader = -1;
+    std::array<int, kNumEvents> fds{-1, -1, -1, -1};
+    // Position of each event in the group read, -1 when unavailable
+    std::array<int, kNumEvents> slots{-1, -1, -1, -1};
+    int num_slots = 0;
+    ~ThreadGroup();
+  };
+
+  PerfCounters() = default;
+  ~PerfCounters();
+  ThreadGroup& thread_group_();
+  void open_memory_counters_();
+  bool read_(Reading& reading);
+  void add_(const PerfPhase& phase, const Reading& start, const Reading& end,
+            const int64_t& time_ns);
+
+  std::atomic<bool> enabled_{false};
+  std::mutex mutex_;
+  // Uncore memory controller counters (CAS reads and writes of 64 bytes each)
+  std::vector<int> memory_fds_;
+  std::array<Accumulator, static_cast<size_t>(PerfPhase::kNumPhases)> accumulators_;
+};
+
+class PerfScope {
+ public:
+  explicit PerfScope(const PerfPhase& phase);
+  ~PerfScope();
+
+  PerfScope(const PerfScope&) = delete;
+  PerfScope& operator=(const PerfScope&) = delete;
+
+ private:
+  const PerfPhase phase_;
+  bool active_ = false;
+  int64_t start_ns_ = 0;
+  PerfCounters::Reading start_;
+};
+
+}  // namespace utils
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <torch/csrc/jit/codegen/fuser/interface.h>
+#include <torch/csrc/jit/passes/tensorexpr_fuser.h>
+#include <torch/script.h>
+
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+#include "types.h"
+
+namespace utils {
+
+using CompilationUnitPointer = std::shared_ptr<torch::jit::CompilationUnit>;
+
+inline CompilationUnitPointer compile_script(const string& source) {
+  return torch::jit::compile(source);
+}
+
+// Allows the TensorExpr fuser (NNC) to fuse on CPU while any guard is alive. The fuser settings
+// are process-wide: the first guard saves them and the last one restores them, so concurrent
+// scripted steps share a single override.
+class FuserGuard {
+ public:
+  FuserGuard() {
+    const std::lock_guard<std::mutex> lock(state_().mutex);
+    if (state_().count++ > 0) return;
+    state_().can_fuse_on_cpu = torch::jit::canFuseOnCPU();
+    state_().tensor_expr_fuser_enabled = torch::jit::tensorExprFuserEnabled();
+    torch::jit::overrideCanFuseOnCPU(true);
+    torch::jit::setTensorExprFuserEnabled(true);
+  }
+
+  ~FuserGuard() {
+    const std::lock_guard<std::mutex> lock(state_().mutex);
+    if (--state_().count > 0) return;
+    torch::jit::overrideCanFuseOnCPU(state_().can_fuse_on_cpu);
+    torch::jit::setTensorExprFuserEnabled(state_().tensor_expr_fuser_enabled);
+  }
+
+  FuserGuard(const FuserGuard&) = delete;
+  FuserGuard& operator=(const FuserGuard&) = delete;
+
+ private:
+  struct State {
+    std::mutex mutex;
+    unsigned int count = 0;
+    bool can_fuse_on_cpu = false;
+    bool tensor_expr_fuser_enabled = false;
+  };
+
+  static State& state_() {
+    static State state;
+    return state;
+  }
+};
+
+// Float constant spelled so that TorchScript parses it as a float and keeps full precision
+inline string script_literal(const double& value) {
+  std::ostringstream oss;
+  oss << std::setprecision(9) << value;
+  const string literal = oss.str();
+  if (literal.find_first_of(".e") == string::npos) return literal + ".0";
+  return literal;
+}
+
+}  // namespace utils
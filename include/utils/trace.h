@@ -0,0 +1,118 @@
+#pragma once
+
+#include <torch/csrc/autograd/profiler.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "utils/latency_histogram.h"
+#include "utils/types.h"
+
+namespace utils {
+
+// Hot-path phases timed by ScopedSpan
+enum class Span : uint8_t {
+  kAct,
+  kEnvStep,
+  kMemorize,
+  kReset,
+  kProcessStep,
+  kComputeAdvantage,
+  kMinibatchGather,
+  kForward,
+  kBackward,
+  kOptimizerStep,
+  kLogging,
+  kNumSpans
+};
+
+inline int64_t trace_clock_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+// Process-wide span sink. Every span feeds a per-phase histogram; while a capture is active the
+// spans are also appended to a buffer owned by the recording thread, exported as Chrome trace
+// JSON (chrome://tracing, Perfetto). Spans measure host time, CUDA work is asynchronous.
+class Tracer {
+ public:
+  static Tracer& instance();
+
+  void record(const Span& span, const int64_t& start_ns, const int64_t& end_ns);
+
+  void start_capture();
+  bool is_capturing() const { return this->capturing_.load(std::memory_order_relaxed); }
+  // Writes the events captured since start_capture and stops capturing
+  void stop_capture(const string& path);
+
+  // p50 and p99 in milliseconds per phase recorded since the previous call, e.g. "act_p50"
+  std::map<string, float> pop_timings();
+
+ private:
+  struct Event {
+    Span span;
+    int64_t start_ns;
+    int64_t duration_ns;
+  };
+
+  struct ThreadBuffer {
+    std::mutex mutex;
+    std::vector<Event> events;
+    unsigned int thread_id;
+  };
+
+  Tracer() = default;
+  ThreadBuffer& thread_buffer_();
+
+  std::array<LatencyHistogram, static_cast<size_t>(Span::kNumSpans)> histograms_;
+  std::atomic<bool> capturing_{false};
+  int64_t capture_start_ns_ = 0;
+  std::mutex mutex_;
+  // Owned here as well, events of threads that already exited are still exported
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+};
+
+class ScopedSpan {
+ public:
+  explicit ScopedSpan(const Span& span) : span_(span), start_ns_(trace_clock_ns()) {}
+  ~ScopedSpan() { Tracer::instance().record(this->span_, this->start_ns_, trace_clock_ns()); }
+
+  ScopedSpan(const ScopedSpan&) = delete;
+  ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+ private:
+  const Span span_;
+  const int64_t start_ns_;
+};
+
+// Captures the configured iteration windows (start, number of iterations) of a training run into
+// <run_path>/trace_<start>.json, plus the autograd profiler of the learner thread into
+// <run_path>/trace_<start>_autograd.json when enabled
+class TraceSession {
+ public:
+  TraceSession(const string& run_path,
+               const std::vector<std::pair<unsigned int, unsigned int>>& windows,
+               const bool& autograd);
+  ~TraceSession();
+
+  void begin_iteration(const unsigned int& iteration);
+  void end_iteration(const unsigned int& iteration);
+
+ private:
+  void stop_();
+
+  const string run_path_;
+  const std::vector<std::pair<unsigned int, unsigned int>> windows_;
+  const bool autograd_;
+  // Window being captured, windows_.size() when idle
+  size_t active_;
+  std::unique_ptr<torch::autograd::profiler::RecordProfile> profile_;
+};
+
+using TraceSessionPointer = std::unique_ptr<TraceSession>;
+
+}  // namespace utils
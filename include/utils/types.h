@@ -2,6 +2,7 @@
 
 #include <torch/torch.h>
 
+#include <functional>
 #include <map>
 #include <string>
 
@@ -17,6 +18,9 @@ using ListTensor = std::vector<Tensor>;
 using DictTensor = std::unordered_map<string, Tensor>;
 using DictListTensor = std::unordered_map<string, ListTensor>;
 
+// Collective sum across processes, applied in-place
+using AllReduceFn = std::function<void(Tensor&)>;
+
 // NN types
 using NNModule = torch::nn::Module;
 using NN = torch::nn::Sequential;
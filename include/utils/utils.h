@@ -7,6 +7,7 @@
 #include <iostream>
 #include <regex>
 #include <sstream>
+#include <type_traits>
 
 #include "types.h"
 
@@ -32,6 +33,19 @@ inline string formatOutput(const string& name, const float& value, const string&
   return oss.str();
 }
 
+// Key of a parameter in the optimizer state, the tensor impl address or its string form depending
+// on the libtorch version
+template <typename Key>
+inline Key optimizer_state_key(const Tensor& parameter) {
+  if constexpr (std::is_same_v<Key, string>) {
+    std::ostringstream oss;
+    oss << parameter.unsafeGetTensorImpl();
+    return oss.str();
+  } else {
+    return parameter.unsafeGetTensorImpl();
+  }
+}
+
 inline unsigned int last_run_id(const string& path) {
   int id = 0;
   const std::regex pattern_regex(R"(run_(\d+))");
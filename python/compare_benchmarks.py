@@ -0,0 +1,64 @@
+import argparse
+import json
+import sys
+
+
+def load_throughputs(path):
+    """Map benchmark name to items per second, or to 1 / real time when no items are reported."""
+    with open(path) as file:
+        report = json.load(file)
+    throughputs = {}
+    for benchmark in report["benchmarks"]:
+        # Repetition aggregates are compared through their median only
+        if benchmark.get("run_type") == "aggregate" and benchmark.get("aggregate_name") != "median":
+            continue
+        name = benchmark.get("run_name", benchmark["name"])
+        if "items_per_second" in benchmark:
+            throughputs[name] = benchmark["items_per_second"]
+        else:
+            throughputs[name] = 1.0 / benchmark["real_time"]
+    return throughputs
+
+
+def compare(baseline, current, threshold):
+    """Print the relative throughput change of every benchmark, return the regressed names."""
+    regressions = []
+    width = max((len(name) for name in set(baseline) | set(current)), default=0)
+    for name, throughput in sorted(current.items()):
+        if name not in baseline:
+            print(f"{name:<{width}}  new")
+            continue
+        change = throughput / baseline[name] - 1.0
+        regressed = change < -threshold
+        if regressed:
+            regressions.append(name)
+        print(f"{name:<{width}}  {change:+7.1%}{'  REGRESSION' if regressed else ''}")
+    for name in sorted(set(baseline) - set(current)):
+        print(f"{name:<{width}}  missing")
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare cpp_rl_bench JSON results (--benchmark_out=<file>) against a baseline."
+    )
+    parser.add_argument("baseline", help="JSON results of the reference build")
+    parser.add_argument("current", help="JSON results of the build under test")
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=0.05,
+        help="relative throughput drop reported as a regression (default 0.05)",
+    )
+    args = parser.parse_args()
+
+    regressions = compare(
+        load_throughputs(args.baseline), load_throughputs(args.current), args.threshold
+    )
+    if regressions:
+        print(f"{len(regressions)} benchmark(s) regressed by more than {args.threshold:.0%}")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,141 @@
+#include "algorithms/impala.h"
+
+#include <torch/torch.h>
+
+#include <optional>
+
+#include "utils/trace.h"
+
+namespace algorithms {
+
+IMPALA::IMPALA(const configs::CfgPointer& cfg, const Device& device) : cfg_(cfg), device_(device) {
+  this->actor_critic_ = std::make_unique<modules::ActorCritic>(cfg->actor_cfg, cfg->critic_cfg,
+                                                               cfg->ppo_cfg.fused_actor_critic);
+  this->actor_critic_->to(device);
+
+  auto options = torch::optim::AdamOptions(cfg->ppo_cfg.learning_rate);
+  this->optimizer_ =
+    std::make_unique<torch::optim::Adam>(this->actor_critic_->parameters(), options);
+
+  this->publish_snapshot_();
+}
+
+const LossMetrics IMPALA::update(const storage::Trajectory& trajectory) {
+  const int64_t num_steps = trajectory.rewards.size(0);
+  const int64_t num_envs = trajectory.rewards.size(1);
+  const Tensor& actor_obs = trajectory.actor_obs.flatten(0, 1);
+  const Tensor& critic_obs = trajectory.critic_obs.flatten(0, 1);
+
+  {
+    torch::NoGradGuard no_grad;
+    this->actor_critic_->update_normalizers(actor_obs, critic_obs);
+  }
+
+  // Each emplace closes the span of the previous phase, v-trace counts as compute_advantage
+  std::optional<utils::ScopedSpan> span(std::in_place, utils::Span::kForward);
+  const Tensor& values = this->actor_critic_->forward_evaluate(actor_obs, critic_obs)
+                          .second.view({num_steps, num_envs, 1});
+  const modules::DistributionTerms& terms =
+    this->actor_critic_->get_actions_terms(trajectory.actions.flatten(0, 1));
+  const Tensor& log_probs = terms.log_prob.view({num_steps, num_envs, 1});
+  const Tensor& entropy = terms.entropy;
+
+  Tensor log_rhos;
+  Tensor vs;
+  Tensor advantages;
+  span.emplace(utils::Span::kComputeAdvantage);
+  {
+    torch::NoGradGuard no_grad;
+    log_rhos = log_probs.detach() - trajectory.log_probs;
+    const Tensor& bootstrap_values = this->actor_critic_->evaluate(trajectory.last_critic_obs);
+    compute_vtrace(log_rhos, trajectory.rewards, trajectory.dones, values.detach(),
+                   bootstrap_values, this->cfg_->ppo_cfg.gamma, this->cfg_->ppo_cfg.lam,
+                   this->cfg_->impala_cfg.rho_clip, this->cfg_->impala_cfg.c_clip, vs, advantages);
+  }
+
+  span.emplace(utils::Span::kForward);
+  const Tensor& actor_loss = -(advantages * log_probs).mean();
+  const Tensor& critic_loss = (vs - values).square().mean();
+  const Tensor& entropy_loss = entropy.mean();
+  const Tensor& loss = actor_loss + this->cfg_->ppo_cfg.value_loss_coef * critic_loss -
+                       this->cfg_->ppo_cfg.entropy_coef * entropy_loss;
+
+  span.emplace(utils::Span::kBackward);
+  this->optimizer_->zero_grad();
+  loss.backward();
+  span.emplace(utils::Span::kOptimizerStep);
+  torch::nn::utils::clip_grad_norm_(this->actor_critic_->parameters(),
+                                    this->cfg_->ppo_cfg.max_grad_norm);
+  this->optimizer_->step();
+  span.reset();
+
+  this->publish_snapshot_();
+
+  // Sample estimate of KL(behaviour || target)
+  const Tensor& losses = torch::stack({actor_loss.detach(), critic_loss.detach(),
+                                       entropy_loss.detach(), -log_rhos.mean()})
+                           .cpu();
+  const auto& loss_value = losses.accessor<float, 1>();
+  return LossMetrics(loss_value[0], loss_value[1], loss_value[2], loss_value[3]);
+}
+
+storage::ArchiveWriter IMPALA::snapshot_models() const {
+  const storage::ArchiveWriter actor_critic = storage::snapshot_module(*this->actor_critic_);
+  const storage::ArchiveWriter optimizer = storage::snapshot_optimizer(*this->optimizer_);
+
+  return [actor_critic, optimizer](torch::serialize::OutputArchive& archive) {
+    torch::serialize::OutputArchive actor_critic_archive;
+    actor_critic(actor_critic_archive);
+    archive.write("actor_critic", actor_critic_archive);
+
+    torch::serialize::OutputArchive optimizer_archive;
+    optimizer(optimizer_archive);
+    archive.write("optimizer", optimizer_archive);
+  };
+}
+
+void IMPALA::load_models(torch::serialize::InputArchive& archive, const bool& load_optimizer) {
+  torch::serialize::InputArchive actor_critic_archive;
+  archive.read("actor_critic", actor_critic_archive);
+  this->actor_critic_->load(actor_critic_archive);
+
+  if (load_optimizer) {
+    torch::serialize::InputArchive optimizer_archive;
+    archive.read("optimizer", optimizer_archive);
+    this->optimizer_->load(optimizer_archive);
+  }
+  this->publish_snapshot_();
+}
+
+void IMPALA::publish_snapshot_() {
+  const PolicySnapshotPointer& snapshot =
+    std::make_shared<const PolicySnapshot>(++this->version_, this->actor_critic_->get_state());
+  std::atomic_store(&this->snapshot_, snapshot);
+}
+
+void compute_vtrace(const Tensor& log_rhos, const Tensor& rewards, const Tensor& dones,
+                    const Tensor& values, const Tensor& bootstrap_values, const float& gamma,
+                    const float& lam, const float& rho_clip, const float& c_clip, Tensor& vs,
+                    Tensor& advantages) {
+  const int64_t num_steps = values.size(0);
+  const Tensor& rhos = log_rhos.exp();
+  const Tensor& clipped_rhos = rhos.clamp_max(rho_clip);
+  const Tensor& cs = lam * rhos.clamp_max(c_clip);
+  const Tensor& discounts = gamma * (1.f - dones);
+
+  const Tensor& next_values =
+    torch::cat({values.slice(0, 1), bootstrap_values.unsqueeze(0)}, /*dim=*/0);
+  const Tensor& deltas = clipped_rhos * (rewards + discounts * next_values - values);
+
+  vs = torch::empty_like(values);
+  Tensor vs_minus_values = torch::zeros_like(bootstrap_values);
+  for (int64_t step = num_steps - 1; step >= 0; --step) {
+    vs_minus_values = deltas[step] + discounts[step] * cs[step] * vs_minus_values;
+    vs[step].copy_(values[step] + vs_minus_values);
+  }
+
+  const Tensor& next_vs = torch::cat({vs.slice(0, 1), bootstrap_values.unsqueeze(0)}, /*dim=*/0);
+  advantages = clipped_rhos * (rewards + discounts * next_vs - values);
+}
+
+}  // namespace algorithms
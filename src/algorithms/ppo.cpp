@@ -2,13 +2,42 @@
 
 #include <torch/torch.h>
 
+#include <algorithm>
+#include <optional>
+#include <type_traits>
+
+#include "utils/trace.h"
+
 namespace algorithms {
 
-PPO::PPO(const configs::CfgPointer& cfg, const Device& device) : cfg_(cfg), device_(device) {
-  this->actor_critic_ = std::make_unique<modules::ActorCritic>(cfg->actor_cfg, cfg->critic_cfg);
-  this->rollout_storage_ = std::make_unique<storage::RolloutStorage>(cfg, device);
+PPO::PPO(const configs::CfgPointer& cfg, const Device& device,
+         const distributed::ProcessGroupPointer& process_group)
+  : cfg_(cfg),
+    process_group_(process_group),
+    all_reduce_(process_group ? process_group->get_all_reduce() : nullptr),
+    device_(device) {
+  this->actor_critic_ = std::make_unique<modules::ActorCritic>(cfg->actor_cfg, cfg->critic_cfg,
+                                                               cfg->ppo_cfg.fused_actor_critic);
+  this->rollout_storages_[0] =
+    std::make_unique<storage::RolloutStorage>(cfg, device, this->all_reduce_);
+  if (cfg->runner_cfg.overlap_collection) {
+    // Collectives issued from the collection thread would interleave with the gradient ones
+    if (process_group)
+      throw std::invalid_argument("Overlapping collection does not support data-parallel training");
+    this->behaviour_actor_critic_pointer_ =
+      std::make_unique<modules::ActorCritic>(cfg->actor_cfg, cfg->critic_cfg,
+                                             cfg->ppo_cfg.fused_actor_critic);
+    this->rollout_storages_[1] =
+      std::make_unique<storage::RolloutStorage>(cfg, device, this->all_reduce_);
+    this->collection_index_ = 1;
+  }
+  if (cfg->runner_cfg.scripted_step)
+    this->scripted_policy_ =
+      std::make_unique<modules::ScriptedPolicy>(cfg->actor_cfg, cfg->critic_cfg);
 
-  auto options = torch::optim::AdamOptions(cfg->ppo_cfg.learning_rate);
+  // The optimizer holds the Adam options and moments, the step itself runs on device with the
+  // rate kept in learning_rate_ (see optimizer_step_)
+  auto options = torch::optim::AdamOptions(1.0);
   this->optimizer_ =
     std::make_unique<torch::optim::Adam>(this->actor_critic_->parameters(), options);
 
@@ -18,12 +47,23 @@ PPO::PPO(const configs::CfgPointer& cfg, const Device& device) : cfg_(cfg), devi
 void PPO::act(Tensor& actions, const Tensor& actor_obs, const Tensor& critic_obs) {
   this->transition_.actor_obs.copy_(actor_obs);
   this->transition_.critic_obs.copy_(critic_obs);
-  this->transition_.actions.copy_(this->actor_critic_->forward(actor_obs).detach());
-  this->transition_.values.copy_(this->actor_critic_->evaluate(critic_obs).detach());
-  this->transition_.log_probs.copy_(
-    this->actor_critic_->get_actions_log_prob(this->transition_.actions).detach());
-  for (const auto& [key, value] : this->actor_critic_->get_distribution_kl_params())
-    this->transition_.kl_params[key].copy_(value.detach());
+  modules::ActorCritic& actor_critic = this->behaviour_actor_critic_();
+  if (this->scripted_policy_) {
+    const modules::PolicyStep& step =
+      this->scripted_policy_->forward(actor_critic, actor_obs, critic_obs);
+    this->transition_.actions.copy_(step.actions);
+    this->transition_.values.copy_(step.values);
+    this->transition_.log_probs.copy_(step.log_probs);
+    for (const auto& [key, value] : step.kl_params) this->transition_.kl_params[key].copy_(value);
+  } else {
+    const auto& [new_actions, new_values] = actor_critic.forward_evaluate(actor_obs, critic_obs);
+    this->transition_.actions.copy_(new_actions.detach());
+    this->transition_.values.copy_(new_values.detach());
+    this->transition_.log_probs.copy_(
+      actor_critic.get_actions_log_prob(this->transition_.actions).detach());
+    for (const auto& [key, value] : actor_critic.get_distribution_kl_params())
+      this->transition_.kl_params[key].copy_(value.detach());
+  }
 
   actions.copy_(this->transition_.actions);
 }
@@ -35,111 +75,280 @@ void PPO::process_step(const Tensor& rewards, const Tensor& terminated, const Te
   this->transition_.rewards.copy_(bootstrapped_rewards.view({-1, 1}));
   this->transition_.dones.copy_(done.view({-1, 1}));
 
-  this->rollout_storage_->push_back(this->transition_);
+  this->collection_storage_()->push_back(this->transition_);
 }
 
 void PPO::compute_returns(const Tensor critic_obs) {
-  const Tensor& last_values = this->actor_critic_->evaluate(critic_obs).detach();
-  this->rollout_storage_->compute_advantage(last_values, this->cfg_->ppo_cfg.gamma,
+  const Tensor& last_values = this->behaviour_actor_critic_().evaluate(critic_obs).detach();
+  this->collection_storage_()->compute_advantage(last_values, this->cfg_->ppo_cfg.gamma,
                                             this->cfg_->ppo_cfg.lam);
 }
 
 const LossMetrics PPO::update_actor_critic() {
-  Tensor actor_loss = torch::zeros({1}, this->device_);
-  Tensor critic_loss = torch::zeros({1}, this->device_);
-  Tensor entropy_loss = torch::zeros({1}, this->device_);
+  Tensor loss_sums = torch::zeros({3}, this->device_);
   Tensor kl_loss = torch::zeros({1}, this->device_);
+  Tensor num_steps = torch::zeros({1}, this->device_);
+
+  this->update_normalizers_();
 
   std::vector<storage::Transition> batches;
-  this->rollout_storage_->update_batches(batches);
+  {
+    const utils::ScopedSpan span(utils::Span::kMinibatchGather);
+    this->learning_storage_()->update_batches(batches);
+  }
+  this->minibatch_bytes_ = 0;
+  for (const storage::Transition& batch : batches) this->minibatch_bytes_ += batch.memory_bytes();
+
+  const bool early_stopping = this->cfg_->ppo_cfg.max_kl > 0.f;
+  Tensor early_stop =
+    torch::zeros({}, torch::TensorOptions().device(this->device_).dtype(torch::kBool));
+  unsigned int num_updates = 0;
 
   for (const storage::Transition& batch : batches) {
-    this->actor_critic_->forward(batch.actor_obs);
-    const Tensor& new_log_probs = this->actor_critic_->get_actions_log_prob(batch.actions);
-    const Tensor& new_values = this->actor_critic_->evaluate(batch.critic_obs);
-    const Tensor& entropy = this->actor_critic_->get_entropy().mean();
+    // Each emplace closes the span of the previous phase
+    std::optional<utils::ScopedSpan> span(std::in_place, utils::Span::kForward);
+    const Tensor& new_values =
+      this->actor_critic_->forward_evaluate(batch.actor_obs, batch.critic_obs).second;
+    const modules::DistributionTerms& terms =
+      this->actor_critic_->get_actions_terms(batch.actions, batch.kl_params);
+    const Tensor& new_log_probs = terms.log_prob;
+    const Tensor& entropy = terms.entropy;
+    Tensor kl = terms.kl.mean();
+
+    const VariableList& outputs =
+      PPOLoss::apply(new_log_probs, new_values, entropy, batch.log_probs, batch.values,
+                     batch.advantages, batch.rewards, this->cfg_->ppo_cfg);
+
+    span.emplace(utils::Span::kBackward);
+    this->optimizer_->zero_grad();
+    outputs[0].backward();
+    if (this->process_group_) this->all_reduce_gradients_(kl);
 
+    span.emplace(utils::Span::kOptimizerStep);
     {
       torch::NoGradGuard no_grad;
-      float kl = this->actor_critic_->get_kl(batch.kl_params).mean().item<float>();
-      kl_loss += kl;
-
-      if (this->cfg_->ppo_cfg.learning_rate_schedule == "adaptive") {
-        float learning_rate = this->get_learning_rate();
-        if (kl > 2.0f * this->cfg_->ppo_cfg.desired_kl)
-          learning_rate = std::max(this->cfg_->ppo_cfg.min_learning_rate, learning_rate / 1.5f);
-        else if (kl < 0.5f * this->cfg_->ppo_cfg.desired_kl && kl >= 0.0f)
-          learning_rate = std::min(this->cfg_->ppo_cfg.max_learning_rate, learning_rate * 1.5f);
-        this->optimizer_->param_groups()[0].options().set_lr(learning_rate);
-      }
+      // Adapted with the mask from before this minibatch: the one that trips the KL limit still
+      // lowers the learning rate, the frozen ones after it keep their stale KL out of the schedule
+      if (this->cfg_->ppo_cfg.learning_rate_schedule == "adaptive")
+        this->update_learning_rate_(kl, early_stop);
+      if (early_stopping) early_stop.logical_or_(kl > this->cfg_->ppo_cfg.max_kl);
+
+      // Minibatches after the KL limit neither step nor count towards the loss metrics
+      const Tensor& active = early_stop.logical_not().to(torch::kFloat);
+      this->optimizer_step_(active);
+      loss_sums += outputs[1] * active;
+      kl_loss += kl * active;
+      num_steps += active;
     }
 
-    const Tensor& ratio = torch::exp(new_log_probs - batch.log_probs);
-    const Tensor& surrogate = -ratio * batch.advantages;
-    const Tensor& surrogate_clipped =
-      -batch.advantages *
-      ratio.clamp(1.0f - this->cfg_->ppo_cfg.clip_param, 1.0f + this->cfg_->ppo_cfg.clip_param);
-    const Tensor& worst_mean_surrogate_loss = torch::max(surrogate, surrogate_clipped).mean();
-
-    Tensor worst_mean_value_loss;
-    if (this->cfg_->ppo_cfg.use_clipped_value_loss) {
-      const Tensor& value_clipped =
-        batch.values + (new_values - batch.values)
-                         .clamp(-this->cfg_->ppo_cfg.clip_param, this->cfg_->ppo_cfg.clip_param);
-      const Tensor& value_loss = (new_values - batch.rewards).pow(2);
-      const Tensor& value_clipped_loss = (value_clipped - batch.rewards).pow(2);
-      worst_mean_value_loss = torch::max(value_loss, value_clipped_loss).mean();
-    } else
-      worst_mean_value_loss = (new_values - batch.rewards).pow(2).mean();
-
-    const Tensor& loss = worst_mean_surrogate_loss +
-                         this->cfg_->ppo_cfg.value_loss_coef * worst_mean_value_loss -
-                         this->cfg_->ppo_cfg.entropy_coef * entropy;
+    // Single host read per epoch, the minibatches in between are masked on device
+    num_updates++;
+    if (early_stopping && num_updates % this->cfg_->ppo_cfg.num_batches == 0 &&
+        early_stop.item<bool>())
+      break;
+  }
 
-    this->optimizer_->zero_grad();
-    loss.backward();
-    torch::nn::utils::clip_grad_norm_(this->actor_critic_->parameters(),
-                                      this->cfg_->ppo_cfg.max_grad_norm);
-    this->optimizer_->step();
+  this->learning_storage_()->clear();
 
-    {
-      torch::NoGradGuard no_grad;
-      actor_loss += worst_mean_surrogate_loss;
-      critic_loss += worst_mean_value_loss;
-      entropy_loss += entropy;
-    }
-  }
+  const Tensor& loss_means = (torch::cat({loss_sums, kl_loss}) / num_steps.clamp_min(1)).cpu();
+  const auto& loss_mean = loss_means.accessor<float, 1>();
+  return LossMetrics(loss_mean[0], loss_mean[1], loss_mean[2], loss_mean[3]);
+}
 
-  this->rollout_storage_->clear();
+void PPO::swap_rollouts() {
+  // Hand the freshly collected rollout to the learner and refresh the behaviour policy, so the
+  // next rollout lags the learner by at most one update
+  if (!this->behaviour_actor_critic_pointer_) return;
+  std::swap(this->collection_index_, this->learning_index_);
+  this->behaviour_actor_critic_pointer_->set_state(this->actor_critic_->get_state());
+}
 
-  unsigned int num_batches = this->cfg_->ppo_cfg.num_batches * this->cfg_->ppo_cfg.num_epochs;
-  return LossMetrics(actor_loss.item<float>() / num_batches,
-                     critic_loss.item<float>() / num_batches,
-                     entropy_loss.item<float>() / num_batches, kl_loss.item<float>() / num_batches);
+const utils::MemoryReport PPO::memory_report() const {
+  utils::MemoryReport report;
+  int64_t rollout_bytes = 0;
+  for (const storage::RolloutStoragePointer& rollout_storage : this->rollout_storages_)
+    if (rollout_storage) rollout_bytes += rollout_storage->memory_bytes();
+  report.add("rollout_storage", rollout_bytes + this->transition_.memory_bytes());
+  report.add("minibatches", this->minibatch_bytes_);
+  int64_t actor_critic_bytes = utils::module_bytes(*this->actor_critic_);
+  if (this->behaviour_actor_critic_pointer_)
+    actor_critic_bytes += utils::module_bytes(*this->behaviour_actor_critic_pointer_);
+  report.add("actor_critic", actor_critic_bytes);
+  report.add("adam", utils::optimizer_bytes(*this->optimizer_));
+  return report;
 }
 
-void PPO::save_models(torch::serialize::OutputArchive& archive) const {
-  torch::serialize::OutputArchive actor_critic_archive;
-  this->actor_critic_->save(actor_critic_archive);
-  archive.write("actor_critic", actor_critic_archive);
+void PPO::train() {
+  this->actor_critic_->train();
+  if (this->behaviour_actor_critic_pointer_) this->behaviour_actor_critic_pointer_->train();
+}
 
-  torch::serialize::OutputArchive optimizer_archive;
-  this->optimizer_->save(optimizer_archive);
-  archive.write("optimizer", optimizer_archive);
+void PPO::eval() {
+  this->actor_critic_->eval();
+  if (this->behaviour_actor_critic_pointer_) this->behaviour_actor_critic_pointer_->eval();
+}
+
+storage::ArchiveWriter PPO::snapshot_models() const {
+  this->sync_adam_steps_();
+  const storage::ArchiveWriter actor_critic = storage::snapshot_module(*this->actor_critic_);
+  const storage::ArchiveWriter optimizer = storage::snapshot_optimizer(*this->optimizer_);
+  const Tensor learning_rate = this->learning_rate_.cpu().clone();
+
+  return [actor_critic, optimizer, learning_rate](torch::serialize::OutputArchive& archive) {
+    torch::serialize::OutputArchive actor_critic_archive;
+    actor_critic(actor_critic_archive);
+    archive.write("actor_critic", actor_critic_archive);
+
+    torch::serialize::OutputArchive optimizer_archive;
+    optimizer(optimizer_archive);
+    archive.write("optimizer", optimizer_archive);
+    archive.write("learning_rate", learning_rate);
+  };
 }
 
 void PPO::load_models(torch::serialize::InputArchive& archive, const bool& load_optimizer) {
   torch::serialize::InputArchive actor_critic_archive;
   archive.read("actor_critic", actor_critic_archive);
   this->actor_critic_->load(actor_critic_archive);
+  if (this->behaviour_actor_critic_pointer_)
+    this->behaviour_actor_critic_pointer_->set_state(this->actor_critic_->get_state());
 
   if (load_optimizer) {
     torch::serialize::InputArchive optimizer_archive;
     archive.read("optimizer", optimizer_archive);
     this->optimizer_->load(optimizer_archive);
+
+    // Older checkpoints stored the learning rate in the optimizer options only
+    Tensor learning_rate;
+    if (archive.try_read("learning_rate", learning_rate))
+      this->learning_rate_.copy_(learning_rate);
+    else
+      this->learning_rate_.fill_(this->optimizer_->param_groups()[0].options().get_lr());
+    this->optimizer_->param_groups()[0].options().set_lr(1.0);
+    int64_t step = 0;
+    for (const auto& [key, state] : this->optimizer_->state())
+      step = std::max(step, static_cast<torch::optim::AdamParamState&>(*state).step());
+    this->step_count_.fill_(static_cast<float>(step));
   }
 }
 
+void PPO::load_inference_models(const storage::MmapCheckpoint& checkpoint) {
+  checkpoint.load(*this->actor_critic_, modules::kInferencePrefixes);
+  if (this->behaviour_actor_critic_pointer_)
+    this->behaviour_actor_critic_pointer_->set_state(this->actor_critic_->get_state());
+}
+
+void PPO::update_normalizers_() {
+  // Statistics are refreshed once per rollout so that the inputs stay fixed across all minibatches
+  torch::NoGradGuard no_grad;
+  this->actor_critic_->update_normalizers(this->learning_storage_()->get_actor_obs(),
+                                          this->learning_storage_()->get_critic_obs(),
+                                          this->all_reduce_);
+}
+
+void PPO::update_learning_rate_(const Tensor& kl, const Tensor& frozen) {
+  const float& desired_kl = this->cfg_->ppo_cfg.desired_kl;
+  const Tensor& decreased =
+    (this->learning_rate_ / 1.5f).clamp_min(this->cfg_->ppo_cfg.min_learning_rate);
+  const Tensor& increased =
+    (this->learning_rate_ * 1.5f).clamp_max(this->cfg_->ppo_cfg.max_learning_rate);
+  const Tensor& adapted =
+    torch::where(kl > 2.0f * desired_kl, decreased,
+                 torch::where((kl < 0.5f * desired_kl) & (kl >= 0.0f), increased,
+                              this->learning_rate_));
+  this->learning_rate_.copy_(torch::where(frozen, this->learning_rate_, adapted));
+}
+
+void PPO::optimizer_step_(const Tensor& active) {
+  // Adam with the gradient clipping, the learning rate and the step count on device, so that no
+  // minibatch syncs with the host. An inactive step leaves parameters, moments and count unchanged.
+  const torch::optim::AdamOptions& options =
+    static_cast<const torch::optim::AdamOptions&>(this->optimizer_->param_groups()[0].options());
+  const auto& [beta1, beta2] = options.betas();
+  const ListTensor& parameters = this->optimizer_->param_groups()[0].params();
+
+  ListTensor gradients;
+  for (const Tensor& parameter : parameters)
+    if (parameter.grad().defined()) gradients.push_back(parameter.grad());
+  if (gradients.empty()) return;
+  const Tensor& total_norm = torch::stack(torch::_foreach_norm(gradients)).norm();
+  const Tensor& clip_coefficient =
+    (this->cfg_->ppo_cfg.max_grad_norm / (total_norm + 1e-6)).clamp_max(1.0);
+  for (Tensor& gradient : gradients) gradient.mul_(clip_coefficient);
+
+  this->step_count_ += active;
+  // Clamped so that a masked first step does not divide by zero
+  const Tensor& step_count = this->step_count_.clamp_min(1.0);
+  const Tensor& bias_correction1 = 1.0 - torch::pow(beta1, step_count);
+  const Tensor& bias_correction2_sqrt = (1.0 - torch::pow(beta2, step_count)).sqrt();
+  const Tensor& step_size = this->learning_rate_ * active / bias_correction1;
+  const Tensor& beta1_weight = (1.0 - beta1) * active;
+  const Tensor& beta2_weight = (1.0 - beta2) * active;
+
+  for (const Tensor& parameter : parameters) {
+    const Tensor& gradient = parameter.grad();
+    if (!gradient.defined()) continue;
+    torch::optim::AdamParamState& state = this->adam_state_(parameter);
+    state.exp_avg().lerp_(gradient, beta1_weight);
+    state.exp_avg_sq().lerp_(gradient.square(), beta2_weight);
+    const Tensor& denominator =
+      (state.exp_avg_sq().sqrt() / bias_correction2_sqrt).add_(options.eps());
+    parameter.sub_(state.exp_avg() / denominator * step_size);
+  }
+}
+
+torch::optim::AdamParamState& PPO::adam_state_(const Tensor& parameter) {
+  auto& states = this->optimizer_->state();
+  auto& state = states[utils::optimizer_state_key<typename std::decay_t<decltype(states)>::key_type>(parameter)];
+  if (!state) {
+    auto new_state = std::make_unique<torch::optim::AdamParamState>();
+    new_state->step(0);
+    new_state->exp_avg(torch::zeros_like(parameter, torch::MemoryFormat::Preserve));
+    new_state->exp_avg_sq(torch::zeros_like(parameter, torch::MemoryFormat::Preserve));
+    state = std::move(new_state);
+  }
+  return static_cast<torch::optim::AdamParamState&>(*state);
+}
+
+void PPO::sync_adam_steps_() const {
+  // The optimizer state serializes the host step count
+  const int64_t step = static_cast<int64_t>(this->step_count_.item<float>());
+  for (const auto& [key, state] : this->optimizer_->state())
+    static_cast<torch::optim::AdamParamState&>(*state).step(step);
+}
+
+void PPO::all_reduce_gradients_(Tensor& kl) {
+  // One collective per minibatch: the flattened gradients with the minibatch KL appended, so that
+  // every process takes the same step and adapts the learning rate identically
+  torch::NoGradGuard no_grad;
+  const ListTensor& parameters = this->optimizer_->param_groups()[0].params();
+  ListTensor flat_tensors;
+  for (const Tensor& parameter : parameters) {
+    if (!parameter.grad().defined()) parameter.mutable_grad() = torch::zeros_like(parameter);
+    flat_tensors.push_back(parameter.grad().view(-1));
+  }
+  flat_tensors.push_back(kl.view(-1));
+
+  Tensor flat = torch::cat(flat_tensors);
+  this->process_group_->all_reduce(flat);
+  flat.div_(this->process_group_->get_world_size());
+
+  int64_t offset = 0;
+  for (const Tensor& parameter : parameters) {
+    const int64_t size = parameter.numel();
+    parameter.grad().view(-1).copy_(flat.slice(0, offset, offset + size));
+    offset += size;
+  }
+  kl = flat[offset];
+}
+
+void PPO::broadcast_models_() {
+  torch::NoGradGuard no_grad;
+  for (Tensor parameter : this->actor_critic_->parameters())
+    this->process_group_->broadcast(parameter);
+  for (Tensor buffer : this->actor_critic_->buffers()) this->process_group_->broadcast(buffer);
+}
+
 void PPO::initialize_() {
   DictTensor zero_kl_params;
   int num_envs = this->cfg_->env_cfg.num_envs;
@@ -161,8 +370,18 @@ void PPO::initialize_() {
   this->transition_.log_probs = torch::zeros({num_envs, 1}, this->device_);
   this->transition_.kl_params = zero_kl_params;
 
-  this->rollout_storage_->initialize(zero_kl_params);
+  for (const storage::RolloutStoragePointer& rollout_storage : this->rollout_storages_)
+    if (rollout_storage) rollout_storage->initialize(zero_kl_params);
   this->actor_critic_->to(this->device_);
+
+  if (this->process_group_) this->broadcast_models_();
+  if (this->behaviour_actor_critic_pointer_) {
+    this->behaviour_actor_critic_pointer_->to(this->device_);
+    this->behaviour_actor_critic_pointer_->set_state(this->actor_critic_->get_state());
+  }
+
+  this->learning_rate_ = torch::full({}, this->cfg_->ppo_cfg.learning_rate, this->device_);
+  this->step_count_ = torch::zeros({}, this->device_);
 }
 
 }  // namespace algorithms
\ No newline at end of file
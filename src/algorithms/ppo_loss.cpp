@@ -0,0 +1,144 @@
+#include "algorithms/ppo_loss.h"
+
+#include <algorithm>
+
+namespace algorithms {
+
+namespace {
+
+// Single pass over the minibatch: losses and their gradients per unit upstream gradient
+void fused_cpu_(const Tensor& log_probs, const Tensor& values, const Tensor& old_log_probs,
+                const Tensor& old_values, const Tensor& advantages, const Tensor& returns,
+                const configs::PPOCfg& cfg, Tensor& grad_log_probs, Tensor& grad_values,
+                double& surrogate_sum, double& value_sum) {
+  const int64_t size = log_probs.numel();
+  const float inv_size = 1.f / size;
+  const float clip = cfg.clip_param;
+
+  const float* log_prob = log_probs.data_ptr<float>();
+  const float* value = values.data_ptr<float>();
+  const float* old_log_prob = old_log_probs.data_ptr<float>();
+  const float* old_value = old_values.data_ptr<float>();
+  const float* advantage = advantages.data_ptr<float>();
+  const float* target = returns.data_ptr<float>();
+  float* grad_log_prob = grad_log_probs.data_ptr<float>();
+  float* grad_value = grad_values.data_ptr<float>();
+
+  for (int64_t i = 0; i < size; ++i) {
+    const float ratio = std::exp(log_prob[i] - old_log_prob[i]);
+    const float surrogate = -advantage[i] * ratio;
+    const float surrogate_clipped = -advantage[i] * std::clamp(ratio, 1.f - clip, 1.f + clip);
+    // The clipped branch only wins when the ratio is outside the trust region: no gradient
+    if (surrogate >= surrogate_clipped) {
+      surrogate_sum += surrogate;
+      grad_log_prob[i] = surrogate * inv_size;
+    } else {
+      surrogate_sum += surrogate_clipped;
+      grad_log_prob[i] = 0.f;
+    }
+
+    const float error = value[i] - target[i];
+    const float value_loss = error * error;
+    if (cfg.use_clipped_value_loss) {
+      const float value_change = value[i] - old_value[i];
+      const float clipped_error = old_value[i] + std::clamp(value_change, -clip, clip) - target[i];
+      const float value_clipped_loss = clipped_error * clipped_error;
+      if (value_loss >= value_clipped_loss) {
+        value_sum += value_loss;
+        grad_value[i] = 2.f * cfg.value_loss_coef * error * inv_size;
+      } else {
+        // Inside the clip range the clipped branch differs by rounding only and keeps the gradient
+        value_sum += value_clipped_loss;
+        grad_value[i] = std::abs(value_change) <= clip
+                          ? 2.f * cfg.value_loss_coef * clipped_error * inv_size
+                          : 0.f;
+      }
+    } else {
+      value_sum += value_loss;
+      grad_value[i] = 2.f * cfg.value_loss_coef * error * inv_size;
+    }
+  }
+}
+
+void fused_generic_(const Tensor& log_probs, const Tensor& values, const Tensor& old_log_probs,
+                    const Tensor& old_values, const Tensor& advantages, const Tensor& returns,
+                    const configs::PPOCfg& cfg, Tensor& grad_log_probs, Tensor& grad_values,
+                    Tensor& surrogate_mean, Tensor& value_mean) {
+  const float inv_size = 1.f / log_probs.numel();
+
+  const Tensor& ratio = torch::exp(log_probs - old_log_probs);
+  const Tensor& surrogate = -advantages * ratio;
+  const Tensor& surrogate_clipped =
+    -advantages * ratio.clamp(1.f - cfg.clip_param, 1.f + cfg.clip_param);
+  const Tensor& unclipped = surrogate >= surrogate_clipped;
+  surrogate_mean = torch::where(unclipped, surrogate, surrogate_clipped).mean();
+  grad_log_probs = surrogate.masked_fill(unclipped.logical_not(), 0.f) * inv_size;
+
+  const Tensor& error = values - returns;
+  const Tensor& value_loss = error.square();
+  if (cfg.use_clipped_value_loss) {
+    const Tensor& value_change = values - old_values;
+    const Tensor& clipped_error =
+      old_values + value_change.clamp(-cfg.clip_param, cfg.clip_param) - returns;
+    const Tensor& value_clipped_loss = clipped_error.square();
+    const Tensor& unclipped_value = value_loss >= value_clipped_loss;
+    value_mean = torch::where(unclipped_value, value_loss, value_clipped_loss).mean();
+    // Inside the clip range the clipped branch differs by rounding only and keeps the gradient
+    const Tensor& clipped_gradient =
+      clipped_error.masked_fill(value_change.abs() > cfg.clip_param, 0.f);
+    grad_values = torch::where(unclipped_value, error, clipped_gradient) *
+                  (2.f * cfg.value_loss_coef * inv_size);
+  } else {
+    value_mean = value_loss.mean();
+    grad_values = error * (2.f * cfg.value_loss_coef * inv_size);
+  }
+}
+
+}  // namespace
+
+VariableList PPOLoss::forward(AutogradContext* ctx, const Tensor& log_probs, const Tensor& values,
+                              const Tensor& entropy, const Tensor& old_log_probs,
+                              const Tensor& old_values, const Tensor& advantages,
+                              const Tensor& returns, const configs::PPOCfg& cfg) {
+  Tensor grad_log_probs;
+  Tensor grad_values;
+  Tensor surrogate_mean;
+  Tensor value_mean;
+
+  const bool cpu_kernel = log_probs.device().is_cpu() &&
+                          log_probs.scalar_type() == torch::kFloat &&
+                          values.scalar_type() == torch::kFloat;
+  if (cpu_kernel) {
+    grad_log_probs = torch::empty_like(log_probs, torch::MemoryFormat::Contiguous);
+    grad_values = torch::empty_like(values, torch::MemoryFormat::Contiguous);
+    double surrogate_sum = 0.;
+    double value_sum = 0.;
+    fused_cpu_(log_probs.contiguous(), values.contiguous(), old_log_probs.contiguous(),
+               old_values.contiguous(), advantages.contiguous(), returns.contiguous(), cfg,
+               grad_log_probs, grad_values, surrogate_sum, value_sum);
+    surrogate_mean = torch::full({}, surrogate_sum / log_probs.numel(), log_probs.options());
+    value_mean = torch::full({}, value_sum / values.numel(), values.options());
+  } else
+    fused_generic_(log_probs, values, old_log_probs, old_values, advantages, returns, cfg,
+                   grad_log_probs, grad_values, surrogate_mean, value_mean);
+
+  const Tensor& entropy_mean = entropy.mean();
+  const Tensor& grad_entropy = torch::full_like(entropy, -cfg.entropy_coef / entropy.numel());
+  ctx->save_for_backward({grad_log_probs, grad_values, grad_entropy});
+
+  const Tensor& loss =
+    surrogate_mean + cfg.value_loss_coef * value_mean - cfg.entropy_coef * entropy_mean;
+  const Tensor& metrics = torch::stack({surrogate_mean, value_mean, entropy_mean});
+  ctx->mark_non_differentiable({metrics});
+  return {loss, metrics};
+}
+
+VariableList PPOLoss::backward(AutogradContext* ctx, VariableList grad_outputs) {
+  const VariableList& saved = ctx->get_saved_variables();
+  const Tensor& grad_loss = grad_outputs[0];
+  // Only the fresh log-probs, values and entropy are differentiable
+  return {saved[0] * grad_loss, saved[1] * grad_loss, saved[2] * grad_loss, Tensor(), Tensor(),
+          Tensor(), Tensor(), Tensor()};
+}
+
+}  // namespace algorithms
@@ -0,0 +1,84 @@
+#include "distributed/process_group.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <iostream>
+
+#ifdef USE_C10D_GLOO
+#include <torch/csrc/distributed/c10d/ProcessGroupGloo.hpp>
+#include <torch/csrc/distributed/c10d/TCPStore.hpp>
+#endif
+
+namespace distributed {
+
+WorkerGroup::WorkerGroup(const unsigned int& world_size) {
+  for (unsigned int rank = 1; rank < world_size; ++rank) {
+    const pid_t pid = fork();
+    if (pid < 0) throw std::runtime_error("Failed to fork worker " + std::to_string(rank));
+    if (pid == 0) {
+      // A worker owns no other process
+      this->rank_ = rank;
+      this->workers_.clear();
+      return;
+    }
+    this->workers_.push_back(pid);
+  }
+}
+
+WorkerGroup::~WorkerGroup() {
+  for (const pid_t& pid : this->workers_) kill(pid, SIGTERM);
+  for (const pid_t& pid : this->workers_) waitpid(pid, nullptr, 0);
+}
+
+void WorkerGroup::join() {
+  for (const pid_t& pid : this->workers_) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      std::cout << "Error: Worker " << pid << " exited abnormally" << std::endl;
+  }
+  this->workers_.clear();
+}
+
+ProcessGroup::ProcessGroup(const configs::DistributedCfg& cfg)
+  : rank_(cfg.rank), world_size_(cfg.world_size) {
+#ifdef USE_C10D_GLOO
+  c10d::TCPStoreOptions store_options;
+  store_options.port = static_cast<std::uint16_t>(cfg.master_port);
+  store_options.isServer = cfg.is_main();
+  store_options.numWorkers = cfg.world_size;
+  this->store_ = c10::make_intrusive<c10d::TCPStore>("127.0.0.1", store_options);
+
+  auto options = c10d::ProcessGroupGloo::Options::create();
+  options->devices.push_back(c10d::ProcessGroupGloo::createDeviceForHostname("127.0.0.1"));
+  this->backend_ = c10::make_intrusive<c10d::ProcessGroupGloo>(this->store_, cfg.rank,
+                                                               cfg.world_size, options);
+#else
+  throw std::runtime_error("Data-parallel training requires building with -DUSE_GLOO=ON");
+#endif
+}
+
+// Without gloo the constructor throws, the collectives below are never reached
+#ifdef USE_C10D_GLOO
+void ProcessGroup::all_reduce(Tensor& tensor) const {
+  std::vector<Tensor> tensors{tensor};
+  this->backend_->allreduce(tensors)->wait();
+}
+
+void ProcessGroup::broadcast(Tensor& tensor, const unsigned int& root) const {
+  std::vector<Tensor> tensors{tensor};
+  c10d::BroadcastOptions options;
+  options.rootRank = root;
+  this->backend_->broadcast(tensors, options)->wait();
+}
+
+void ProcessGroup::barrier() const { this->backend_->barrier()->wait(); }
+#else
+void ProcessGroup::all_reduce(Tensor& tensor) const {}
+void ProcessGroup::broadcast(Tensor& tensor, const unsigned int& root) const {}
+void ProcessGroup::barrier() const {}
+#endif
+
+}  // namespace distributed
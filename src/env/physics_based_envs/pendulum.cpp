@@ -107,6 +107,36 @@ void PendulumEnv::update_rewards_(Results& results) {
   results.rewards.copy_(-(theta_error + 0.1f * theta_dot_error + 0.001f * torque_error));
 }
 
+string PendulumEnv::model_script_() const {
+  // Same model as update_state_, update_actor_obs_ and update_rewards_
+  const string max_action = utils::script_literal(this->max_action_);
+  const string max_theta_dot = utils::script_literal(this->max_theta_dot_);
+  return "def actuate(action: Tensor) -> Tensor:\n"
+         "    return torch.clamp(action.select(1, 0), -" + max_action + ", " + max_action + ")\n"
+         "\n"
+         "def dynamics(state: Tensor, torque: Tensor) -> Tensor:\n"
+         "    theta_ddot = " + utils::script_literal(3.f / this->l_) + " * (" +
+         utils::script_literal(this->g_ / 2.f) + " * torch.sin(state.select(1, 0)) + " +
+         utils::script_literal(1.f / (this->m_ * this->l_)) + " * torque)\n"
+         "    return torch.stack([state.select(1, 1), theta_ddot], 1)\n"
+         "\n"
+         "def constrain(state: Tensor) -> Tensor:\n"
+         "    theta_dot = torch.clamp(state.select(1, 1), -" + max_theta_dot + ", " +
+         max_theta_dot + ")\n"
+         "    return torch.stack([state.select(1, 0), theta_dot], 1)\n"
+         "\n"
+         "def observe(state: Tensor, torque: Tensor) -> Tuple[Tensor, Tensor, Tensor, Tensor]:\n"
+         "    theta = state.select(1, 0)\n"
+         "    theta_dot = state.select(1, 1)\n"
+         "    actor_obs = torch.stack([torch.cos(theta), torch.sin(theta), theta_dot], 1)\n"
+         "    normalized_theta = torch.remainder(theta + " + utils::script_literal(M_PI) + ", " +
+         utils::script_literal(2.f * M_PI) + ") - " + utils::script_literal(M_PI) + "\n"
+         "    rewards = -(normalized_theta * normalized_theta + 0.1 * theta_dot * theta_dot + "
+         "0.001 * torque * torque)\n"
+         "    terminated = torch.zeros_like(theta, dtype=torch.bool)\n"
+         "    return actor_obs, actor_obs.clone(), terminated, rewards\n";
+}
+
 const Tensor PendulumEnv::normalized_theta_() const {
   const Tensor theta = this->state_.select(1, 0);
   return torch::remainder(theta + M_PI, 2.f * M_PI) - M_PI;
@@ -131,6 +131,40 @@ void PendulumCartEnv::update_terminated_(Results& results) {
   results.terminated.copy_(x.abs() > this->max_x_);
 }
 
+string PendulumCartEnv::model_script_() const {
+  // Same model as update_state_, update_actor_obs_, update_terminated_ and update_rewards_
+  const string max_action = utils::script_literal(this->max_action_);
+  const string total_mass = utils::script_literal(this->total_mass_);
+  const string factor = utils::script_literal(this->factor_);
+  return "def actuate(action: Tensor) -> Tensor:\n"
+         "    return torch.clamp(action.select(1, 0), -" + max_action + ", " + max_action + ")\n"
+         "\n"
+         "def dynamics(state: Tensor, force: Tensor) -> Tensor:\n"
+         "    theta_dot = state.select(1, 2)\n"
+         "    sin_theta = torch.sin(state.select(1, 0))\n"
+         "    cos_theta = torch.cos(state.select(1, 0))\n"
+         "    theta_ddot = ((" + total_mass + " * " + utils::script_literal(this->g_) + " - " +
+         factor + " * theta_dot * theta_dot * cos_theta) * sin_theta - cos_theta * force) / (" +
+         utils::script_literal(2.f / 3.f * this->l_) + " * " + total_mass + " - " + factor +
+         " * cos_theta * cos_theta)\n"
+         "    x_ddot = (force + " + factor + " * (theta_dot * theta_dot * sin_theta - theta_ddot * "
+         "cos_theta)) / " + total_mass + "\n"
+         "    return torch.stack([theta_dot, state.select(1, 3), theta_ddot, x_ddot], 1)\n"
+         "\n"
+         "def constrain(state: Tensor) -> Tensor:\n"
+         "    return state\n"
+         "\n"
+         "def observe(state: Tensor, force: Tensor) -> Tuple[Tensor, Tensor, Tensor, Tensor]:\n"
+         "    theta = state.select(1, 0)\n"
+         "    x = state.select(1, 1)\n"
+         "    actor_obs = torch.stack([torch.cos(theta), torch.sin(theta), state.select(1, 2), x, "
+         "state.select(1, 3)], 1)\n"
+         "    terminated = torch.abs(x) > " + utils::script_literal(this->max_x_) + "\n"
+         "    rewards = torch.cos(theta) - 10.0 * terminated.float() - 0.1 * x * x - 0.001 * force "
+         "* force\n"
+         "    return actor_obs, actor_obs.clone(), terminated, rewards\n";
+}
+
 const Tensor PendulumCartEnv::normalized_theta_() const {
   const Tensor theta = this->state_.select(1, 0);
   return torch::remainder(theta + M_PI, 2.f * M_PI) - M_PI;
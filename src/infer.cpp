@@ -0,0 +1,68 @@
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "inference/policy_evaluator.h"
+
+// Shapes come from the cmake flags printed by `cpp_rl export <task>`
+#ifndef CPP_RL_INFER_ACTIVATION
+#define CPP_RL_INFER_ACTIVATION "elu"
+#endif
+#ifndef CPP_RL_INFER_LAYER_SIZES
+#define CPP_RL_INFER_LAYER_SIZES 3, 16, 16, 16, 1
+#endif
+
+using Evaluator =
+  inference::PolicyEvaluator<inference::to_activation(CPP_RL_INFER_ACTIVATION),
+                             CPP_RL_INFER_LAYER_SIZES>;
+
+void benchmark(const Evaluator& evaluator, const int& iterations) {
+  std::array<float, Evaluator::kNumInputs> observations{};
+  std::array<float, Evaluator::kNumActions> actions{};
+  const auto start_time = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    observations[0] = static_cast<float>(i % 64) / 64.f;
+    evaluator.act(observations.data(), actions.data());
+  }
+  const double time =
+    std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+  std::cout << "Latency: " << time / iterations << " ns per observation (last action "
+            << actions[0] << ")" << std::endl;
+}
+
+// Usage: cpp_rl_infer <policy.bin> [--benchmark <iterations>]
+// Reads one observation per line from stdin and writes one action per line to stdout.
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <policy.bin> [--benchmark <iterations>]" << std::endl;
+    return 1;
+  }
+
+  const auto start_time = std::chrono::steady_clock::now();
+  const auto& evaluator = Evaluator::create(argv[1]);
+  const double startup_time =
+    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+  if (argc >= 4 && std::string_view(argv[2]) == "--benchmark") {
+    std::cout << "Startup: " << startup_time << " ms" << std::endl;
+    benchmark(*evaluator, std::stoi(argv[3]));
+    return 0;
+  }
+
+  std::array<float, Evaluator::kNumInputs> observations{};
+  std::array<float, Evaluator::kNumActions> actions{};
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    std::istringstream stream(line);
+    for (float& observation : observations) stream >> observation;
+    if (!stream) {
+      std::cerr << "Expected " << Evaluator::kNumInputs << " observations per line" << std::endl;
+      return 1;
+    }
+    evaluator->act(observations.data(), actions.data());
+    for (size_t i = 0; i < actions.size(); ++i) std::cout << (i ? " " : "") << actions[i];
+    std::cout << std::endl;
+  }
+}
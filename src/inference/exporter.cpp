@@ -0,0 +1,62 @@
+#include "inference/exporter.h"
+
+#include <torch/torch.h>
+
+namespace inference {
+
+namespace {
+
+std::vector<float> to_vector_(const Tensor& tensor) {
+  const Tensor& values = tensor.detach().to(torch::kCPU, torch::kFloat).contiguous();
+  return std::vector<float>(values.data_ptr<float>(), values.data_ptr<float>() + values.numel());
+}
+
+}  // namespace
+
+const PolicyFile to_policy_file(const modules::ActorCritic& actor_critic,
+                                const configs::ActorCfg& actor_cfg) {
+  const modules::ActorPointer& actor = actor_critic.get_actor();
+  PolicyFile policy;
+  policy.activation = to_activation(actor_cfg.mlp_cfg.activation);
+  if (actor_cfg.distribution_cfg.type == "normal")
+    policy.distribution = Distribution::Normal;
+  else if (actor_cfg.distribution_cfg.type == "beta")
+    policy.distribution = Distribution::Beta;
+  else
+    throw std::invalid_argument("Unknown distribution type: " + actor_cfg.distribution_cfg.type);
+
+  const auto& layers = actor->get_network()->get_layers();
+  policy.sizes.push_back(layers.front()->options.in_features());
+  for (const torch::nn::Linear& layer : layers) {
+    policy.sizes.push_back(layer->options.out_features());
+    policy.weights.push_back(to_vector_(layer->weight));
+    policy.biases.push_back(to_vector_(layer->bias));
+  }
+
+  // Empirical normalizer buffers are [mean, var], the identity one has none
+  const ListTensor& statistics = actor->get_normalizer()->buffers();
+  policy.normalize = !statistics.empty();
+  policy.mean = policy.normalize ? to_vector_(statistics[0])
+                                 : std::vector<float>(policy.sizes.front(), 0.f);
+  policy.var = policy.normalize ? to_vector_(statistics[1])
+                                : std::vector<float>(policy.sizes.front(), 1.f);
+
+  policy.std = to_vector_(actor->get_std());
+  policy.action_min = to_vector_(actor_cfg.distribution_cfg.action_min);
+  policy.action_max = to_vector_(actor_cfg.distribution_cfg.action_max);
+  return policy;
+}
+
+const string export_policy(const modules::ActorCritic& actor_critic,
+                           const configs::ActorCfg& actor_cfg, const string& path) {
+  const PolicyFile& policy = to_policy_file(actor_critic, actor_cfg);
+  policy.save(path);
+
+  string sizes;
+  for (const uint32_t& size : policy.sizes)
+    sizes += (sizes.empty() ? "" : ",") + std::to_string(size);
+  return "-DINFER_ACTIVATION=" + string(activation_name(policy.activation)) +
+         " -DINFER_LAYER_SIZES=" + sizes;
+}
+
+}  // namespace inference
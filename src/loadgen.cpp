@@ -0,0 +1,63 @@
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "server/policy_client.h"
+#include "utils/latency_histogram.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Closed loop: every client sends its next observation as soon as the previous action arrived
+void run_level(const std::string& socket_path, const unsigned int& num_clients,
+               const double& duration) {
+  utils::LatencyHistogram latencies;
+  std::atomic<bool> running{true};
+  std::vector<std::thread> clients;
+  for (unsigned int c = 0; c < num_clients; ++c)
+    clients.emplace_back([&socket_path, &latencies, &running, c] {
+      server::PolicyClient client(socket_path);
+      std::mt19937 generator(c);
+      std::normal_distribution<float> distribution;
+      std::vector<float> observations(client.num_inputs());
+      std::vector<float> actions(client.num_actions());
+      while (running) {
+        for (float& observation : observations) observation = distribution(generator);
+        const Clock::time_point start_time = Clock::now();
+        client.act(observations.data(), actions.data());
+        latencies.record(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time).count());
+      }
+    });
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+  running = false;
+  for (std::thread& client : clients) client.join();
+
+  std::cout << std::setw(8) << num_clients << std::setw(14) << std::fixed << std::setprecision(0)
+            << latencies.count() / duration << std::setw(12) << std::setprecision(1)
+            << latencies.percentile(0.5) / 1e3 << std::setw(12) << latencies.percentile(0.99) / 1e3
+            << std::endl;
+}
+
+// Usage: cpp_rl_loadgen <socket_path> [max_clients] [seconds_per_level]
+// Sweeps 1, 2, 4, ... max_clients concurrent clients against a running `cpp_rl serve <task>`.
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <socket_path> [max_clients] [seconds_per_level]"
+              << std::endl;
+    return 1;
+  }
+  const std::string socket_path = argv[1];
+  const unsigned int max_clients = argc > 2 ? std::stoul(argv[2]) : 64;
+  const double duration = argc > 3 ? std::stod(argv[3]) : 5.0;
+
+  std::cout << std::setw(8) << "clients" << std::setw(14) << "requests/s" << std::setw(12)
+            << "p50 [us]" << std::setw(12) << "p99 [us]" << std::endl;
+  for (unsigned int num_clients = 1; num_clients <= max_clients; num_clients *= 2)
+    run_level(socket_path, num_clients, duration);
+}
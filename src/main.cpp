@@ -1,13 +1,23 @@
 #include <torch/cuda.h>
 #include <torch/torch.h>
 
+#include <algorithm>
+#include <atomic>
+#include <csignal>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <thread>
 
 #include "configs/load_yaml.h"
+#include "distributed/process_group.h"
 #include "env/env.h"
+#include "runners/async_runner.h"
 #include "runners/on_policy_runner.h"
+#include "runners/sweep.h"
+#include "runners/target_benchmark.h"
+#include "server/policy_server.h"
 #include "utils/types.h"
 #include "utils/utils.h"
 
@@ -37,17 +47,51 @@ void create_run_folder(const string& task) {
   std::filesystem::create_directories(run_folder);
 }
 
+std::atomic<bool> stop_requested{false};
+void request_stop(int) { stop_requested = true; }
+
 void copy_yaml(const string& task) {
   const string run_path = utils::get_run_path(task);
   std::filesystem::copy("yaml/train.yaml", run_path + "/config.yaml");
 }
 
 int main(int argc, char* argv[]) {
-  bool playing = string(argv[1]) == "play";
+  const string& mode = string(argv[1]);
+  // Exporting, quantizing and serving reload the trained run the same way playing does
+  bool exporting = mode == "export";
+  bool quantizing = mode == "quantize";
+  bool serving = mode == "serve";
+  bool playing = mode == "play" || exporting || quantizing || serving;
   const string& task = string(argv[2]);
 
-  const Device& device = torch::cuda::is_available() ? torch::kCUDA : torch::kCPU;
-  std::cout << "Device: " << device << std::endl;
+  // Predicts the memory of an on-policy training run from yaml/train.yaml, nothing is trained
+  if (mode == "dry_run") {
+    std::filesystem::create_directories("data/" + task);
+    std::cout << "-------Loading Cfg-------" << std::endl;
+    const configs::CfgPointer& cfg = configs::load_config(task, false);
+    std::cout << "-------Predicted Memory (per process)-------" << std::endl;
+    std::cout << runners::OnPolicyRunner::predict_memory(task, cfg);
+    return 0;
+  }
+
+  // Scaling report over the combinations of a sweep file, no run folder is created
+  if (mode == "sweep") {
+    std::filesystem::create_directories("data/" + task);
+    const Device& device = torch::cuda::is_available() ? torch::kCUDA : torch::kCPU;
+    std::cout << "-------Sweep-------" << std::endl;
+    runners::run_sweep(task, argc > 3 ? string(argv[3]) : "yaml/sweep.yaml", device);
+    return 0;
+  }
+
+  // Wall-clock and env steps to a target reward over several seeds, no run folder is created
+  if (mode == "benchmark") {
+    std::filesystem::create_directories("data/" + task);
+    const Device& device = torch::cuda::is_available() ? torch::kCUDA : torch::kCPU;
+    std::cout << "-------Benchmark-------" << std::endl;
+    runners::run_target_benchmark(task, argc > 3 ? string(argv[3]) : "yaml/benchmark.yaml",
+                                  device);
+    return 0;
+  }
 
   if (playing)
     check_task_folder(task);
@@ -55,22 +99,69 @@ int main(int argc, char* argv[]) {
     create_run_folder(task);
 
   std::cout << "-------Loading Cfg-------" << std::endl;
-  const configs::CfgPointer& cfg = configs::load_config(task, playing);
+  configs::CfgPointer cfg = configs::load_config(task, playing);
+
+  // Workers are forked before libtorch starts any thread, each one loads its own env shard. Only
+  // on-policy training is data-parallel, every other mode runs in a single process.
+  std::optional<distributed::WorkerGroup> workers;
+  distributed::ProcessGroupPointer process_group;
+  const unsigned int world_size = cfg->distributed_cfg.world_size;
+  if (world_size > 1 && !playing && cfg->runner_cfg.type == "on_policy") {
+    workers.emplace(world_size);
+    const unsigned int rank = workers->get_rank();
+    if (rank > 0) cfg = configs::load_config(task, playing, rank);
+    torch::set_num_threads(std::max(1u, std::thread::hardware_concurrency() / world_size));
+    process_group = std::make_shared<distributed::ProcessGroup>(cfg->distributed_cfg);
+  }
+
+  const Device& device = torch::cuda::is_available() ? torch::kCUDA : torch::kCPU;
+  std::cout << "Device: " << device << std::endl;
+
+  if (!playing && cfg->runner_cfg.type == "impala") {
+    std::cout << "-------Creating Runner-------" << std::endl;
+    const runners::AsyncRunnerPointer& runner =
+      std::make_unique<runners::AsyncRunner>(task, cfg, device);
+    std::cout << "-------Train-------" << std::endl;
+    runner->learn();
+    std::cout << "-------Copy Yaml-------" << std::endl;
+    copy_yaml(task);
+    return 0;
+  }
 
   std::cout << "-------Creating Runner-------" << std::endl;
   const runners::RunnerPointer& runner =
-    std::make_unique<runners::OnPolicyRunner>(task, cfg, device);
+    std::make_unique<runners::OnPolicyRunner>(task, cfg, device, process_group);
 
   if (playing) {
     check_run_folder(task, cfg->env_cfg.run_id);
+    if (serving) {
+      std::cout << "-------Serve-------" << std::endl;
+      server::PolicyServer policy_server(cfg, utils::get_run_path(task) + "/models_last.pt",
+                                         device);
+      std::signal(SIGINT, request_stop);
+      std::signal(SIGTERM, request_stop);
+      policy_server.serve(stop_requested);
+      return 0;
+    }
     std::cout << "-------Loading Model-------" << std::endl;
     runner->load_models("/models_last.pt");
+    if (exporting) {
+      std::cout << "-------Export-------" << std::endl;
+      runner->export_policy("/policy.bin");
+      return 0;
+    }
+    if (quantizing) {
+      std::cout << "-------Quantize-------" << std::endl;
+      return runner->quantize_policy("/policy_int8.bin") ? 0 : 1;
+    }
     std::cout << "-------Play-------" << std::endl;
     runner->play();
   } else {
     std::cout << "-------Train-------" << std::endl;
     runner->learn();
+    if (!cfg->distributed_cfg.is_main()) return 0;
     std::cout << "-------Copy Yaml-------" << std::endl;
     copy_yaml(task);
+    if (workers) workers->join();
   }
 }
@@ -18,8 +18,8 @@ Actor::Actor(const configs::ActorCfg& cfg) {
   this->register_module("distribution", this->distribution_);
 }
 
-const Tensor Actor::forward(const Tensor& actor_obs) {
-  this->distribution_->update(this->network_->forward(this->normalizer_->forward(actor_obs)));
+const Tensor Actor::forward_distribution(const Tensor& network_outputs) {
+  this->distribution_->update(network_outputs);
   if (this->inference_mode_) return this->distribution_->get_mode();
   return this->distribution_->sample();
 }
@@ -50,9 +50,13 @@ Critic::Critic(const configs::CriticCfg& cfg) {
   this->register_module("network", this->network_);
 }
 
-ActorCritic::ActorCritic(const configs::ActorCfg& actor_cfg, const configs::CriticCfg& critic_cfg) {
+ActorCritic::ActorCritic(const configs::ActorCfg& actor_cfg, const configs::CriticCfg& critic_cfg,
+                         const bool& fused) {
   this->actor_ = std::make_shared<Actor>(actor_cfg);
   this->critic_ = std::make_shared<Critic>(critic_cfg);
+  if (fused)
+    this->fused_network_ =
+      std::make_unique<FusedMLP>(this->actor_->get_network(), this->critic_->get_network());
 
   this->register_module("actor", this->actor_);
   this->register_module("critic", this->critic_);
@@ -60,4 +64,27 @@ ActorCritic::ActorCritic(const configs::ActorCfg& actor_cfg, const configs::Crit
   std::cout << "Actor: \n" << *this->actor_ << std::endl;
   std::cout << "Critic: \n" << *this->critic_ << std::endl;
 }
+
+const TensorTuple ActorCritic::forward_evaluate(const Tensor& actor_obs, const Tensor& critic_obs) {
+  if (!this->fused_network_) return {this->forward(actor_obs), this->evaluate(critic_obs)};
+  const auto& [actor_outputs, values] = this->fused_network_->forward(
+    this->actor_->normalize(actor_obs), this->critic_->normalize(critic_obs));
+  return {this->actor_->forward_distribution(actor_outputs), values};
+}
+
+const ListTensor ActorCritic::get_state() const {
+  // Detached copy of the parameters followed by the buffers (normalizer statistics)
+  torch::NoGradGuard no_grad;
+  ListTensor state;
+  for (const Tensor& parameter : this->parameters()) state.push_back(parameter.detach().clone());
+  for (const Tensor& buffer : this->buffers()) state.push_back(buffer.detach().clone());
+  return state;
+}
+
+void ActorCritic::set_state(const ListTensor& state) {
+  torch::NoGradGuard no_grad;
+  size_t i = 0;
+  for (Tensor parameter : this->parameters()) parameter.copy_(state[i++]);
+  for (Tensor buffer : this->buffers()) buffer.copy_(state[i++]);
+}
 }  // namespace modules
\ No newline at end of file
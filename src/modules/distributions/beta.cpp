@@ -1,9 +1,55 @@
 #include "modules/distributions/beta.h"
 
+#include <torch/library.h>
 #include <torch/torch.h>
 
 namespace modules {
 
+// Proposal rounds between two host checks for rejected elements, one round accepts > 95%
+constexpr int kGammaRounds = 2;
+
+const Tensor sample_log_gamma(const Tensor& shape) {
+  torch::NoGradGuard no_grad;
+  const Tensor& boosted = shape < 1.f;
+  const Tensor& d = torch::where(boosted, shape + 1.f, shape) - 1.f / 3.f;
+  const Tensor& c = torch::rsqrt(9.f * d);
+  Tensor log_gamma = torch::empty_like(shape);
+  Tensor pending = torch::ones_like(shape, torch::kBool);
+  do {
+    for (int round = 0; round < kGammaRounds; ++round) {
+      const Tensor& x = torch::randn_like(shape);
+      const Tensor& v = (1.f + c * x).pow(3);
+      // log(v) is NaN or -inf for v <= 0, which rejects the proposal
+      const Tensor& log_v = torch::log(v);
+      const Tensor& accepted =
+        pending & (torch::log(torch::rand_like(shape)) < 0.5f * x.square() + d * (1.f - v + log_v));
+      log_gamma = torch::where(accepted, torch::log(d) + log_v, log_gamma);
+      pending.logical_and_(accepted.logical_not());
+    }
+  } while (pending.any().item<bool>());
+  return torch::where(boosted, log_gamma + torch::log(torch::rand_like(shape)) / shape, log_gamma);
+}
+
+void sample_beta(const Tensor& alpha, const Tensor& beta, Tensor& output) {
+  torch::NoGradGuard no_grad;
+  // Both gamma variates in one batched pass, X / (X + Y) = sigmoid(log X - log Y)
+  const Tensor& log_gammas = sample_log_gamma(torch::stack({alpha, beta}));
+  torch::sigmoid_out(output, log_gammas[0] - log_gammas[1]);
+  // Keeps the log-probabilities of the samples finite
+  output.clamp_(EPS, 1.f - EPS);
+}
+
+static Tensor sample_beta_op(const Tensor& alpha, const Tensor& beta) {
+  Tensor samples = torch::empty_like(alpha);
+  sample_beta(alpha, beta, samples);
+  return samples;
+}
+
+// torch.ops.cpp_rl.sample_beta, so that the scripted policy draws from the same sampler
+TORCH_LIBRARY(cpp_rl, m) {
+  m.def("sample_beta(Tensor alpha, Tensor beta) -> Tensor", sample_beta_op);
+}
+
 void Beta::update(const Tensor& hidden_output) {
   this->mean_ = hidden_output.clamp(this->min_, this->max_);
 
@@ -14,25 +60,31 @@ void Beta::update(const Tensor& hidden_output) {
                         var / (this->max_ - this->min_);
   this->alpha_ = (this->min_ - this->mean_) * total;
   this->beta_ = (this->mean_ - this->max_) * total;
+
+  this->log_beta_function_cache_.clear();
+  this->digamma_alpha_cache_.clear();
+  this->digamma_beta_cache_.clear();
+  this->digamma_total_cache_.clear();
+}
+
+const Tensor Beta::sample() const {
+  Tensor samples = torch::empty_like(this->alpha_);
+  sample_beta(this->alpha_, this->beta_, samples);
+  return this->scale_(samples);
 }
 
 const Tensor Beta::get_log_prob(const Tensor& actions) const {
   const Tensor& unscaled_actions = this->unscale_(actions);
   return (this->alpha_ - 1.f) * torch::log(unscaled_actions) +
-         (this->beta_ - 1.f) * torch::log(1.f - unscaled_actions) -
-         (torch::lgamma(this->alpha_) + torch::lgamma(this->beta_) -
-          torch::lgamma(this->alpha_ + this->beta_)) -
-         torch::log(this->max_ - this->min_);
+         (this->beta_ - 1.f) * torch::log(1.f - unscaled_actions) - this->log_beta_function_() -
+         this->log_range_;
 }
 
 const Tensor Beta::get_entropy() const {
-  return torch::lgamma(this->alpha_) + torch::lgamma(this->beta_) -
-         torch::lgamma(this->alpha_ + this->beta_) -
-         (this->alpha_ - 1.f) *
-           (torch::digamma(this->alpha_) - torch::digamma(this->alpha_ + this->beta_)) -
-         (this->beta_ - 1.f) *
-           (torch::digamma(this->beta_) - torch::digamma(this->alpha_ + this->beta_)) +
-         torch::log(this->max_ - this->min_);
+  return this->log_beta_function_() -
+         (this->alpha_ - 1.f) * (this->digamma_alpha_() - this->digamma_total_()) -
+         (this->beta_ - 1.f) * (this->digamma_beta_() - this->digamma_total_()) +
+         this->log_range_;
 }
 
 const Tensor Beta::get_kl(const DictTensor& old_kl_params) const {
@@ -40,16 +92,36 @@ const Tensor Beta::get_kl(const DictTensor& old_kl_params) const {
   const Tensor& beta = this->beta_;
   const Tensor& old_alpha = old_kl_params.at("alpha");
   const Tensor& old_beta = old_kl_params.at("beta");
+  const Tensor& old_digamma_total = torch::digamma(old_alpha + old_beta);
 
-  return torch::lgamma(alpha) + torch::lgamma(beta) - torch::lgamma(alpha + beta) -
-         torch::lgamma(old_alpha) - torch::lgamma(old_beta) + torch::lgamma(old_alpha + old_beta) +
-         (old_alpha - alpha) * (torch::digamma(old_alpha) - torch::digamma(old_alpha + old_beta)) +
-         (old_beta - beta) * (torch::digamma(old_beta) - torch::digamma(old_alpha + old_beta)) -
-         torch::log(this->max_ - this->min_);
+  return this->log_beta_function_() - torch::lgamma(old_alpha) - torch::lgamma(old_beta) +
+         torch::lgamma(old_alpha + old_beta) +
+         (old_alpha - alpha) * (torch::digamma(old_alpha) - old_digamma_total) +
+         (old_beta - beta) * (torch::digamma(old_beta) - old_digamma_total) - this->log_range_;
 }
 
 const DictTensor Beta::get_kl_params() const {
   return {{"alpha", this->alpha_}, {"beta", this->beta_}};
 }
 
+const Tensor& Beta::log_beta_function_() const {
+  return this->log_beta_function_cache_.get([this] {
+    return torch::lgamma(this->alpha_) + torch::lgamma(this->beta_) -
+           torch::lgamma(this->alpha_ + this->beta_);
+  });
+}
+
+const Tensor& Beta::digamma_alpha_() const {
+  return this->digamma_alpha_cache_.get([this] { return torch::digamma(this->alpha_); });
+}
+
+const Tensor& Beta::digamma_beta_() const {
+  return this->digamma_beta_cache_.get([this] { return torch::digamma(this->beta_); });
+}
+
+const Tensor& Beta::digamma_total_() const {
+  return this->digamma_total_cache_.get(
+    [this] { return torch::digamma(this->alpha_ + this->beta_); });
+}
+
 }  // namespace modules
\ No newline at end of file
@@ -9,7 +9,7 @@ const Tensor Normal::get_kl(const DictTensor& old_kl_params) const {
   const Tensor& new_mean = this->mean_;
 
   return torch::log(new_std / old_std) +
-         (old_std.square() + (old_mean - new_mean).square()) / (2. * new_std.square()) - 0.5;
+         (old_std.square() + (old_mean - new_mean).square()) / (2. * this->var_()) - 0.5;
 }
 
 }  // namespace modules
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "modules/fused_mlp.h"
+
+#include "utils/autocast.h"
+
+namespace modules {
+
+FusedMLP::FusedMLP(const MLPPointer& first, const MLPPointer& second)
+  : first_(first),
+    second_(second),
+    num_first_outputs_(first->get_layers().back()->options.out_features()),
+    num_second_outputs_(second->get_layers().back()->options.out_features()) {
+  if (first->get_layers().size() != second->get_layers().size())
+    throw std::invalid_argument("Fused networks must have the same depth");
+  if (first->get_activation() != second->get_activation())
+    throw std::invalid_argument("Fused networks must have the same activation");
+  if (first->is_autocast() != second->is_autocast())
+    throw std::invalid_argument("Fused networks must have the same precision");
+}
+
+const TensorTuple FusedMLP::forward(const Tensor& first_inputs, const Tensor& second_inputs) {
+  // Training steps the weights after every minibatch, re-packing them would cost more than the
+  // fused GEMMs save: the separate networks train and the packed path serves the rollouts
+  if (torch::GradMode::is_enabled())
+    return {this->first_->forward(first_inputs), this->second_->forward(second_inputs)};
+
+  if (this->is_stale_()) {
+    this->pack_(this->packed_weights_, this->packed_biases_);
+    this->packed_keys_.clear();
+    for (const MLPPointer& network : {this->first_, this->second_})
+      for (const Tensor& parameter : network->parameters())
+        this->packed_keys_.emplace_back(parameter.data_ptr(), parameter._version());
+  }
+  const Tensor& inputs = torch::cat({first_inputs, second_inputs}, /*dim=*/1);
+  const Tensor& outputs = this->forward_(inputs, this->packed_weights_, this->packed_biases_);
+
+  return {outputs.narrow(/*dim=*/1, 0, this->num_first_outputs_),
+          outputs.narrow(/*dim=*/1, this->num_first_outputs_, this->num_second_outputs_)};
+}
+
+const Tensor FusedMLP::forward_(const Tensor& inputs, const ListTensor& weights,
+                                const ListTensor& biases) const {
+  std::unique_ptr<utils::AutocastGuard> autocast;
+  if (this->first_->is_autocast())
+    autocast = std::make_unique<utils::AutocastGuard>(inputs.device(), torch::kBFloat16);
+
+  Tensor x = inputs;
+  for (size_t i = 0; i < weights.size(); ++i) {
+    x = torch::addmm(biases[i], x, weights[i]);
+    if (i + 1 < weights.size()) this->apply_activation_(x);
+  }
+  return this->first_->is_autocast() ? x.to(torch::kFloat) : x;
+}
+
+void FusedMLP::pack_(ListTensor& weights, ListTensor& biases) const {
+  // Transposed block-diagonal weights, [first_inputs + second_inputs, first_outputs +
+  // second_outputs], so that each layer is a single addmm
+  weights.clear();
+  biases.clear();
+  const std::vector<torch::nn::Linear>& first_layers = this->first_->get_layers();
+  const std::vector<torch::nn::Linear>& second_layers = this->second_->get_layers();
+  for (size_t i = 0; i < first_layers.size(); ++i) {
+    weights.push_back(
+      torch::block_diag({first_layers[i]->weight.t(), second_layers[i]->weight.t()}));
+    biases.push_back(torch::cat({first_layers[i]->bias, second_layers[i]->bias}));
+  }
+}
+
+bool FusedMLP::is_stale_() const {
+  size_t i = 0;
+  for (const MLPPointer& network : {this->first_, this->second_})
+    for (const Tensor& parameter : network->parameters()) {
+      if (i >= this->packed_keys_.size()) return true;
+      const auto& [data, version] = this->packed_keys_[i++];
+      if (data != parameter.data_ptr() || version != parameter._version()) return true;
+    }
+  return i != this->packed_keys_.size();
+}
+
+void FusedMLP::apply_activation_(Tensor& x) const {
+  const string& activation = this->first_->get_activation();
+  if (activation == "relu")
+    x.relu_();
+  else if (activation == "elu")
+    torch::elu_(x);
+  else if (activation == "tanh")
+    x.tanh_();
+  else if (activation == "sigmoid")
+    x.sigmoid_();
+}
+
+}  // namespace modules
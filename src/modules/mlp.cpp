@@ -1,16 +1,43 @@
 #include "modules/mlp.h"
 
+#include "utils/autocast.h"
+
 namespace modules {
-MLP::MLP(const configs::MLPCfg& cfg) {
+MLP::MLP(const configs::MLPCfg& cfg) : activation_(cfg.activation) {
+  if (cfg.precision == "bfloat16")
+    this->autocast_ = true;
+  else if (cfg.precision != "float32")
+    throw std::invalid_argument("Invalid precision");
+
   this->network_ = NN();
-  this->network_->push_back(torch::nn::Linear(cfg.num_inputs, cfg.width));
+  this->add_linear_(cfg.num_inputs, cfg.width);
   this->add_activation_(cfg.activation);
   for (unsigned int i = 0; i < cfg.depth; i++) {
-    this->network_->push_back(torch::nn::Linear(cfg.width, cfg.width));
+    this->add_linear_(cfg.width, cfg.width);
     this->add_activation_(cfg.activation);
   }
-  this->network_->push_back(torch::nn::Linear(cfg.width, cfg.num_outputs));
+  this->add_linear_(cfg.width, cfg.num_outputs);
   this->register_module("network", this->network_);
+
+  if (cfg.backend == "native") {
+    if (this->autocast_)
+      throw std::invalid_argument("The native backend only supports float32 precision");
+    this->native_ = std::make_unique<SmallMLP>(this->layers_, cfg.activation);
+  } else if (cfg.backend != "torch")
+    throw std::invalid_argument("Invalid backend");
+}
+
+const Tensor MLP::forward(const Tensor& x) {
+  if (this->native_ && x.device().is_cpu() && x.scalar_type() == torch::kFloat && x.dim() == 2)
+    return this->native_->forward(x);
+  if (!this->autocast_) return this->network_->forward(x);
+  utils::AutocastGuard autocast(x.device(), torch::kBFloat16);
+  return this->network_->forward(x).to(torch::kFloat);
+}
+
+void MLP::add_linear_(const unsigned int& num_inputs, const unsigned int& num_outputs) {
+  this->layers_.push_back(torch::nn::Linear(num_inputs, num_outputs));
+  this->network_->push_back(this->layers_.back());
 }
 
 void MLP::add_activation_(const string& activation) {
@@ -3,16 +3,26 @@
 namespace modules {
 
 const Tensor EmpiricalNormalizer::forward(const Tensor& observations) {
-  if (!this->inference_mode_) this->update(observations);
   return this->normalize(observations);
 }
 
-void EmpiricalNormalizer::update(const Tensor& observations) {
-  this->count_ += observations.size(0);
-
-  float rate = static_cast<float>(observations.size(0)) / this->count_;
-  const Tensor& var_obs = torch::var(observations, /*dim=*/0, /*unbiased=*/true);
-  const Tensor& mean_obs = torch::mean(observations, /*dim=*/0);
+void EmpiricalNormalizer::update(const Tensor& observations, const AllReduceFn& all_reduce) {
+  if (this->inference_mode_) return;
+  auto [var_obs, mean_obs] = torch::var_mean(observations, {0}, /*unbiased=*/true);
+  int64_t batch_size = observations.size(0);
+
+  if (all_reduce) {
+    // Merge the per-process moments through their sums: [count, sum, sum of squares]
+    Tensor moments = torch::stack({torch::full_like(mean_obs, batch_size), mean_obs * batch_size,
+                                   var_obs * (batch_size - 1) + mean_obs.square() * batch_size});
+    all_reduce(moments);
+    batch_size = moments[0][0].item<int64_t>();
+    mean_obs = moments[1] / batch_size;
+    var_obs = (moments[2] - mean_obs.square() * batch_size) / (batch_size - 1);
+  }
+
+  this->count_ += batch_size;
+  float rate = static_cast<float>(batch_size) / this->count_;
   const Tensor& delta_mean = mean_obs - this->mean_;
 
   this->mean_.add_(rate * delta_mean);
@@ -0,0 +1,122 @@
+#include "modules/scripted_policy.h"
+
+namespace modules {
+
+ScriptedPolicy::ScriptedPolicy(const configs::ActorCfg& actor_cfg,
+                               const configs::CriticCfg& critic_cfg)
+  : distribution_type_(actor_cfg.distribution_cfg.type),
+    action_min_(actor_cfg.distribution_cfg.action_min),
+    action_max_(actor_cfg.distribution_cfg.action_max) {
+  if (actor_cfg.mlp_cfg.precision != "float32" || critic_cfg.mlp_cfg.precision != "float32")
+    throw std::invalid_argument("The scripted policy only supports float32 precision");
+
+  const string source =
+    normalizer_script_("actor", actor_cfg.normalizer_cfg) +
+    normalizer_script_("critic", critic_cfg.normalizer_cfg) +
+    network_script_("actor", actor_cfg.mlp_cfg) + network_script_("critic", critic_cfg.mlp_cfg) +
+    "def act(actor_obs: Tensor, critic_obs: Tensor, actor_stats: List[Tensor], "
+    "critic_stats: List[Tensor], actor_params: List[Tensor], critic_params: List[Tensor], "
+    "std: Tensor, action_min: Tensor, action_max: Tensor) -> Tuple[Tensor, Tensor, Tensor, "
+    "Tensor, Tensor]:\n"
+    "    outputs = actor_network(actor_normalize(actor_obs, actor_stats), actor_params)\n"
+    "    values = critic_network(critic_normalize(critic_obs, critic_stats), critic_params)\n" +
+    distribution_script_(actor_cfg.distribution_cfg);
+  this->unit_ = utils::compile_script(source);
+}
+
+const PolicyStep ScriptedPolicy::forward(const ActorCritic& actor_critic, const Tensor& actor_obs,
+                                         const Tensor& critic_obs) const {
+  const ActorPointer& actor = actor_critic.get_actor();
+  const CriticPointer& critic = actor_critic.get_critic();
+  const utils::FuserGuard fuser_guard;
+  const auto& outputs = this->unit_
+                          ->run_method("act", actor_obs, critic_obs,
+                                       c10::List<Tensor>(actor->get_normalizer()->buffers()),
+                                       c10::List<Tensor>(critic->get_normalizer()->buffers()),
+                                       network_parameters_(actor->get_network()),
+                                       network_parameters_(critic->get_network()),
+                                       actor->get_std(), this->action_min_, this->action_max_)
+                          .toTuple();
+  const auto& elements = outputs->elements();
+
+  PolicyStep step{elements[0].toTensor(), elements[1].toTensor(), elements[2].toTensor(), {}};
+  if (this->distribution_type_ == "beta")
+    step.kl_params = {{"alpha", elements[3].toTensor()}, {"beta", elements[4].toTensor()}};
+  else
+    step.kl_params = {{"mean", elements[3].toTensor()}, {"std", elements[4].toTensor()}};
+  return step;
+}
+
+const string ScriptedPolicy::normalizer_script_(const string& name,
+                                                const configs::NormalizerCfg& cfg) {
+  // stats holds the normalizer buffers: [mean, var] for the empirical one, nothing otherwise
+  string body;
+  if (cfg.type == "empirical")
+    body = "    return (x - stats[0]) / (torch.sqrt(stats[1]) + " + utils::script_literal(EPS) +
+           ")\n";
+  else if (cfg.type == "identity")
+    body = "    return x\n";
+  else
+    throw std::invalid_argument("Unknown normalizer type: " + cfg.type);
+  return "def " + name + "_normalize(x: Tensor, stats: List[Tensor]) -> Tensor:\n" + body + "\n";
+}
+
+const string ScriptedPolicy::network_script_(const string& name, const configs::MLPCfg& cfg) {
+  string activation;
+  if (cfg.activation == "elu")
+    activation = "torch.elu";
+  else if (cfg.activation == "relu")
+    activation = "torch.relu";
+  else if (cfg.activation == "tanh")
+    activation = "torch.tanh";
+  else if (cfg.activation == "sigmoid")
+    activation = "torch.sigmoid";
+  else
+    throw std::invalid_argument("Invalid activation function");
+
+  // Unrolled so that every activation sits next to its GEMM in the graph
+  const unsigned int num_layers = cfg.depth + 2;
+  string source = "def " + name + "_network(x: Tensor, params: List[Tensor]) -> Tensor:\n";
+  for (unsigned int i = 0; i < num_layers; ++i) {
+    const string linear = "torch.addmm(params[" + std::to_string(2 * i + 1) + "], x, params[" +
+                          std::to_string(2 * i) + "].t())";
+    source += "    x = " + (i + 1 < num_layers ? activation + "(" + linear + ")" : linear) + "\n";
+  }
+  return source + "    return x\n\n";
+}
+
+const string ScriptedPolicy::distribution_script_(const configs::DistributionCfg& cfg) {
+  // Mirrors Distribution::update, sample and get_log_prob. The beta samples come from the op
+  // registered by sample_beta, already clamped to [EPS, 1 - EPS]
+  if (cfg.type == "normal")
+    return "    actions = outputs + std * torch.randn_like(outputs)\n"
+           "    var = std * std\n"
+           "    log_probs = -0.5 * (torch.log(" + utils::script_literal(2. * M_PI) +
+           " * var) + (actions - outputs) * (actions - outputs) / var)\n"
+           "    return actions, values, torch.sum(log_probs, -1, keepdim=True), outputs, std\n";
+  if (cfg.type == "beta")
+    return "    mean = torch.maximum(torch.minimum(outputs, action_max), action_min)\n"
+           "    var = std * std\n"
+           "    total = (action_min * action_max - (action_min + action_max) * mean + mean * mean "
+           "+ var) / var / (action_max - action_min)\n"
+           "    alpha = (action_min - mean) * total\n"
+           "    beta = (mean - action_max) * total\n"
+           "    unscaled = torch.ops.cpp_rl.sample_beta(alpha, beta)\n"
+           "    actions = action_min + (action_max - action_min) * unscaled\n"
+           "    log_probs = (alpha - 1.0) * torch.log(unscaled) + (beta - 1.0) * torch.log(1.0 - "
+           "unscaled) - (torch.lgamma(alpha) + torch.lgamma(beta) - torch.lgamma(alpha + beta)) - "
+           "torch.log(action_max - action_min)\n"
+           "    return actions, values, torch.sum(log_probs, -1, keepdim=True), alpha, beta\n";
+  throw std::invalid_argument("Unknown distribution type: " + cfg.type);
+}
+
+const c10::List<Tensor> ScriptedPolicy::network_parameters_(const MLPPointer& network) {
+  c10::List<Tensor> parameters;
+  for (const torch::nn::Linear& layer : network->get_layers()) {
+    parameters.push_back(layer->weight);
+    parameters.push_back(layer->bias);
+  }
+  return parameters;
+}
+
+}  // namespace modules
@@ -0,0 +1,145 @@
+#include "modules/small_mlp.h"
+
+namespace modules {
+
+namespace {
+
+kernels::Activation to_activation_(const string& activation) {
+  if (activation == "relu") return kernels::Activation::ReLU;
+  if (activation == "elu") return kernels::Activation::ELU;
+  if (activation == "tanh") return kernels::Activation::Tanh;
+  if (activation == "sigmoid") return kernels::Activation::Sigmoid;
+  throw std::invalid_argument("Invalid activation function");
+}
+
+}  // namespace
+
+VariableList SmallMLPFunction::forward(AutogradContext* ctx, const Tensor& inputs,
+                                       at::TensorList parameters, const ListTensor* weights_t,
+                                       const int64_t& activation) {
+  const size_t num_layers = weights_t->size();
+  const int64_t num_rows = inputs.size(0);
+
+  // Every layer output is kept for the backward pass, the derivatives are taken from them
+  ListTensor saved{inputs.contiguous()};
+  for (size_t i = 0; i < num_layers; ++i) {
+    const Tensor& weight_t = (*weights_t)[i];
+    const Tensor& bias = parameters[2 * i + 1].contiguous();
+    const Tensor& x = saved.back();
+    Tensor y = torch::empty({num_rows, weight_t.size(1)}, inputs.options());
+    kernels::linear_forward(
+      x.data_ptr<float>(), weight_t.data_ptr<float>(), bias.data_ptr<float>(), y.data_ptr<float>(),
+      num_rows, weight_t.size(0), weight_t.size(1),
+      i + 1 < num_layers ? static_cast<kernels::Activation>(activation)
+                         : kernels::Activation::Identity);
+    saved.push_back(y);
+  }
+  const Tensor outputs = saved.back();
+
+  for (size_t i = 0; i < num_layers; ++i) saved.push_back(parameters[2 * i]);
+  ctx->save_for_backward(saved);
+  ctx->saved_data["activation"] = activation;
+  return {outputs};
+}
+
+VariableList SmallMLPFunction::backward(AutogradContext* ctx, VariableList grad_outputs) {
+  // Saved: [inputs, y_0, ..., y_{L-1}, weight_0, ..., weight_{L-1}]
+  const VariableList& saved = ctx->get_saved_variables();
+  const size_t num_layers = (saved.size() - 1) / 2;
+  const auto activation = static_cast<kernels::Activation>(ctx->saved_data["activation"].toInt());
+  const int64_t num_rows = saved[0].size(0);
+
+  VariableList grads(1 + 2 * num_layers + 2);
+  Tensor grad_z = grad_outputs[0].contiguous().clone();
+  for (size_t l = num_layers; l-- > 0;) {
+    const Tensor& x = saved[l];
+    const Tensor& weight = saved[1 + num_layers + l].contiguous();
+    const int64_t num_inputs = weight.size(1);
+    const int64_t num_outputs = weight.size(0);
+    if (l + 1 < num_layers)
+      kernels::activation_backward(saved[l + 1].data_ptr<float>(), grad_z.data_ptr<float>(),
+                                   grad_z.numel(), activation);
+
+    Tensor grad_weight = torch::zeros_like(weight);
+    Tensor grad_bias = torch::zeros({num_outputs}, weight.options());
+    Tensor grad_x;
+    if (l > 0 || ctx->needs_input_grad(0))
+      grad_x = torch::empty({num_rows, num_inputs}, weight.options());
+    kernels::linear_backward(x.data_ptr<float>(), weight.data_ptr<float>(),
+                             grad_z.data_ptr<float>(),
+                             grad_x.defined() ? grad_x.data_ptr<float>() : nullptr,
+                             grad_weight.data_ptr<float>(), grad_bias.data_ptr<float>(), num_rows,
+                             num_inputs, num_outputs);
+
+    grads[1 + 2 * l] = grad_weight;
+    grads[2 + 2 * l] = grad_bias;
+    grad_z = grad_x;
+  }
+  grads[0] = grad_z;
+  // No gradient for the packed weights and the activation
+  return grads;
+}
+
+SmallMLP::SmallMLP(const std::vector<torch::nn::Linear>& layers, const string& activation)
+  : layers_(layers), activation_(to_activation_(activation)) {
+  for (const torch::nn::Linear& layer : layers) {
+    this->parameters_.push_back(layer->weight);
+    this->parameters_.push_back(layer->bias);
+    this->max_width_ = std::max(this->max_width_, layer->options.out_features());
+  }
+}
+
+const Tensor SmallMLP::forward(const Tensor& inputs) {
+  this->pack_();
+  if (!torch::GradMode::is_enabled()) return this->forward_no_grad_(inputs);
+  return SmallMLPFunction::apply(inputs, at::TensorList(this->parameters_), &this->weights_t_,
+                                 static_cast<int64_t>(this->activation_))[0];
+}
+
+const Tensor SmallMLP::forward_no_grad_(const Tensor& inputs) {
+  // Rollouts and evaluation: hidden layers ping-pong in the workspace, only the outputs allocate
+  const int64_t num_rows = inputs.size(0);
+  if (!this->workspace_.defined() || this->workspace_.size(1) < num_rows)
+    this->workspace_ = torch::empty({2, num_rows, this->max_width_}, inputs.options());
+
+  const Tensor& x = inputs.contiguous();
+  const float* input = x.data_ptr<float>();
+  Tensor outputs;
+  for (size_t i = 0; i < this->weights_t_.size(); ++i) {
+    const Tensor& weight_t = this->weights_t_[i];
+    const bool last = i + 1 == this->weights_t_.size();
+    float* output;
+    if (last) {
+      outputs = torch::empty({num_rows, weight_t.size(1)}, inputs.options());
+      output = outputs.data_ptr<float>();
+    } else
+      output = this->workspace_[i % 2].data_ptr<float>();
+    kernels::linear_forward(input, weight_t.data_ptr<float>(),
+                            this->layers_[i]->bias.data_ptr<float>(), output, num_rows,
+                            weight_t.size(0), weight_t.size(1),
+                            last ? kernels::Activation::Identity : this->activation_);
+    input = output;
+  }
+  return outputs;
+}
+
+void SmallMLP::pack_() {
+  // Weights change after every optimizer step, the transposes are refreshed lazily
+  bool stale = this->packed_keys_.size() != this->layers_.size();
+  for (size_t i = 0; !stale && i < this->layers_.size(); ++i) {
+    const Tensor& weight = this->layers_[i]->weight;
+    stale = this->packed_keys_[i].first != weight.data_ptr() ||
+            this->packed_keys_[i].second != weight._version();
+  }
+  if (!stale) return;
+
+  torch::NoGradGuard no_grad;
+  this->weights_t_.clear();
+  this->packed_keys_.clear();
+  for (const torch::nn::Linear& layer : this->layers_) {
+    this->weights_t_.push_back(layer->weight.t().contiguous());
+    this->packed_keys_.emplace_back(layer->weight.data_ptr(), layer->weight._version());
+  }
+}
+
+}  // namespace modules
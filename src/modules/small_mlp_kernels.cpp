@@ -0,0 +1,139 @@
+#include "modules/small_mlp_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace modules {
+namespace kernels {
+
+namespace {
+
+// Register block: kRows batch rows times kCols output features accumulate in registers while
+// streaming over the inputs, the fixed trip counts let the compiler vectorize the column loop
+constexpr int64_t kRows = 4;
+constexpr int64_t kCols = 16;
+
+template <Activation A>
+inline float activate_(const float& value) {
+  if constexpr (A == Activation::ReLU) return value > 0.f ? value : 0.f;
+  if constexpr (A == Activation::ELU) return value > 0.f ? value : std::expm1(value);
+  if constexpr (A == Activation::Tanh) return std::tanh(value);
+  if constexpr (A == Activation::Sigmoid) return 1.f / (1.f + std::exp(-value));
+  return value;
+}
+
+template <Activation A>
+inline float derivative_(const float& output) {
+  if constexpr (A == Activation::ReLU) return output > 0.f ? 1.f : 0.f;
+  if constexpr (A == Activation::ELU) return output > 0.f ? 1.f : output + 1.f;
+  if constexpr (A == Activation::Tanh) return 1.f - output * output;
+  if constexpr (A == Activation::Sigmoid) return output * (1.f - output);
+  return 1.f;
+}
+
+// result[n, m] = activation(init + lhs . rhs), with lhs[r, k] read at lhs[r * lhs_row + k *
+// lhs_inner] and rhs row-major [p, m]. init is result itself when accumulating, else the bias or
+// zero. The strides let the weight gradient read grad_z transposed without a copy.
+template <Activation A>
+void matmul_(const float* lhs, const int64_t lhs_row, const int64_t lhs_inner, const float* rhs,
+             const float* bias, float* result, const bool accumulate, const int64_t n,
+             const int64_t p, const int64_t m) {
+  for (int64_t row = 0; row < n; row += kRows) {
+    const int64_t rows = std::min(kRows, n - row);
+    for (int64_t col = 0; col < m; col += kCols) {
+      const int64_t cols = std::min(kCols, m - col);
+      float accumulator[kRows][kCols];
+      for (int64_t r = 0; r < kRows; ++r)
+        for (int64_t c = 0; c < kCols; ++c) {
+          if (r >= rows || c >= cols)
+            accumulator[r][c] = 0.f;
+          else if (accumulate)
+            accumulator[r][c] = result[(row + r) * m + col + c];
+          else
+            accumulator[r][c] = bias ? bias[col + c] : 0.f;
+        }
+
+      if (rows == kRows && cols == kCols) {
+        for (int64_t k = 0; k < p; ++k) {
+          const float* rhs_row = rhs + k * m + col;
+          for (int64_t r = 0; r < kRows; ++r) {
+            const float value = lhs[(row + r) * lhs_row + k * lhs_inner];
+            for (int64_t c = 0; c < kCols; ++c) accumulator[r][c] += value * rhs_row[c];
+          }
+        }
+      } else {
+        for (int64_t k = 0; k < p; ++k) {
+          const float* rhs_row = rhs + k * m + col;
+          for (int64_t r = 0; r < rows; ++r) {
+            const float value = lhs[(row + r) * lhs_row + k * lhs_inner];
+            for (int64_t c = 0; c < cols; ++c) accumulator[r][c] += value * rhs_row[c];
+          }
+        }
+      }
+
+      for (int64_t r = 0; r < rows; ++r) {
+        float* output = result + (row + r) * m + col;
+        for (int64_t c = 0; c < cols; ++c) output[c] = activate_<A>(accumulator[r][c]);
+      }
+    }
+  }
+}
+
+template <Activation A>
+void activation_backward_(const float* y, float* grad, const int64_t size) {
+  for (int64_t i = 0; i < size; ++i) grad[i] *= derivative_<A>(y[i]);
+}
+
+}  // namespace
+
+void linear_forward(const float* x, const float* weight_t, const float* bias, float* y,
+                    const int64_t& n, const int64_t& in, const int64_t& out,
+                    const Activation& activation) {
+  switch (activation) {
+    case Activation::ReLU:
+      return matmul_<Activation::ReLU>(x, in, 1, weight_t, bias, y, false, n, in, out);
+    case Activation::ELU:
+      return matmul_<Activation::ELU>(x, in, 1, weight_t, bias, y, false, n, in, out);
+    case Activation::Tanh:
+      return matmul_<Activation::Tanh>(x, in, 1, weight_t, bias, y, false, n, in, out);
+    case Activation::Sigmoid:
+      return matmul_<Activation::Sigmoid>(x, in, 1, weight_t, bias, y, false, n, in, out);
+    default:
+      return matmul_<Activation::Identity>(x, in, 1, weight_t, bias, y, false, n, in, out);
+  }
+}
+
+void activation_backward(const float* y, float* grad, const int64_t& size,
+                         const Activation& activation) {
+  switch (activation) {
+    case Activation::ReLU:
+      return activation_backward_<Activation::ReLU>(y, grad, size);
+    case Activation::ELU:
+      return activation_backward_<Activation::ELU>(y, grad, size);
+    case Activation::Tanh:
+      return activation_backward_<Activation::Tanh>(y, grad, size);
+    case Activation::Sigmoid:
+      return activation_backward_<Activation::Sigmoid>(y, grad, size);
+    default:
+      return;
+  }
+}
+
+void linear_backward(const float* x, const float* weight, const float* grad_z, float* grad_x,
+                     float* grad_weight, float* grad_bias, const int64_t& n, const int64_t& in,
+                     const int64_t& out) {
+  // Both products go through the register-blocked kernel of the forward pass.
+  // grad_weight[out, in] += grad_z^T[out, n] . x[n, in], reading grad_z transposed.
+  matmul_<Activation::Identity>(grad_z, 1, out, x, nullptr, grad_weight, true, out, n, in);
+  // grad_x[n, in] = grad_z[n, out] . weight[out, in]
+  if (grad_x != nullptr)
+    matmul_<Activation::Identity>(grad_z, out, 1, weight, nullptr, grad_x, false, n, out, in);
+
+  for (int64_t i = 0; i < n; ++i) {
+    const float* grad_z_row = grad_z + i * out;
+    for (int64_t o = 0; o < out; ++o) grad_bias[o] += grad_z_row[o];
+  }
+}
+
+}  // namespace kernels
+}  // namespace modules
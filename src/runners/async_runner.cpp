@@ -0,0 +1,331 @@
+#include "runners/async_runner.h"
+
+#include <torch/torch.h>
+
+#include <optional>
+
+#include "env/task_manager.h"
+#include "storage/mmap_checkpoint.h"
+#include "utils/perf_counters.h"
+#include "utils/trace.h"
+#include "utils/utils.h"
+
+namespace runners {
+
+AsyncRunner::AsyncRunner(const string& task, const configs::CfgPointer& cfg, const Device& device)
+  : cfg_(cfg),
+    run_path_(utils::get_run_path(cfg->env_cfg.task)),
+    queue_(cfg->impala_cfg.queue_size),
+    device_(device) {
+  if (cfg->distributed_cfg.world_size > 1)
+    throw std::invalid_argument("The impala runner does not support data-parallel training");
+
+  // Each actor owns a shard of the environments and a local copy of the policy
+  const unsigned int num_actors = cfg->impala_cfg.num_actors;
+  for (unsigned int i = 0; i < num_actors; ++i) {
+    this->actor_cfgs_.push_back(cfg->shard(i, num_actors));
+    this->envs_.push_back(
+      env::TaskManager::create(task, this->actor_cfgs_[i]->env_cfg, this->device_));
+    this->envs_[i]->initialize();
+    if (cfg->runner_cfg.scripted_step) this->envs_[i]->enable_scripted_step();
+    this->observation_buffers_.push_back(std::make_unique<storage::ObservationBuffer>(
+      this->actor_cfgs_[i], this->envs_[i]->get_actor_obs_size(),
+      this->envs_[i]->get_critic_obs_size(), this->envs_[i]->get_action_size(), device));
+  }
+  this->update_cfg_();
+  std::cout << *this->cfg_ << std::endl;
+
+  this->train_algorithm_ = std::make_unique<algorithms::IMPALA>(cfg, device);
+  for (unsigned int i = 0; i < num_actors; ++i) {
+    this->actor_critics_.push_back(
+      std::make_unique<modules::ActorCritic>(cfg->actor_cfg, cfg->critic_cfg,
+                                             cfg->ppo_cfg.fused_actor_critic));
+    this->actor_critics_[i]->to(device);
+  }
+
+  this->reward_buffer_ =
+    std::make_unique<storage::CircularBufferFloat>(cfg->runner_cfg.logging_buffer);
+  this->length_buffer_ =
+    std::make_unique<storage::CircularBufferInt>(cfg->runner_cfg.logging_buffer);
+  this->logger_ = std::make_unique<MetricsLogger>(this->run_path_ + "/tensorboard.tfevents",
+                                                    cfg->runner_cfg);
+  this->checkpoint_manager_ = std::make_unique<storage::CheckpointManager>(
+    this->run_path_, cfg->runner_cfg.save_interval, cfg->runner_cfg.max_checkpoints);
+}
+
+void AsyncRunner::learn() {
+  this->total_time_steps_ = 0;
+
+  this->collection_time_ = 0.;
+  this->learn_time_ = 0.;
+  this->total_time_ = 0.;
+
+  this->reward_buffer_->clear();
+  this->length_buffer_->clear();
+
+  // Live counters for `cpp_rl_watch`
+  this->live_metrics_ = std::make_unique<LiveMetricsWriter>(
+    live_metrics_name(this->cfg_->env_cfg.task, ::getpid()));
+
+  if (this->cfg_->runner_cfg.perf_counters) utils::PerfCounters::instance().enable();
+
+  this->train_algorithm_->train();
+  this->start_actors_();
+
+  unsigned int start = this->current_learning_iteration_;
+  unsigned int end = this->cfg_->runner_cfg.max_iterations + start;
+
+  const utils::TraceSessionPointer& trace_session = std::make_unique<utils::TraceSession>(
+    this->run_path_, this->cfg_->runner_cfg.trace_windows, this->cfg_->runner_cfg.trace_autograd);
+
+  for (unsigned int it = start; it < end; ++it) {
+    trace_session->begin_iteration(it);
+    // Collection time is the time the learner spends waiting on the actors
+    this->set_phase_(Phase::kCollecting);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    const storage::TrajectoryPointer trajectory = this->pop_trajectory_();
+    this->collection_time_ =
+      std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+    // Learning step
+    this->set_phase_(Phase::kLearning);
+    start_time = std::chrono::high_resolution_clock::now();
+    const unsigned int policy_version = this->train_algorithm_->get_snapshot()->version;
+    const algorithms::LossMetrics& loss_metrics = [this, &trajectory] {
+      const utils::PerfScope perf_scope(utils::PerfPhase::kLearning);
+      return this->train_algorithm_->update(*trajectory);
+    }();
+    this->learn_time_ =
+      std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start_time).count();
+    this->current_learning_iteration_ += 1;
+
+    this->reward_buffer_->push(trajectory->episode_rewards);
+    this->length_buffer_->push(trajectory->episode_lengths);
+
+    // Logging
+    this->set_phase_(Phase::kLogging);
+    const int64_t logging_start_ns = utils::trace_clock_ns();
+    float iteration_time = this->collection_time_ + this->learn_time_;
+    int time_steps = trajectory->rewards.size(0) * trajectory->rewards.size(1);
+    this->total_time_ += iteration_time;
+    this->total_time_steps_ += time_steps;
+
+    const ComputationMetrics computation_metrics{time_steps / iteration_time, iteration_time,
+                                                 this->collection_time_, this->learn_time_};
+
+    const RewardMetrics reward_metrics{this->reward_buffer_->mean(), this->length_buffer_->mean()};
+
+    std::map<string, float> extra_values;
+    extra_values["learning_rate"] = this->train_algorithm_->get_learning_rate();
+    extra_values["policy_lag"] = policy_version - trajectory->policy_version;
+    const ExtraMetrics extra_metrics{extra_values};
+
+    const TotalMetrics total_metrics{this->total_time_steps_, this->total_time_};
+
+    TrainMetrics metric{this->current_learning_iteration_,
+                        end,
+                        computation_metrics,
+                        loss_metrics,
+                        reward_metrics,
+                        total_metrics,
+                        extra_metrics,
+                        TimingMetrics{utils::Tracer::instance().pop_timings()},
+                        HardwareMetrics{utils::PerfCounters::instance().pop_metrics()}};
+
+    metric.to_live_counters(this->live_metrics_->counters());
+    this->live_metrics_->counters().num_episodes = this->reward_buffer_->size();
+    this->live_metrics_->publish();
+    this->logger_->push(std::move(metric), this->train_algorithm_->get_action_std());
+    utils::Tracer::instance().record(utils::Span::kLogging, logging_start_ns,
+                                     utils::trace_clock_ns());
+
+    // Save models
+    if (this->checkpoint_manager_->is_due(it + 1)) {
+      this->set_phase_(Phase::kSaving);
+      this->save_models("/models_" + std::to_string(this->current_learning_iteration_) + ".pt",
+                        /*periodic=*/true);
+    }
+    trace_session->end_iteration(it);
+  }
+  this->stop_actors_();
+  // Save models, plus the mapped inference checkpoint that play and evaluation load
+  this->set_phase_(Phase::kSaving);
+  this->save_models("/models_last.pt");
+  this->checkpoint_manager_->save(
+    storage::MmapCheckpoint::serialize(*this->train_algorithm_->get_actor_critic()),
+    "/models_last.map");
+  this->checkpoint_manager_->wait();
+  this->live_metrics_.reset();
+}
+
+void AsyncRunner::save_models(const string& name, const bool& periodic) const {
+  this->checkpoint_manager_->save(this->train_algorithm_->snapshot_models(), name, periodic);
+}
+
+void AsyncRunner::load_models(const string& name, const bool& load_optimizer) {
+  this->checkpoint_manager_->wait();
+  torch::serialize::InputArchive archive;
+  archive.load_from(this->run_path_ + name);
+  this->train_algorithm_->load_models(archive, load_optimizer);
+}
+
+void AsyncRunner::update_cfg_() {
+  unsigned int num_actor_obs = this->observation_buffers_[0]->get_actor_obs_size();
+  unsigned int num_critic_obs = this->observation_buffers_[0]->get_critic_obs_size();
+  this->cfg_->update(num_actor_obs, num_critic_obs, this->envs_[0]->get_action_min(),
+                     this->envs_[0]->get_action_max());
+}
+
+void AsyncRunner::start_actors_() {
+  this->running_.store(true);
+  for (unsigned int i = 0; i < this->cfg_->impala_cfg.num_actors; ++i)
+    this->actors_.emplace_back(&AsyncRunner::actor_loop_, this, i);
+}
+
+void AsyncRunner::stop_actors_() {
+  {
+    const std::lock_guard<std::mutex> lock(this->queue_mutex_);
+    this->running_.store(false);
+  }
+  this->slot_free_.notify_all();
+  for (std::thread& actor : this->actors_)
+    if (actor.joinable()) actor.join();
+  this->actors_.clear();
+
+  // Drop the trajectories collected with stale weights
+  storage::TrajectoryPointer trajectory;
+  while (this->queue_.try_pop(trajectory)) continue;
+}
+
+storage::TrajectoryPointer AsyncRunner::pop_trajectory_() {
+  storage::TrajectoryPointer trajectory;
+  // Lock-free fast path, the mutex is only taken to sleep on an empty queue
+  if (!this->queue_.try_pop(trajectory)) {
+    std::unique_lock<std::mutex> lock(this->queue_mutex_);
+    this->trajectory_ready_.wait(lock,
+                                 [this, &trajectory] { return this->queue_.try_pop(trajectory); });
+  }
+  this->notify_(this->slot_free_);
+  return trajectory;
+}
+
+void AsyncRunner::notify_(std::condition_variable& condition) {
+  // The push or pop happened outside the mutex: taking it orders the wakeup after the re-check of
+  // a thread about to sleep, so that none is lost
+  { const std::lock_guard<std::mutex> lock(this->queue_mutex_); }
+  condition.notify_one();
+}
+
+void AsyncRunner::actor_loop_(const unsigned int index) {
+  // Grad mode is thread local
+  torch::NoGradGuard no_grad;
+  const env::EnvPointer& env = this->envs_[index];
+  const storage::ObservationBufferPointer& observation_buffer = this->observation_buffers_[index];
+  const modules::ActorCriticPointer& actor_critic = this->actor_critics_[index];
+  const unsigned int num_envs = this->actor_cfgs_[index]->env_cfg.num_envs;
+  const unsigned int num_steps = this->cfg_->runner_cfg.num_steps_per_env;
+  const float gamma = this->cfg_->ppo_cfg.gamma;
+  const auto bool_options = torch::TensorOptions().device(this->device_).dtype(torch::kBool);
+
+  env::Results results;
+  results.actor_obs = torch::zeros({num_envs, env->get_actor_obs_size()}, this->device_);
+  results.critic_obs = torch::zeros({num_envs, env->get_critic_obs_size()}, this->device_);
+  results.rewards = torch::zeros({num_envs}, this->device_);
+  results.terminated = torch::zeros({num_envs}, bool_options);
+  results.truncated = torch::zeros({num_envs}, bool_options);
+
+  Tensor reward_sum = torch::zeros({num_envs}, this->device_);
+  Tensor episode_length =
+    torch::zeros({num_envs}, torch::TensorOptions().device(this->device_).dtype(torch::kInt32));
+
+  env->reset(results);
+  observation_buffer->reset(results);
+
+  algorithms::PolicySnapshotPointer snapshot;
+  while (this->running_.load(std::memory_order_relaxed)) {
+    // Pick up the latest published weights between segments
+    const algorithms::PolicySnapshotPointer latest = this->train_algorithm_->get_snapshot();
+    if (!snapshot || latest->version != snapshot->version) {
+      actor_critic->set_state(latest->state);
+      snapshot = latest;
+    }
+
+    storage::TrajectoryPointer trajectory = std::make_unique<storage::Trajectory>();
+    trajectory->actor_obs =
+      torch::empty({num_steps, num_envs, observation_buffer->get_actor_obs_size()}, this->device_);
+    trajectory->critic_obs = torch::empty(
+      {num_steps, num_envs, observation_buffer->get_critic_obs_size()}, this->device_);
+    trajectory->actions =
+      torch::empty({num_steps, num_envs, env->get_action_size()}, this->device_);
+    trajectory->rewards = torch::empty({num_steps, num_envs, 1}, this->device_);
+    trajectory->dones = torch::empty({num_steps, num_envs, 1}, this->device_);
+    trajectory->log_probs = torch::empty({num_steps, num_envs, 1}, this->device_);
+    trajectory->policy_version = snapshot->version;
+
+    // Ends before the back-pressure wait below
+    std::optional<utils::PerfScope> perf_scope(std::in_place, utils::PerfPhase::kCollection);
+    for (unsigned int step = 0; step < num_steps; ++step) {
+      const Tensor& actor_obs = observation_buffer->get_actor_obs();
+      const Tensor& critic_obs = observation_buffer->get_critic_obs();
+      trajectory->actor_obs[step].copy_(actor_obs);
+      trajectory->critic_obs[step].copy_(critic_obs);
+
+      std::optional<utils::ScopedSpan> span(std::in_place, utils::Span::kAct);
+      const auto& [actions, values] = actor_critic->forward_evaluate(actor_obs, critic_obs);
+      trajectory->actions[step].copy_(actions);
+      trajectory->log_probs[step].copy_(actor_critic->get_actions_log_prob(actions));
+
+      span.emplace(utils::Span::kEnvStep);
+      {
+        const utils::PerfScope step_perf_scope(utils::PerfPhase::kEnvStep);
+        env->step(results, actions);
+      }
+      span.emplace(utils::Span::kMemorize);
+      observation_buffer->memorize(results, actions);
+      span.reset();
+
+      // Truncated episodes are bootstrapped with the behaviour value, as in PPO::process_step
+      const Tensor& done_ids = results.terminated | results.truncated;
+      trajectory->rewards[step].copy_(
+        (results.rewards + gamma * values.squeeze(1) * results.truncated).view({-1, 1}));
+      trajectory->dones[step].copy_(done_ids.view({-1, 1}));
+
+      reward_sum += results.rewards;
+      episode_length += 1;
+
+      if (done_ids.sum().item<int>() > 0) {
+        const utils::ScopedSpan reset_span(utils::Span::kReset);
+        const std::vector<float>& rewards =
+          utils::tensor_to_vector<float>(reward_sum.index({done_ids}).cpu());
+        const std::vector<int>& lengths =
+          utils::tensor_to_vector<int>(episode_length.index({done_ids}).cpu());
+        trajectory->episode_rewards.insert(trajectory->episode_rewards.end(), rewards.begin(),
+                                           rewards.end());
+        trajectory->episode_lengths.insert(trajectory->episode_lengths.end(), lengths.begin(),
+                                           lengths.end());
+
+        reward_sum.index_put_({done_ids}, 0.0);
+        episode_length.index_put_({done_ids}, 0);
+
+        env->reset(results, done_ids);
+        observation_buffer->reset(results, done_ids);
+      }
+    }
+    trajectory->last_critic_obs = observation_buffer->get_critic_obs().clone();
+    perf_scope.reset();
+
+    // Back-pressure: a full queue stalls the actor instead of dropping data
+    if (!this->queue_.try_push(std::move(trajectory))) {
+      bool pushed = false;
+      std::unique_lock<std::mutex> lock(this->queue_mutex_);
+      this->slot_free_.wait(lock, [this, &trajectory, &pushed] {
+        pushed = this->queue_.try_push(std::move(trajectory));
+        return pushed || !this->running_.load();
+      });
+      if (!pushed) return;
+    }
+    this->notify_(this->trajectory_ready_);
+  }
+}
+
+}  // namespace runners
@@ -0,0 +1,91 @@
+#include "runners/metrics_logger.h"
+
+#include <torch/torch.h>
+
+#include <iostream>
+
+namespace runners {
+
+// Records the training thread may get ahead of the logging thread
+constexpr size_t kQueueCapacity = 64;
+// Idle wait of the logging thread between polls of the queue
+constexpr auto kPollInterval = std::chrono::milliseconds(5);
+
+MetricsLogger::MetricsLogger(const string& event_path, const configs::RunnerCfg& cfg)
+  : warmup_(cfg.logging_warmup),
+    console_verbosity_(cfg.console_verbosity),
+    console_interval_(cfg.console_interval),
+    tensorboard_(event_path.c_str()),
+    queue_(kQueueCapacity) {
+  this->thread_ = std::thread(&MetricsLogger::logger_loop_, this);
+}
+
+MetricsLogger::~MetricsLogger() {
+  this->running_ = false;
+  this->thread_.join();
+  if (this->num_dropped_ > 0)
+    std::cerr << "Metrics logger dropped " << this->num_dropped_ << " records" << std::endl;
+}
+
+void MetricsLogger::push(TrainMetrics&& metric, const Tensor& action_std) {
+  // The clone is queued on the device, the logging thread waits for it when copying to the host
+  const unsigned int iteration = metric.current_iteration;
+  const bool last = iteration == metric.end_iteration;
+  Record record{std::make_unique<TrainMetrics>(std::move(metric)),
+                action_std.defined() ? action_std.detach().clone() : Tensor()};
+  if (this->queue_.try_push(std::move(record))) return;
+
+  // The final record is never dropped, the training thread waits for a free slot
+  if (last) {
+    while (!this->queue_.try_push(std::move(record))) std::this_thread::sleep_for(kPollInterval);
+    return;
+  }
+  const unsigned int num_dropped = ++this->num_dropped_;
+  std::cerr << "Metrics logger is behind, dropped the record of iteration " << iteration << " ("
+            << num_dropped << " so far)" << std::endl;
+}
+
+void MetricsLogger::logger_loop_() {
+  Record record;
+  while (true) {
+    // Read before popping, so records pushed before the stop request are still written
+    const bool running = this->running_;
+    bool popped = false;
+    while (this->queue_.try_pop(record)) {
+      this->write_(record);
+      popped = true;
+    }
+    if (!running) return;
+    if (!popped) std::this_thread::sleep_for(kPollInterval);
+  }
+}
+
+void MetricsLogger::write_(const Record& record) {
+  std::map<string, float> action_stds;
+  if (record.action_std.defined()) {
+    const std::vector<float>& values = utils::tensor_to_vector<float>(
+      record.action_std.to(torch::kCPU, torch::kFloat).contiguous());
+    for (size_t i = 0; i < values.size(); ++i)
+      action_stds["action_std_" + std::to_string(i)] = values[i];
+  }
+  const TrainMetrics& metric = record.metric->with_extra_values(action_stds);
+
+  // Rate limited, but the final iteration is always printed
+  const auto& now = std::chrono::steady_clock::now();
+  const bool last = metric.current_iteration == metric.end_iteration;
+  if (this->console_verbosity_ > 0 &&
+      (last || std::chrono::duration<float>(now - this->last_print_).count() >=
+                 this->console_interval_)) {
+    if (this->console_verbosity_ == 1)
+      std::cout << metric.summary() << std::endl;
+    else
+      std::cout << metric << std::endl;
+    this->last_print_ = now;
+  }
+
+  if (metric.current_iteration < this->warmup_) return;
+  for (const auto& [key, value] : metric.to_dict())
+    this->tensorboard_.add_scalar(key, metric.current_iteration, value);
+}
+
+}  // namespace runners
@@ -2,32 +2,53 @@
 
 #include <torch/torch.h>
 
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <future>
+#include <optional>
+
 #include "env/task_manager.h"
+#include "inference/exporter.h"
+#include "inference/quantized_policy.h"
+#include "storage/mmap_checkpoint.h"
+#include "utils/perf_counters.h"
+#include "utils/trace.h"
 #include "utils/utils.h"
 
 namespace runners {
 
 OnPolicyRunner::OnPolicyRunner(const string& task, const configs::CfgPointer& cfg,
-                               const Device& device)
-  : cfg_(cfg), device_(device) {
+                               const Device& device,
+                               const distributed::ProcessGroupPointer& process_group,
+                               const bool& headless)
+  : cfg_(cfg),
+    run_path_(utils::get_run_path(cfg->env_cfg.task)),
+    headless_(headless),
+    device_(device) {
   this->env_ = std::move(env::TaskManager::create(task, cfg->env_cfg, device));
   this->observation_buffer_ = std::make_unique<storage::ObservationBuffer>(
     cfg, this->env_->get_actor_obs_size(), this->env_->get_critic_obs_size(),
     this->env_->get_action_size(), device);
   this->update_cfg_();
-  std::cout << *this->cfg_ << std::endl;
-  this->train_algorithm_ = std::make_unique<algorithms::PPO>(cfg, device);
+  if (this->is_main_() && !headless) std::cout << *this->cfg_ << std::endl;
+  this->train_algorithm_ = std::make_unique<algorithms::PPO>(cfg, device, process_group);
   this->reward_buffer_ =
     std::make_unique<storage::CircularBufferFloat>(cfg->runner_cfg.logging_buffer);
   this->length_buffer_ =
     std::make_unique<storage::CircularBufferInt>(cfg->runner_cfg.logging_buffer);
-  const string run_path = utils::get_run_path(this->cfg_->env_cfg.task);
-  this->logger_ = std::make_unique<TensorBoardLogger>(run_path + "/tensorboard.tfevents");
+  // Only the main process writes tensorboard events and checkpoints
+  if (this->is_main_() && !headless) {
+    this->logger_ = std::make_unique<MetricsLogger>(this->run_path_ + "/tensorboard.tfevents",
+                                                    cfg->runner_cfg);
+    this->checkpoint_manager_ = std::make_unique<storage::CheckpointManager>(
+      this->run_path_, cfg->runner_cfg.save_interval, cfg->runner_cfg.max_checkpoints);
+  }
 
   this->initialize_();
 }
 
-void OnPolicyRunner::learn() {
+void OnPolicyRunner::learn(const IterationCallback& callback) {
   this->total_time_steps_ = 0;
 
   this->collection_time_ = 0.;
@@ -40,6 +61,13 @@ void OnPolicyRunner::learn() {
   this->reward_buffer_->clear();
   this->length_buffer_->clear();
 
+  // Live counters for `cpp_rl_watch`, published by the main process only
+  if (this->is_main_() && !this->headless_)
+    this->live_metrics_ = std::make_unique<LiveMetricsWriter>(
+      live_metrics_name(this->cfg_->env_cfg.task, ::getpid()));
+
+  if (this->cfg_->runner_cfg.perf_counters) utils::PerfCounters::instance().enable();
+
   this->train_();
 
   this->env_->reset(this->env_results_);
@@ -48,58 +76,55 @@ void OnPolicyRunner::learn() {
   unsigned int start = this->current_learning_iteration_;
   unsigned int end = this->cfg_->runner_cfg.max_iterations + start;
 
-  Tensor actions =
-    torch::zeros({this->cfg_->env_cfg.num_envs, this->env_->get_action_size()}, this->device_);
-  for (unsigned int it = start; it < end; ++it) {
-    auto start_time = std::chrono::high_resolution_clock::now();
+  // The first rollout is collected upfront, afterwards the next rollout is collected on a
+  // background thread while the learner updates on the current one
+  const bool overlap = this->cfg_->runner_cfg.overlap_collection;
+  if (overlap) {
+    this->set_phase_(Phase::kCollecting);
+    this->collect_rollout_();
+    this->train_algorithm_->swap_rollouts();
+  }
 
-    // Rollout
-    {
-      torch::NoGradGuard no_grad;
-      for (unsigned int i = 0; i < this->cfg_->runner_cfg.num_steps_per_env; ++i) {
-        this->train_algorithm_->act(actions, this->observation_buffer_->get_actor_obs(),
-                                    this->observation_buffer_->get_critic_obs());
-        this->env_->step(this->env_results_, actions);
-        this->observation_buffer_->memorize(this->env_results_, actions);
-
-        this->train_algorithm_->process_step(
-          this->env_results_.rewards, this->env_results_.terminated, this->env_results_.truncated);
-
-        this->current_reward_sum_ += this->env_results_.rewards;
-        this->current_episode_length_ += 1;
-
-        const Tensor& done_ids = (this->env_results_.terminated | this->env_results_.truncated);
-
-        if (done_ids.sum().item<int>() > 0) {
-          this->reward_buffer_->push(
-            utils::tensor_to_vector<float>(this->current_reward_sum_.index({done_ids}).cpu()));
-          this->length_buffer_->push(
-            utils::tensor_to_vector<int>(this->current_episode_length_.index({done_ids}).cpu()));
-
-          this->current_reward_sum_.index_put_({done_ids}, 0.0);
-          this->current_episode_length_.index_put_({done_ids}, 0);
-
-          this->env_->reset(this->env_results_, done_ids);
-          this->observation_buffer_->reset(this->env_results_, done_ids);
-        }
-      }
-      this->collection_time_ =
-        std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start_time)
-          .count();
-
-      // Learning step
-      start_time = std::chrono::high_resolution_clock::now();
-      this->train_algorithm_->compute_returns(this->observation_buffer_->get_critic_obs());
-    }
+  utils::TraceSessionPointer trace_session;
+  if (this->is_main_() && !this->headless_)
+    trace_session = std::make_unique<utils::TraceSession>(
+      this->run_path_, this->cfg_->runner_cfg.trace_windows, this->cfg_->runner_cfg.trace_autograd);
 
-    const algorithms::LossMetrics loss_metrics = this->train_algorithm_->update_actor_critic();
+  for (unsigned int it = start; it < end; ++it) {
+    if (trace_session) trace_session->begin_iteration(it);
+    const auto iteration_start_time = std::chrono::high_resolution_clock::now();
+
+    std::future<void> collection;
+    if (!overlap) {
+      this->set_phase_(Phase::kCollecting);
+      this->collect_rollout_();
+    } else if (it + 1 < end)
+      collection = std::async(std::launch::async, [this] { this->collect_rollout_(); });
+
+    // Learning step
+    this->set_phase_(Phase::kLearning);
+    const auto start_time = std::chrono::high_resolution_clock::now();
+    const algorithms::LossMetrics& loss_metrics = [this] {
+      const utils::PerfScope perf_scope(utils::PerfPhase::kLearning);
+      return this->train_algorithm_->update_actor_critic();
+    }();
     this->learn_time_ =
       std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start_time).count();
     this->current_learning_iteration_ += 1;
 
+    if (collection.valid()) {
+      this->set_phase_(Phase::kCollecting);
+      collection.get();
+      this->train_algorithm_->swap_rollouts();
+    }
+
     // Logging
-    float iteration_time = this->collection_time_ + this->learn_time_;
-    int time_steps = this->cfg_->env_cfg.num_envs * this->cfg_->runner_cfg.num_steps_per_env;
+    this->set_phase_(Phase::kLogging);
+    const int64_t logging_start_ns = utils::trace_clock_ns();
+    const auto end_time = std::chrono::high_resolution_clock::now();
+    float iteration_time = std::chrono::duration<float>(end_time - iteration_start_time).count();
+    int time_steps = this->cfg_->env_cfg.num_envs * this->cfg_->runner_cfg.num_steps_per_env *
+                     this->cfg_->distributed_cfg.world_size;
     this->total_time_ += iteration_time;
     this->total_time_steps_ += time_steps;
 
@@ -109,31 +134,121 @@ void OnPolicyRunner::learn() {
     const RewardMetrics reward_metrics{this->reward_buffer_->mean(), this->length_buffer_->mean()};
 
     std::map<string, float> extra_values;
-    const Tensor action_stds = this->train_algorithm_->get_action_std().cpu();
-    for (int i = 0; i < action_stds.size(0); ++i) {
-      extra_values["action_std_" + std::to_string(i)] = action_stds[i].item<float>();
-    }
     extra_values["learning_rate"] = this->train_algorithm_->get_learning_rate();
     const ExtraMetrics extra_metrics{extra_values};
 
     const TotalMetrics total_metrics{this->total_time_steps_, this->total_time_};
 
-    const TrainMetrics metric{this->current_learning_iteration_,
-                              end,
-                              computation_metrics,
-                              loss_metrics,
-                              reward_metrics,
-                              total_metrics,
-                              extra_metrics};
+    std::map<string, float> memory_values;
+    if (this->cfg_->runner_cfg.memory_accounting) {
+      memory_values = this->memory_report().to_megabytes();
+      memory_values["allocations_per_step"] = this->allocations_per_step_;
+      memory_values["allocated_mb_per_step"] = this->allocated_bytes_per_step_ / (1024.f * 1024.f);
+    }
 
-    this->log_metric_(metric);
+    TrainMetrics metric{this->current_learning_iteration_,
+                        end,
+                        computation_metrics,
+                        loss_metrics,
+                        reward_metrics,
+                        total_metrics,
+                        extra_metrics,
+                        TimingMetrics{utils::Tracer::instance().pop_timings()},
+                        HardwareMetrics{utils::PerfCounters::instance().pop_metrics()},
+                        MemoryMetrics{memory_values}};
+
+    if (this->live_metrics_) {
+      metric.to_live_counters(this->live_metrics_->counters());
+      this->live_metrics_->counters().num_episodes = this->reward_buffer_->size();
+      this->live_metrics_->publish();
+    }
+    const bool proceed = !callback || callback(metric);
+    if (this->logger_)
+      this->logger_->push(std::move(metric), this->train_algorithm_->get_action_std());
+    utils::Tracer::instance().record(utils::Span::kLogging, logging_start_ns,
+                                     utils::trace_clock_ns());
 
     // Save models
-    if (it + 1 % this->cfg_->runner_cfg.save_interval == 0)
-      this->save_models("/models_" + std::to_string(this->current_learning_iteration_) + ".pt");
+    if (this->checkpoint_manager_ && this->checkpoint_manager_->is_due(it + 1)) {
+      this->set_phase_(Phase::kSaving);
+      this->save_models("/models_" + std::to_string(this->current_learning_iteration_) + ".pt",
+                        /*periodic=*/true);
+    }
+    if (trace_session) trace_session->end_iteration(it);
+    if (!proceed) break;
   }
-  // Save models
+  // Save models, plus the mapped inference checkpoint that play and evaluation load
+  this->set_phase_(Phase::kSaving);
   this->save_models("/models_last.pt");
+  if (this->checkpoint_manager_) {
+    this->checkpoint_manager_->save(
+      storage::MmapCheckpoint::serialize(*this->train_algorithm_->get_actor_critic()),
+      "/models_last.map");
+    this->checkpoint_manager_->wait();
+  }
+  // Publishes the finished phase and removes the segment
+  this->live_metrics_.reset();
+}
+
+void OnPolicyRunner::collect_rollout_() {
+  // Grad mode is thread local, the rollout may run on the collection thread
+  torch::NoGradGuard no_grad;
+  const utils::PerfScope perf_scope(utils::PerfPhase::kCollection);
+  const auto start_time = std::chrono::high_resolution_clock::now();
+  std::optional<utils::AllocationScope> allocation_scope;
+  if (this->cfg_->runner_cfg.memory_accounting) allocation_scope.emplace();
+  for (unsigned int i = 0; i < this->cfg_->runner_cfg.num_steps_per_env; ++i) {
+    {
+      const utils::ScopedSpan span(utils::Span::kAct);
+      this->train_algorithm_->act(this->actions_, this->observation_buffer_->get_actor_obs(),
+                                  this->observation_buffer_->get_critic_obs());
+    }
+    {
+      const utils::ScopedSpan span(utils::Span::kEnvStep);
+      const utils::PerfScope perf_scope(utils::PerfPhase::kEnvStep);
+      this->env_->step(this->env_results_, this->actions_);
+    }
+    {
+      const utils::ScopedSpan span(utils::Span::kMemorize);
+      this->observation_buffer_->memorize(this->env_results_, this->actions_);
+    }
+    {
+      const utils::ScopedSpan span(utils::Span::kProcessStep);
+      this->train_algorithm_->process_step(this->env_results_.rewards,
+                                           this->env_results_.terminated,
+                                           this->env_results_.truncated);
+    }
+
+    this->current_reward_sum_ += this->env_results_.rewards;
+    this->current_episode_length_ += 1;
+
+    const Tensor& done_ids = (this->env_results_.terminated | this->env_results_.truncated);
+
+    if (done_ids.sum().item<int>() > 0) {
+      const utils::ScopedSpan span(utils::Span::kReset);
+      this->reward_buffer_->push(
+        utils::tensor_to_vector<float>(this->current_reward_sum_.index({done_ids}).cpu()));
+      this->length_buffer_->push(
+        utils::tensor_to_vector<int>(this->current_episode_length_.index({done_ids}).cpu()));
+
+      this->current_reward_sum_.index_put_({done_ids}, 0.0);
+      this->current_episode_length_.index_put_({done_ids}, 0);
+
+      this->env_->reset(this->env_results_, done_ids);
+      this->observation_buffer_->reset(this->env_results_, done_ids);
+    }
+  }
+  if (allocation_scope) {
+    const float num_steps = this->cfg_->runner_cfg.num_steps_per_env;
+    this->allocations_per_step_ = allocation_scope->counter().allocations() / num_steps;
+    this->allocated_bytes_per_step_ = allocation_scope->counter().allocated_bytes() / num_steps;
+  }
+  {
+    const utils::ScopedSpan span(utils::Span::kComputeAdvantage);
+    this->train_algorithm_->compute_returns(this->observation_buffer_->get_critic_obs());
+  }
+  this->collection_time_ =
+    std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start_time).count();
 }
 
 void OnPolicyRunner::play() {
@@ -157,21 +272,188 @@ void OnPolicyRunner::play() {
   this->env_->render();
 }
 
-void OnPolicyRunner::save_models(const string& name) const {
-  torch::serialize::OutputArchive archive;
-  this->train_algorithm_->save_models(archive);
-
-  const string run_path = utils::get_run_path(this->cfg_->env_cfg.task);
-  archive.save_to(run_path + name);
+void OnPolicyRunner::save_models(const string& name, const bool& periodic) const {
+  if (!this->checkpoint_manager_) return;
+  this->checkpoint_manager_->save(this->train_algorithm_->snapshot_models(), name, periodic);
 }
 
 void OnPolicyRunner::load_models(const string& name, const bool& load_optimizer) {
+  if (this->checkpoint_manager_) this->checkpoint_manager_->wait();
+  // Inference only: map the weights of an up-to-date sibling .map checkpoint instead
+  const std::filesystem::path& path = this->run_path_ + name;
+  const std::filesystem::path& mapped_path = std::filesystem::path(path).replace_extension(".map");
+  if (!load_optimizer && std::filesystem::exists(mapped_path) &&
+      std::filesystem::last_write_time(mapped_path) >= std::filesystem::last_write_time(path)) {
+    this->train_algorithm_->load_inference_models(storage::MmapCheckpoint(mapped_path.string()));
+    return;
+  }
   torch::serialize::InputArchive archive;
-  const string run_path = utils::get_run_path(this->cfg_->env_cfg.task);
-  archive.load_from(run_path + name);
+  archive.load_from(path.string());
   this->train_algorithm_->load_models(archive, load_optimizer);
 }
 
+void OnPolicyRunner::export_policy(const string& name) const {
+  const string flags = inference::export_policy(*this->train_algorithm_->get_actor_critic(),
+                                                this->cfg_->actor_cfg, this->run_path_ + name);
+  std::cout << "Policy written to " << this->run_path_ + name << std::endl;
+  std::cout << "Build the evaluator with: cmake " << flags << std::endl;
+}
+
+bool OnPolicyRunner::quantize_policy(const string& name) {
+  torch::NoGradGuard no_grad;
+  const configs::QuantizationCfg& quantization_cfg = this->cfg_->quantization_cfg;
+  const unsigned int num_episodes = quantization_cfg.num_episodes;
+  this->eval_();
+  const auto& policy = this->get_inference_policy();
+
+  // Calibrate on the observations visited by the fp32 policy
+  std::vector<Tensor> observations;
+  Tensor fp32_returns = torch::zeros({0}, this->device_);
+  for (unsigned int seed = 0; seed < num_episodes; ++seed)
+    fp32_returns = torch::cat({fp32_returns, this->evaluate_(policy, seed, observations)});
+  const Tensor& calibration_obs = torch::cat(observations).to(torch::kCPU, torch::kFloat);
+
+  const inference::PolicyFile& policy_file =
+    inference::to_policy_file(*this->train_algorithm_->get_actor_critic(), this->cfg_->actor_cfg);
+  inference::QuantizedPolicy quantized = inference::QuantizedPolicy::calibrate(
+    policy_file, utils::tensor_to_vector<float>(calibration_obs.contiguous()));
+  const auto& quantized_policy = [&quantized](const Tensor& obs) {
+    const Tensor& inputs = obs.to(torch::kCPU, torch::kFloat).contiguous();
+    const Tensor& actions = torch::empty({inputs.size(0), quantized.num_actions()});
+    quantized.act(inputs.data_ptr<float>(), actions.data_ptr<float>(), inputs.size(0));
+    return actions.to(obs.device());
+  };
+
+  // Same seeds, so both policies start every episode from the same states
+  std::vector<Tensor> int8_observations;
+  Tensor int8_returns = torch::zeros({0}, this->device_);
+  for (unsigned int seed = 0; seed < num_episodes; ++seed)
+    int8_returns =
+      torch::cat({int8_returns, this->evaluate_(quantized_policy, seed, int8_observations)});
+  this->env_->close();
+
+  const Tensor& action_error =
+    (policy(calibration_obs.to(this->device_)).cpu() - quantized_policy(calibration_obs)).abs();
+  const float mean_action_error = action_error.mean().item<float>();
+  const float fp32_return = fp32_returns.mean().item<float>();
+  const float int8_return = int8_returns.mean().item<float>();
+  const float return_drop = (fp32_return - int8_return) / std::max(std::abs(fp32_return), EPS);
+  std::cout << "Calibration observations: " << calibration_obs.size(0) << std::endl;
+  std::cout << "Mean action error: " << mean_action_error << " (max "
+            << action_error.max().item<float>() << ")" << std::endl;
+  std::cout << "Mean episode return fp32: " << fp32_return << ", int8: " << int8_return
+            << std::endl;
+  std::cout << "Policy bytes fp32: " << policy_file.num_bytes()
+            << ", int8: " << quantized.num_bytes() << std::endl;
+
+  quantized.save(this->run_path_ + name);
+  std::cout << "Quantized policy written to " << this->run_path_ + name << std::endl;
+
+  bool accurate = true;
+  if (mean_action_error > quantization_cfg.max_action_error) {
+    std::cout << "Error: Mean action error exceeds max_action_error "
+              << quantization_cfg.max_action_error << std::endl;
+    accurate = false;
+  }
+  if (return_drop > quantization_cfg.max_return_drop) {
+    std::cout << "Error: Relative return drop " << return_drop << " exceeds max_return_drop "
+              << quantization_cfg.max_return_drop << std::endl;
+    accurate = false;
+  }
+  return accurate;
+}
+
+Tensor OnPolicyRunner::evaluate_(const std::function<Tensor(const Tensor&)>& policy,
+                                 const int& seed, std::vector<Tensor>& observations) {
+  torch::manual_seed(seed);
+  this->env_->reset(this->env_results_);
+  this->observation_buffer_->reset(this->env_results_);
+  Tensor returns = torch::zeros({this->cfg_->env_cfg.num_envs}, this->device_);
+  Tensor running =
+    torch::ones({this->cfg_->env_cfg.num_envs}, torch::dtype(torch::kBool).device(this->device_));
+  while (running.any().item<bool>()) {
+    const Tensor& actor_obs = this->observation_buffer_->get_actor_obs();
+    observations.push_back(actor_obs.index({running}).clone());
+    const Tensor actions = policy(actor_obs);
+    this->env_->step(this->env_results_, actions);
+    this->observation_buffer_->memorize(this->env_results_, actions);
+    returns += this->env_results_.rewards * running;
+    running &= ~(this->env_results_.terminated | this->env_results_.truncated);
+  }
+  return returns;
+}
+
+const utils::MemoryReport OnPolicyRunner::memory_report() const {
+  utils::MemoryReport report;
+  report.add("env", this->env_->memory_bytes() + this->env_results_.memory_bytes() +
+                      utils::tensor_bytes(this->actions_) +
+                      utils::tensor_bytes(this->current_reward_sum_) +
+                      utils::tensor_bytes(this->current_episode_length_));
+  report.add("observation_buffer", this->observation_buffer_->memory_bytes());
+  report.add(this->train_algorithm_->memory_report());
+  return report;
+}
+
+const utils::MemoryReport OnPolicyRunner::predict_memory(const string& task,
+                                                         const configs::CfgPointer& cfg) {
+  // Per-env buffers and the networks are small enough to build on the host and measure, everything
+  // scaling with the rollout length is derived from the shapes the training run would allocate
+  const env::EnvPointer& env = env::TaskManager::create(task, cfg->env_cfg, torch::kCPU);
+  const storage::ObservationBuffer observation_buffer(cfg, env->get_actor_obs_size(),
+                                                      env->get_critic_obs_size(),
+                                                      env->get_action_size(), torch::kCPU);
+  cfg->update(observation_buffer.get_actor_obs_size(), observation_buffer.get_critic_obs_size(),
+              env->get_action_min(), env->get_action_max());
+  const modules::ActorCritic actor_critic(cfg->actor_cfg, cfg->critic_cfg,
+                                          cfg->ppo_cfg.fused_actor_critic);
+
+  const int64_t float_bytes = sizeof(float);
+  const int64_t num_envs = cfg->env_cfg.num_envs;
+  const int64_t num_samples = num_envs * cfg->runner_cfg.num_steps_per_env;
+  const int64_t num_rollouts = cfg->runner_cfg.overlap_collection ? 2 : 1;
+  const int64_t batch_size = num_samples / cfg->ppo_cfg.num_batches;
+
+  int64_t kl_size = 0;
+  for (const auto& [key, value] : actor_critic.get_distribution_kl_params())
+    kl_size += value.size(0);
+  // Observations, actions, distribution parameters, rewards, advantages, dones, values, log probs
+  const int64_t sample_bytes =
+    (cfg->actor_cfg.mlp_cfg.num_inputs + cfg->critic_cfg.mlp_cfg.num_inputs +
+     cfg->actor_cfg.mlp_cfg.num_outputs + kl_size + 5) *
+    float_bytes;
+
+  int64_t parameter_bytes = 0;
+  for (const Tensor& parameter : actor_critic.parameters())
+    parameter_bytes += utils::tensor_bytes(parameter);
+
+  utils::MemoryReport report;
+  // Results, actions, episode sums and lengths of the runner
+  report.add("env", env->predicted_memory_bytes() +
+                      num_envs * (env->get_actor_obs_size() + env->get_critic_obs_size() +
+                                  env->get_action_size() + 3) *
+                        float_bytes +
+                      num_envs * 2 * sizeof(bool));
+  report.add("observation_buffer", observation_buffer.memory_bytes());
+  // Plus the returns of each storage and the transition being filled
+  report.add("rollout_storage",
+             num_rollouts * num_samples * (sample_bytes + float_bytes) + num_envs * sample_bytes);
+  report.add("minibatches",
+             static_cast<int64_t>(cfg->ppo_cfg.num_epochs * cfg->ppo_cfg.num_batches) *
+               batch_size * sample_bytes);
+  report.add("actor_critic", num_rollouts * utils::module_bytes(actor_critic) + parameter_bytes);
+  report.add("adam", 2 * parameter_bytes);
+  // Inputs and outputs of every hidden layer kept for the backward pass of one minibatch, an MLP
+  // has the input layer plus depth hidden layers of the given width
+  const auto& hidden_units = [](const configs::MLPCfg& mlp_cfg) {
+    return static_cast<int64_t>(mlp_cfg.width) * (mlp_cfg.depth + 1);
+  };
+  report.add("activations", 2 * batch_size *
+                              (hidden_units(cfg->actor_cfg.mlp_cfg) +
+                               hidden_units(cfg->critic_cfg.mlp_cfg)) *
+                              float_bytes);
+  return report;
+}
+
 void OnPolicyRunner::update_cfg_() {
   unsigned int num_actor_obs = this->observation_buffer_->get_actor_obs_size();
   unsigned int num_critic_obs = this->observation_buffer_->get_critic_obs_size();
@@ -181,6 +463,7 @@ void OnPolicyRunner::update_cfg_() {
 
 void OnPolicyRunner::initialize_() {
   this->env_->initialize();
+  if (this->cfg_->runner_cfg.scripted_step) this->env_->enable_scripted_step();
   this->env_results_.actor_obs =
     torch::zeros({this->cfg_->env_cfg.num_envs, this->env_->get_actor_obs_size()}, this->device_);
   this->env_results_.critic_obs =
@@ -193,18 +476,12 @@ void OnPolicyRunner::initialize_() {
     torch::zeros({this->cfg_->env_cfg.num_envs},
                  torch::TensorOptions().device(this->device_).dtype(torch::kBool));
 
+  this->actions_ =
+    torch::zeros({this->cfg_->env_cfg.num_envs, this->env_->get_action_size()}, this->device_);
   this->current_reward_sum_ = torch::zeros({this->cfg_->env_cfg.num_envs}, this->device_);
   this->current_episode_length_ =
     torch::zeros({this->cfg_->env_cfg.num_envs},
                  torch::TensorOptions().device(this->device_).dtype(torch::kInt32));
 }
 
-void OnPolicyRunner::log_metric_(const TrainMetrics& metric) const {
-  std::cout << metric << std::endl;
-  if (this->current_learning_iteration_ < this->cfg_->runner_cfg.logging_warmup) return;
-  const std::map<string, float> data = metric.to_dict();
-  for (const auto& [key, value] : data)
-    this->logger_->add_scalar(key, this->current_learning_iteration_, value);
-}
-
 }  // namespace runners
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "runners/sweep.h"
+
+#include <torch/torch.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "configs/load_yaml.h"
+#include "runners/on_policy_runner.h"
+#include "utils/memory.h"
+
+namespace runners {
+
+constexpr float kMegabyte = 1024.f * 1024.f;
+
+static const std::vector<string> kColumns{
+  "num_envs",       "num_threads",     "num_steps_per_env", "num_batches",
+  "fps",            "iteration_time",  "collection_time",   "learn_time",
+  "peak_rss_mb",    "tensor_mb",       "env_efficiency",    "thread_efficiency"};
+
+static std::vector<unsigned int> sweep_values(const YAML::Node& sweep, const string& key) {
+  if (!sweep[key] || sweep[key].size() == 0)
+    throw std::invalid_argument("Sweep needs a non-empty list of " + key);
+  return sweep[key].as<std::vector<unsigned int>>();
+}
+
+static SweepResult run_point(const string& task, const YAML::Node& train_config,
+                             const YAML::Node& play_config, const SweepPoint& point,
+                             const unsigned int& warmup_iterations,
+                             const unsigned int& iterations, const Device& device) {
+  YAML::Node config = YAML::Clone(train_config);
+  config["env"]["num_envs"] = point.num_envs;
+  config["runner"]["num_steps_per_env"] = point.num_steps_per_env;
+  config["runner"]["max_iterations"] = warmup_iterations + iterations;
+  config["ppo"]["num_batches"] = point.num_batches;
+  // A single process, the threads are the swept resource
+  if (config["distributed"]) config["distributed"]["world_size"] = 1;
+  torch::set_num_threads(point.num_threads);
+
+  // Training never creates run_0, the render files of the env are not written
+  const configs::CfgPointer& cfg = configs::load_config(task, config, play_config, false, 0);
+  OnPolicyRunner runner(task, cfg, device, nullptr, /*headless=*/true);
+
+  SweepResult result{point};
+  unsigned int num_timed = 0;
+  utils::reset_peak_resident_bytes();
+  runner.learn([&](const TrainMetrics& metrics) {
+    if (metrics.current_iteration <= warmup_iterations) return true;
+    result.iteration_time += metrics.computation_metrics.iteration_time;
+    result.collection_time += metrics.computation_metrics.collection_time;
+    result.learn_time += metrics.computation_metrics.learn_time;
+    num_timed += 1;
+    return true;
+  });
+
+  result.fps = static_cast<float>(num_timed) * point.num_envs * point.num_steps_per_env /
+               result.iteration_time;
+  result.iteration_time /= num_timed;
+  result.collection_time /= num_timed;
+  result.learn_time /= num_timed;
+  result.peak_rss_mb = utils::peak_resident_bytes() / kMegabyte;
+  result.tensor_mb = runner.memory_report().total() / kMegabyte;
+  return result;
+}
+
+static void compute_efficiencies(std::vector<SweepResult>& results, const unsigned int& min_envs,
+                                 const unsigned int& min_threads) {
+  for (SweepResult& result : results) {
+    const SweepPoint& point = result.point;
+    for (const SweepResult& reference : results) {
+      const SweepPoint& base = reference.point;
+      if (base.num_steps_per_env != point.num_steps_per_env ||
+          base.num_batches != point.num_batches)
+        continue;
+      if (base.num_threads == point.num_threads && base.num_envs == min_envs)
+        result.env_efficiency = result.fps / reference.fps * base.num_envs / point.num_envs;
+      if (base.num_envs == point.num_envs && base.num_threads == min_threads)
+        result.thread_efficiency =
+          result.fps / reference.fps * base.num_threads / point.num_threads;
+    }
+  }
+}
+
+static std::vector<string> to_row(const SweepResult& result) {
+  const SweepPoint& point = result.point;
+  std::vector<string> row{std::to_string(point.num_envs), std::to_string(point.num_threads),
+                          std::to_string(point.num_steps_per_env),
+                          std::to_string(point.num_batches)};
+  for (const float& value :
+       {result.fps, result.iteration_time, result.collection_time, result.learn_time,
+        result.peak_rss_mb, result.tensor_mb, result.env_efficiency, result.thread_efficiency}) {
+    std::ostringstream oss;
+    oss << value;
+    row.push_back(oss.str());
+  }
+  return row;
+}
+
+static void write_report(const string& path, const std::vector<SweepResult>& results) {
+  std::ofstream csv(path + ".csv");
+  std::ofstream markdown(path + ".md");
+  if (!csv || !markdown) throw std::runtime_error("Cannot write sweep report " + path);
+
+  for (size_t i = 0; i < kColumns.size(); ++i) {
+    csv << (i ? "," : "") << kColumns[i];
+    markdown << "| " << kColumns[i] << " ";
+  }
+  csv << std::endl;
+  markdown << "|" << std::endl;
+  for (size_t i = 0; i < kColumns.size(); ++i) markdown << "|---";
+  markdown << "|" << std::endl;
+
+  for (const SweepResult& result : results) {
+    const std::vector<string>& row = to_row(result);
+    for (size_t i = 0; i < row.size(); ++i) {
+      csv << (i ? "," : "") << row[i];
+      markdown << "| " << row[i] << " ";
+    }
+    csv << std::endl;
+    markdown << "|" << std::endl;
+  }
+}
+
+void run_sweep(const string& task, const string& sweep_path, const Device& device) {
+  const YAML::Node& sweep = YAML::LoadFile(sweep_path);
+  const YAML::Node& train_config = YAML::LoadFile("yaml/train.yaml");
+  const YAML::Node& play_config = YAML::LoadFile("yaml/play.yaml");
+
+  const unsigned int warmup_iterations =
+    sweep["warmup_iterations"] ? sweep["warmup_iterations"].as<unsigned int>() : 1;
+  const unsigned int iterations = sweep["iterations"].as<unsigned int>();
+  if (iterations == 0) throw std::invalid_argument("Sweep needs at least one timed iteration");
+  const std::vector<unsigned int>& num_envs = sweep_values(sweep, "num_envs");
+  const std::vector<unsigned int>& num_threads = sweep_values(sweep, "num_threads");
+  const std::vector<unsigned int>& num_steps_per_env = sweep_values(sweep, "num_steps_per_env");
+  const std::vector<unsigned int>& num_batches = sweep_values(sweep, "num_batches");
+  const string output = sweep["output"] ? sweep["output"].as<string>() : "sweep";
+
+  std::vector<SweepResult> results;
+  for (const unsigned int& steps : num_steps_per_env)
+    for (const unsigned int& batches : num_batches)
+      for (const unsigned int& envs : num_envs)
+        for (const unsigned int& threads : num_threads) {
+          const SweepPoint point{envs, threads, steps, batches};
+          results.push_back(
+            run_point(task, train_config, play_config, point, warmup_iterations, iterations,
+                      device));
+          std::cout << "num_envs " << envs << ", threads " << threads << ", steps " << steps
+                    << ", batches " << batches << ": " << results.back().fps << " steps/s"
+                    << std::endl;
+        }
+
+  compute_efficiencies(results, *std::min_element(num_envs.begin(), num_envs.end()),
+                       *std::min_element(num_threads.begin(), num_threads.end()));
+  const string path = "data/" + task + "/" + output;
+  write_report(path, results);
+  std::cout << "Scaling report written to " << path << ".csv and " << path << ".md" << std::endl;
+}
+
+}  // namespace runners
@@ -0,0 +1,121 @@
+#include "runners/target_benchmark.h"
+
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "configs/load_yaml.h"
+#include "runners/on_policy_runner.h"
+
+namespace runners {
+
+// Linear interpolation between the closest ranks, as numpy.percentile
+static float percentile(std::vector<float> values, const float& q) {
+  std::sort(values.begin(), values.end());
+  const float rank = q * (values.size() - 1);
+  const size_t lower = static_cast<size_t>(rank);
+  const size_t upper = std::min(lower + 1, values.size() - 1);
+  return values[lower] + (rank - lower) * (values[upper] - values[lower]);
+}
+
+static string summary_json(const std::vector<float>& values) {
+  if (values.empty()) return "null";
+  const float p25 = percentile(values, 0.25f);
+  const float p75 = percentile(values, 0.75f);
+  std::ostringstream oss;
+  oss << "{\"median\": " << percentile(values, 0.5f) << ", \"p25\": " << p25
+      << ", \"p75\": " << p75 << ", \"iqr\": " << p75 - p25 << "}";
+  return oss.str();
+}
+
+static TargetRun run_seed(const string& task, const YAML::Node& train_config,
+                          const YAML::Node& play_config, const int& seed,
+                          const float& target_reward, const float& time_budget,
+                          const unsigned int& max_iterations, const Device& device) {
+  YAML::Node config = YAML::Clone(train_config);
+  config["env"]["seed"] = seed;
+  config["runner"]["max_iterations"] = max_iterations;
+  if (config["distributed"]) config["distributed"]["world_size"] = 1;
+
+  // Training never creates run_0, the render files of the env are not written
+  const configs::CfgPointer& cfg = configs::load_config(task, config, play_config, false, 0);
+  OnPolicyRunner runner(task, cfg, device, nullptr, /*headless=*/true);
+
+  TargetRun run{seed};
+  const auto start_time = std::chrono::steady_clock::now();
+  runner.learn([&](const TrainMetrics& metrics) {
+    run.time =
+      std::chrono::duration<float>(std::chrono::steady_clock::now() - start_time).count();
+    run.steps = metrics.total_metrics.total_time_steps;
+    run.iterations = metrics.current_iteration;
+    run.fps = metrics.total_metrics.total_time_steps / metrics.total_metrics.total_time;
+    run.final_reward = metrics.reward_metrics.reward;
+    // The reward buffer is empty, and its mean 0, until the first episode finishes
+    run.reached =
+      metrics.reward_metrics.length > 0.f && metrics.reward_metrics.reward >= target_reward;
+    return !run.reached && run.time < time_budget;
+  });
+  return run;
+}
+
+void run_target_benchmark(const string& task, const string& benchmark_path,
+                          const Device& device) {
+  const YAML::Node& benchmark = YAML::LoadFile(benchmark_path);
+  const YAML::Node& train_config = YAML::LoadFile("yaml/train.yaml");
+  const YAML::Node& play_config = YAML::LoadFile("yaml/play.yaml");
+
+  const float target_reward = benchmark["target_reward"].as<float>();
+  const float time_budget = benchmark["time_budget"].as<float>();
+  const unsigned int max_iterations =
+    benchmark["max_iterations"] ? benchmark["max_iterations"].as<unsigned int>()
+                                : train_config["runner"]["max_iterations"].as<unsigned int>();
+  const std::vector<int>& seeds = benchmark["seeds"].as<std::vector<int>>();
+  if (seeds.empty()) throw std::invalid_argument("Benchmark needs at least one seed");
+  const string output = benchmark["output"] ? benchmark["output"].as<string>() : "time_to_target";
+
+  std::vector<TargetRun> runs;
+  std::vector<float> times;
+  std::vector<float> steps;
+  std::vector<float> fps;
+  for (const int& seed : seeds) {
+    runs.push_back(run_seed(task, train_config, play_config, seed, target_reward, time_budget,
+                            max_iterations, device));
+    const TargetRun& run = runs.back();
+    std::cout << "seed " << seed << ": " << (run.reached ? "reached" : "not reached")
+              << " after " << run.time << " s, " << run.steps << " steps, reward "
+              << run.final_reward << std::endl;
+    fps.push_back(run.fps);
+    if (!run.reached) continue;
+    times.push_back(run.time);
+    steps.push_back(static_cast<float>(run.steps));
+  }
+
+  // Time and steps to target are summarised over the seeds that reached it
+  std::ostringstream json;
+  json << "{\n  \"task\": \"" << task << "\",\n  \"target_reward\": " << target_reward
+       << ",\n  \"time_budget\": " << time_budget << ",\n  \"num_seeds\": " << runs.size()
+       << ",\n  \"num_reached\": " << times.size()
+       << ",\n  \"time_to_target\": " << summary_json(times)
+       << ",\n  \"steps_to_target\": " << summary_json(steps)
+       << ",\n  \"fps\": " << summary_json(fps) << ",\n  \"runs\": [";
+  for (size_t i = 0; i < runs.size(); ++i) {
+    const TargetRun& run = runs[i];
+    json << (i ? "," : "") << "\n    {\"seed\": " << run.seed
+         << ", \"reached\": " << (run.reached ? "true" : "false") << ", \"time\": " << run.time
+         << ", \"steps\": " << run.steps << ", \"iterations\": " << run.iterations
+         << ", \"fps\": " << run.fps << ", \"final_reward\": " << run.final_reward << "}";
+  }
+  json << "\n  ]\n}\n";
+
+  const string path = "data/" + task + "/" + output + ".json";
+  std::ofstream file(path);
+  if (!file) throw std::runtime_error("Cannot write benchmark summary " + path);
+  file << json.str();
+  std::cout << json.str() << "Summary written to " << path << std::endl;
+}
+
+}  // namespace runners
@@ -0,0 +1,246 @@
+#include "server/policy_server.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "server/policy_client.h"
+
+namespace server {
+
+PolicyServer::PolicyServer(const configs::CfgPointer& cfg, const string& model_path,
+                           const Device& device)
+  : cfg_(cfg),
+    server_cfg_(cfg->server_cfg),
+    model_path_(model_path),
+    device_(device),
+    num_inputs_(cfg->actor_cfg.mlp_cfg.num_inputs),
+    num_actions_(cfg->actor_cfg.mlp_cfg.num_outputs) {
+  this->model_time_ = std::filesystem::last_write_time(this->model_path_);
+  this->actor_critic_ = this->load_policy_();
+  this->inputs_ = torch::empty({this->server_cfg_.max_batch_size, this->num_inputs_});
+}
+
+PolicyServer::~PolicyServer() {
+  if (this->listen_fd_ >= 0) ::close(this->listen_fd_);
+}
+
+ActorCriticSharedPointer PolicyServer::load_policy_() const {
+  const ActorCriticSharedPointer& actor_critic = std::make_shared<modules::ActorCritic>(
+    this->cfg_->actor_cfg, this->cfg_->critic_cfg, this->cfg_->ppo_cfg.fused_actor_critic);
+  torch::serialize::InputArchive archive;
+  archive.load_from(this->model_path_);
+  torch::serialize::InputArchive actor_critic_archive;
+  archive.read("actor_critic", actor_critic_archive);
+  actor_critic->load(actor_critic_archive);
+  actor_critic->to(this->device_);
+  actor_critic->eval();
+  return actor_critic;
+}
+
+void PolicyServer::serve(const std::atomic<bool>& stop_requested) {
+  sockaddr_un address{};
+  if (this->server_cfg_.socket_path.size() >= sizeof(address.sun_path))
+    throw std::invalid_argument("Socket path too long: " + this->server_cfg_.socket_path);
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, this->server_cfg_.socket_path.c_str(),
+               sizeof(address.sun_path) - 1);
+
+  ::unlink(this->server_cfg_.socket_path.c_str());
+  this->listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (this->listen_fd_ < 0 ||
+      ::bind(this->listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) !=
+        0 ||
+      ::listen(this->listen_fd_, SOMAXCONN) != 0)
+    throw std::runtime_error("Cannot listen on " + this->server_cfg_.socket_path);
+  std::cout << "Serving " << this->model_path_ << " on " << this->server_cfg_.socket_path
+            << std::endl;
+
+  this->running_ = true;
+  this->threads_.emplace_back(&PolicyServer::batch_loop_, this);
+  this->threads_.emplace_back(&PolicyServer::watch_loop_, this);
+
+  pollfd listener{this->listen_fd_, POLLIN, 0};
+  while (!stop_requested) {
+    this->reap_connections_();
+    // Short timeout so a stop request is noticed without a new connection
+    if (::poll(&listener, 1, 100) <= 0) continue;
+    const int fd = ::accept(this->listen_fd_, nullptr, nullptr);
+    if (fd < 0) continue;
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->client_fds_.push_back(fd);
+    Connection& connection = this->connections_.emplace_back();
+    connection.thread = std::thread([this, fd, &connection] {
+      this->connection_loop_(fd);
+      {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->client_fds_.erase(
+          std::find(this->client_fds_.begin(), this->client_fds_.end(), fd));
+        ::close(fd);
+      }
+      connection.done = true;
+    });
+  }
+
+  {
+    // Shutting the sockets down unblocks the connection threads waiting in recv
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->running_ = false;
+    for (const int& fd : this->client_fds_) ::shutdown(fd, SHUT_RDWR);
+  }
+  this->condition_.notify_all();
+  for (Connection& connection : this->connections_) connection.thread.join();
+  this->connections_.clear();
+  for (std::thread& thread : this->threads_) thread.join();
+  this->threads_.clear();
+  ::close(this->listen_fd_);
+  this->listen_fd_ = -1;
+  ::unlink(this->server_cfg_.socket_path.c_str());
+}
+
+void PolicyServer::reap_connections_() {
+  for (auto it = this->connections_.begin(); it != this->connections_.end();) {
+    if (!it->done) {
+      ++it;
+      continue;
+    }
+    it->thread.join();
+    it = this->connections_.erase(it);
+  }
+}
+
+void PolicyServer::connection_loop_(const int fd) {
+  const uint32_t header[2] = {this->num_inputs_, this->num_actions_};
+  if (!write_all(fd, header, sizeof(header))) return;
+
+  std::vector<float> observations(this->num_inputs_);
+  std::vector<float> actions(this->num_actions_);
+  while (this->running_ &&
+         read_all(fd, observations.data(), observations.size() * sizeof(float))) {
+    Request request{observations.data(), actions.data(), Clock::now(), {}};
+    std::future<void> done = request.done.get_future();
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      if (!this->running_) return;
+      this->requests_.push_back(&request);
+    }
+    this->condition_.notify_all();
+    try {
+      done.get();
+    } catch (const std::exception& error) {
+      std::cerr << "Policy evaluation failed: " << error.what() << std::endl;
+      return;
+    }
+    if (!write_all(fd, actions.data(), actions.size() * sizeof(float))) return;
+  }
+}
+
+void PolicyServer::batch_loop_() {
+  torch::NoGradGuard no_grad;
+  const auto& max_wait = std::chrono::microseconds(this->server_cfg_.max_wait_us);
+  std::vector<Request*> batch;
+  batch.reserve(this->server_cfg_.max_batch_size);
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      this->condition_.wait(lock,
+                            [this] { return !this->requests_.empty() || !this->running_; });
+      if (!this->running_) {
+        // Pending connections stop waiting, their sockets are being shut down
+        for (Request* request : this->requests_)
+          request->done.set_exception(
+            std::make_exception_ptr(std::runtime_error("Policy server stopped")));
+        this->requests_.clear();
+        return;
+      }
+      // The oldest request bounds how long the batch may keep filling up
+      const Clock::time_point deadline = this->requests_.front()->arrival + max_wait;
+      this->condition_.wait_until(lock, deadline, [this] {
+        return this->requests_.size() >= this->server_cfg_.max_batch_size || !this->running_;
+      });
+      const size_t batch_size =
+        std::min<size_t>(this->requests_.size(), this->server_cfg_.max_batch_size);
+      batch.assign(this->requests_.begin(), this->requests_.begin() + batch_size);
+      this->requests_.erase(this->requests_.begin(), this->requests_.begin() + batch_size);
+    }
+    this->run_batch_(batch);
+  }
+}
+
+void PolicyServer::run_batch_(std::vector<Request*>& batch) {
+  const int64_t batch_size = static_cast<int64_t>(batch.size());
+  float* inputs = this->inputs_.data_ptr<float>();
+  for (int64_t i = 0; i < batch_size; ++i)
+    std::memcpy(inputs + i * this->num_inputs_, batch[i]->observations,
+                this->num_inputs_ * sizeof(float));
+
+  try {
+    // Snapshot of the current weights, a concurrent hot swap only affects the next batch
+    const ActorCriticSharedPointer& actor_critic = std::atomic_load(&this->actor_critic_);
+    const Tensor& actions =
+      actor_critic->get_inference_policy()(this->inputs_.narrow(0, 0, batch_size).to(this->device_))
+        .to(torch::kCPU, torch::kFloat)
+        .contiguous();
+    const float* outputs = actions.data_ptr<float>();
+    const Clock::time_point now = Clock::now();
+    for (int64_t i = 0; i < batch_size; ++i) {
+      std::memcpy(batch[i]->actions, outputs + i * this->num_actions_,
+                  this->num_actions_ * sizeof(float));
+      this->latencies_.record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - batch[i]->arrival).count());
+      batch[i]->done.set_value();
+    }
+  } catch (const std::exception&) {
+    for (Request* request : batch) request->done.set_exception(std::current_exception());
+  }
+  this->num_requests_ += batch_size;
+  ++this->num_batches_;
+}
+
+void PolicyServer::watch_loop_() {
+  const auto& reload_interval = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<float>(this->server_cfg_.reload_interval));
+  Clock::time_point next_reload = Clock::now() + reload_interval;
+  Clock::time_point last_report = Clock::now();
+  while (this->running_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    if (this->server_cfg_.reload_interval > 0.f && Clock::now() >= next_reload) {
+      next_reload = Clock::now() + reload_interval;
+      std::error_code error_code;
+      const auto& model_time = std::filesystem::last_write_time(this->model_path_, error_code);
+      if (!error_code && model_time != this->model_time_) {
+        // A checkpoint still being written fails to load, it is retried at the next check
+        try {
+          std::atomic_store(&this->actor_critic_, this->load_policy_());
+          this->model_time_ = model_time;
+          std::cout << "Reloaded " << this->model_path_ << std::endl;
+        } catch (const std::exception& error) {
+          std::cerr << "Reload of " << this->model_path_ << " failed: " << error.what()
+                    << std::endl;
+        }
+      }
+    }
+
+    const float elapsed = std::chrono::duration<float>(Clock::now() - last_report).count();
+    if (elapsed >= this->server_cfg_.report_interval) {
+      const uint64_t num_requests = this->num_requests_.exchange(0);
+      const uint64_t num_batches = this->num_batches_.exchange(0);
+      if (num_requests > 0)
+        std::cout << "Requests/s: " << num_requests / elapsed
+                  << ", mean batch: " << static_cast<float>(num_requests) / num_batches
+                  << ", p50: " << this->latencies_.percentile(0.5) / 1e3
+                  << " us, p99: " << this->latencies_.percentile(0.99) / 1e3 << " us"
+                  << std::endl;
+      this->latencies_.reset();
+      last_report = Clock::now();
+    }
+  }
+}
+
+}  // namespace server
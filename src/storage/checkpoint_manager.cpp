@@ -0,0 +1,202 @@
+#include "storage/checkpoint_manager.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <regex>
+
+#include "utils/utils.h"
+
+namespace storage {
+
+// Checkpoints waiting for the writer, the training thread blocks beyond this to bound memory
+constexpr size_t kMaxPendingJobs = 2;
+
+static Tensor cpu_copy(const Tensor& tensor) {
+  if (!tensor.defined()) return tensor;
+  return tensor.detach().to(tensor.options().device(torch::kCPU), /*non_blocking=*/false,
+                            /*copy=*/true);
+}
+
+ArchiveWriter snapshot_module(const torch::nn::Module& module) {
+  std::vector<std::pair<string, Tensor>> parameters;
+  for (const auto& parameter : module.named_parameters(/*recurse=*/false))
+    parameters.emplace_back(parameter.key(), cpu_copy(parameter.value()));
+  std::vector<std::pair<string, Tensor>> buffers;
+  for (const auto& buffer : module.named_buffers(/*recurse=*/false))
+    buffers.emplace_back(buffer.key(), cpu_copy(buffer.value()));
+  std::vector<std::pair<string, ArchiveWriter>> children;
+  for (const auto& child : module.named_children())
+    if (child.value()->is_serializable())
+      children.emplace_back(child.key(), snapshot_module(*child.value()));
+
+  return [parameters = std::move(parameters), buffers = std::move(buffers),
+          children = std::move(children)](torch::serialize::OutputArchive& archive) {
+    for (const auto& [name, parameter] : parameters) archive.write(name, parameter);
+    for (const auto& [name, buffer] : buffers) archive.write(name, buffer, /*is_buffer=*/true);
+    for (const auto& [name, writer] : children) {
+      torch::serialize::OutputArchive child_archive(archive.compilation_unit());
+      writer(child_archive);
+      archive.write(name, child_archive);
+    }
+  };
+}
+
+ArchiveWriter snapshot_optimizer(const torch::optim::Adam& optimizer) {
+  // A detached optimizer over placeholder parameters: Optimizer::save only uses the parameters to
+  // key the state, and load matches them by position
+  std::vector<torch::optim::OptimizerParamGroup> groups;
+  std::vector<std::pair<Tensor, std::unique_ptr<torch::optim::AdamParamState>>> states;
+  const auto& live_states = optimizer.state();
+  using Key = typename std::decay_t<decltype(live_states)>::key_type;
+  for (const auto& group : optimizer.param_groups()) {
+    ListTensor placeholders;
+    for (const Tensor& parameter : group.params()) {
+      placeholders.push_back(torch::empty({0}));
+      const auto& found = live_states.find(utils::optimizer_state_key<Key>(parameter));
+      if (found == live_states.end()) continue;
+      const auto& live_state = static_cast<const torch::optim::AdamParamState&>(*found->second);
+      auto state = std::make_unique<torch::optim::AdamParamState>();
+      state->step(live_state.step());
+      state->exp_avg(cpu_copy(live_state.exp_avg()));
+      state->exp_avg_sq(cpu_copy(live_state.exp_avg_sq()));
+      state->max_exp_avg_sq(cpu_copy(live_state.max_exp_avg_sq()));
+      states.emplace_back(placeholders.back(), std::move(state));
+    }
+    groups.emplace_back(placeholders, group.options().clone());
+  }
+  auto snapshot = std::make_shared<torch::optim::Adam>(std::move(groups));
+  for (auto& [placeholder, state] : states)
+    snapshot->state()[utils::optimizer_state_key<Key>(placeholder)] = std::move(state);
+
+  return [snapshot](torch::serialize::OutputArchive& archive) { snapshot->save(archive); };
+}
+
+CheckpointManager::CheckpointManager(const string& run_path, const unsigned int& save_interval,
+                                     const unsigned int& max_to_keep)
+  : run_path_(run_path), save_interval_(save_interval), max_to_keep_(max_to_keep) {
+  // Periodic checkpoints of a resumed run count towards max_to_keep, oldest first
+  std::vector<std::pair<unsigned long, string>> existing;
+  const std::regex periodic_regex(R"(models_(\d+)\.pt)");
+  std::error_code error;
+  for (const auto& entry : std::filesystem::directory_iterator(run_path, error)) {
+    std::smatch match;
+    const string name = entry.path().filename().string();
+    if (std::regex_match(name, match, periodic_regex))
+      existing.emplace_back(std::stoul(match[1]), entry.path().string());
+  }
+  std::sort(existing.begin(), existing.end());
+  for (const auto& [iteration, path] : existing) this->periodic_paths_.push_back(path);
+
+  this->writer_ = std::thread(&CheckpointManager::writer_loop_, this);
+}
+
+CheckpointManager::~CheckpointManager() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->stopping_ = true;
+  }
+  this->condition_.notify_all();
+  this->writer_.join();
+}
+
+void CheckpointManager::save(ArchiveWriter&& writer, const string& name, const bool& periodic) {
+  this->push_(Job{name, std::move(writer), string(), periodic});
+}
+
+void CheckpointManager::save(string&& buffer, const string& name, const bool& periodic) {
+  this->push_(Job{name, nullptr, std::move(buffer), periodic});
+}
+
+void CheckpointManager::push_(Job&& job) {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  this->condition_.wait(lock, [this] { return this->jobs_.size() < kMaxPendingJobs; });
+  this->jobs_.push_back(std::move(job));
+  lock.unlock();
+  this->condition_.notify_all();
+}
+
+void CheckpointManager::wait() {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  this->condition_.wait(lock, [this] { return this->jobs_.empty() && !this->writing_; });
+}
+
+void CheckpointManager::writer_loop_() {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  while (true) {
+    this->condition_.wait(lock, [this] { return !this->jobs_.empty() || this->stopping_; });
+    // Pending checkpoints are still written when stopping
+    if (this->jobs_.empty()) return;
+    Job job = std::move(this->jobs_.front());
+    this->jobs_.pop_front();
+    this->writing_ = true;
+    lock.unlock();
+    this->condition_.notify_all();
+
+    try {
+      this->write_(job);
+    } catch (const std::exception& error) {
+      std::cerr << "Checkpoint " << job.name << " failed: " << error.what() << std::endl;
+    }
+
+    lock.lock();
+    this->writing_ = false;
+    this->condition_.notify_all();
+  }
+}
+
+void CheckpointManager::write_(Job& job) {
+  if (job.writer) {
+    torch::serialize::OutputArchive archive;
+    job.writer(archive);
+    archive.save_to([&job](const void* data, size_t size) -> size_t {
+      job.buffer.append(static_cast<const char*>(data), size);
+      return size;
+    });
+    // Releases the snapshot before the file is written
+    job.writer = nullptr;
+  }
+
+  const string path = this->run_path_ + job.name;
+  const string temporary_path = path + ".tmp";
+
+  const int fd = ::open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) throw std::runtime_error("Cannot open " + temporary_path);
+  size_t written = 0;
+  while (written < job.buffer.size()) {
+    const ssize_t result = ::write(fd, job.buffer.data() + written, job.buffer.size() - written);
+    if (result < 0) {
+      ::close(fd);
+      throw std::runtime_error("Cannot write " + temporary_path);
+    }
+    written += static_cast<size_t>(result);
+  }
+  const bool synced = ::fsync(fd) == 0;
+  if (::close(fd) != 0 || !synced) throw std::runtime_error("Cannot sync " + temporary_path);
+  if (std::rename(temporary_path.c_str(), path.c_str()) != 0)
+    throw std::runtime_error("Cannot rename " + temporary_path + " to " + path);
+
+  // The rename itself is durable once the directory entry is synced
+  const int directory_fd = ::open(this->run_path_.c_str(), O_RDONLY | O_DIRECTORY);
+  if (directory_fd >= 0) {
+    ::fsync(directory_fd);
+    ::close(directory_fd);
+  }
+
+  if (!job.periodic) return;
+  // A resumed run may overwrite one of the checkpoints found at construction
+  this->periodic_paths_.erase(
+    std::remove(this->periodic_paths_.begin(), this->periodic_paths_.end(), path),
+    this->periodic_paths_.end());
+  this->periodic_paths_.push_back(path);
+  while (this->max_to_keep_ > 0 && this->periodic_paths_.size() > this->max_to_keep_) {
+    std::remove(this->periodic_paths_.front().c_str());
+    this->periodic_paths_.pop_front();
+  }
+}
+
+}  // namespace storage
@@ -0,0 +1,169 @@
+#include "storage/mmap_checkpoint.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace storage {
+
+constexpr char kCheckpointMagic[8] = {'C', 'P', 'P', 'R', 'L', 'M', 'A', 'P'};
+constexpr uint32_t kCheckpointVersion = 1;
+
+template <typename T>
+void append(string& buffer, const T& value) {
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+string MmapCheckpoint::serialize(const NNModule& module) {
+  std::vector<std::pair<string, Tensor>> tensors;
+  for (const auto& parameter : module.named_parameters())
+    tensors.emplace_back(parameter.key(), parameter.value().detach().cpu().contiguous());
+  for (const auto& buffer : module.named_buffers())
+    tensors.emplace_back(buffer.key(), buffer.value().detach().cpu().contiguous());
+
+  // The index size is needed before the offsets can be assigned
+  size_t index_size = sizeof(kCheckpointMagic) + 2 * sizeof(uint32_t);
+  for (const auto& [name, tensor] : tensors)
+    index_size += 3 * sizeof(uint32_t) + name.size() + tensor.dim() * sizeof(int64_t) +
+                  sizeof(uint64_t);
+
+  const auto& align = [](const size_t& offset) {
+    return (offset + kCheckpointAlignment - 1) / kCheckpointAlignment * kCheckpointAlignment;
+  };
+  std::vector<size_t> offsets;
+  size_t offset = align(index_size);
+  for (const auto& [name, tensor] : tensors) {
+    offsets.push_back(offset);
+    offset = align(offset + tensor.nbytes());
+  }
+
+  string buffer;
+  buffer.reserve(offset);
+  buffer.append(kCheckpointMagic, sizeof(kCheckpointMagic));
+  append(buffer, kCheckpointVersion);
+  append(buffer, static_cast<uint32_t>(tensors.size()));
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const auto& [name, tensor] = tensors[i];
+    append(buffer, static_cast<uint32_t>(name.size()));
+    buffer.append(name);
+    append(buffer, static_cast<uint32_t>(tensor.scalar_type()));
+    append(buffer, static_cast<uint32_t>(tensor.dim()));
+    for (const int64_t& size : tensor.sizes()) append(buffer, size);
+    append(buffer, static_cast<uint64_t>(offsets[i]));
+  }
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    buffer.resize(offsets[i], '\0');
+    buffer.append(static_cast<const char*>(tensors[i].second.data_ptr()),
+                  tensors[i].second.nbytes());
+  }
+  buffer.resize(offset, '\0');
+  return buffer;
+}
+
+MmapCheckpoint::MmapCheckpoint(const string& path) : path_(path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("Cannot open " + path);
+  struct stat status;
+  if (::fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(kCheckpointMagic))) {
+    ::close(fd);
+    throw std::runtime_error(path + " is not a mapped checkpoint");
+  }
+  this->size_ = static_cast<size_t>(status.st_size);
+  // Private writable mapping: tensors may be written to without touching the file
+  void* data = ::mmap(nullptr, this->size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) throw std::runtime_error("Cannot map " + path);
+  const size_t size = this->size_;
+  this->mapping_ = std::shared_ptr<void>(data, [size](void* data) { ::munmap(data, size); });
+
+  const char* bytes = static_cast<const char*>(data);
+  size_t position = 0;
+  const auto& read = [&](void* value, const size_t& num_bytes) {
+    if (position + num_bytes > this->size_)
+      throw std::runtime_error("Truncated mapped checkpoint " + path);
+    std::memcpy(value, bytes + position, num_bytes);
+    position += num_bytes;
+  };
+
+  char magic[sizeof(kCheckpointMagic)];
+  read(magic, sizeof(magic));
+  if (std::memcmp(magic, kCheckpointMagic, sizeof(magic)) != 0)
+    throw std::runtime_error(path + " is not a mapped checkpoint");
+  uint32_t version, num_entries;
+  read(&version, sizeof(version));
+  if (version != kCheckpointVersion)
+    throw std::runtime_error("Unsupported mapped checkpoint version in " + path);
+  read(&num_entries, sizeof(num_entries));
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    // Every field is validated before it sizes an allocation or a view of the mapping
+    uint32_t name_size, dtype, dim;
+    read(&name_size, sizeof(name_size));
+    if (name_size > this->size_ - position)
+      throw std::runtime_error("Truncated mapped checkpoint " + path);
+    string name(name_size, '\0');
+    read(name.data(), name_size);
+    read(&dtype, sizeof(dtype));
+    if (dtype >= static_cast<uint32_t>(torch::ScalarType::NumOptions) ||
+        !(c10::isFloatingType(static_cast<torch::ScalarType>(dtype)) ||
+          c10::isIntegralType(static_cast<torch::ScalarType>(dtype), /*includeBool=*/true)))
+      throw std::runtime_error("Invalid type of " + name + " in " + path);
+    read(&dim, sizeof(dim));
+    if (dim > (this->size_ - position) / sizeof(int64_t))
+      throw std::runtime_error("Truncated mapped checkpoint " + path);
+    Entry entry{static_cast<torch::ScalarType>(dtype), std::vector<int64_t>(dim), 0};
+    read(entry.sizes.data(), dim * sizeof(int64_t));
+    uint64_t offset;
+    read(&offset, sizeof(offset));
+    if (offset % kCheckpointAlignment != 0)
+      throw std::runtime_error("Misaligned tensor " + name + " in " + path);
+
+    uint64_t num_bytes = c10::elementSize(entry.dtype);
+    for (const int64_t& size : entry.sizes)
+      if (size < 0 || __builtin_mul_overflow(num_bytes, static_cast<uint64_t>(size), &num_bytes))
+        throw std::runtime_error("Invalid shape of " + name + " in " + path);
+    if (offset > this->size_ || num_bytes > this->size_ - offset)
+      throw std::runtime_error("Truncated tensor " + name + " in " + path);
+    entry.offset = offset;
+    this->entries_.emplace(std::move(name), std::move(entry));
+  }
+}
+
+void MmapCheckpoint::load(NNModule& module, const std::vector<string>& prefixes) const {
+  torch::NoGradGuard no_grad;
+  const auto& selected = [&prefixes](const string& name) {
+    for (const string& prefix : prefixes)
+      if (name.rfind(prefix, 0) == 0) return true;
+    return false;
+  };
+  const auto& load_tensor = [this](const string& name, Tensor& target) {
+    const auto& entry = this->entries_.find(name);
+    if (entry == this->entries_.end())
+      throw std::runtime_error(name + " is missing from " + this->path_);
+    if (entry->second.dtype != target.scalar_type())
+      throw std::runtime_error("Mismatching type of " + name + " in " + this->path_);
+    const Tensor& source = this->tensor_(entry->second);
+    if (source.sizes() != target.sizes())
+      throw std::runtime_error("Mismatching shape of " + name + " in " + this->path_);
+    // set_data swaps the storage in place, every holder of the tensor sees the mapped data
+    target.set_data(target.is_cpu() ? source : source.to(target.device()));
+  };
+
+  for (auto& parameter : module.named_parameters())
+    if (selected(parameter.key())) load_tensor(parameter.key(), parameter.value());
+  for (auto& buffer : module.named_buffers())
+    if (selected(buffer.key())) load_tensor(buffer.key(), buffer.value());
+}
+
+const Tensor MmapCheckpoint::tensor_(const Entry& entry) const {
+  // Type, alignment and bounds were checked when the index was read
+  const torch::TensorOptions& options = torch::TensorOptions().dtype(entry.dtype);
+  // The deleter keeps the mapping alive for as long as the tensor
+  const std::shared_ptr<void> mapping = this->mapping_;
+  return torch::from_blob(static_cast<char*>(mapping.get()) + entry.offset, entry.sizes,
+                          [mapping](void*) {}, options);
+}
+
+}  // namespace storage
@@ -59,9 +59,21 @@ void RolloutStorage::compute_advantage(const Tensor& last_values, const float& g
     next_value.copy_(this->transitions_.values.select(0, step));
   }
   this->transitions_.advantages.copy_(this->returns_ - this->transitions_.values);
-  this->transitions_.advantages.copy_(
-    (this->transitions_.advantages - this->transitions_.advantages.mean()) /
-    (this->transitions_.advantages.std() + EPS));
+
+  const Tensor& advantages = this->transitions_.advantages;
+  Tensor mean, std;
+  if (this->all_reduce_) {
+    // Moments over the advantages of all processes: [count, sum, sum of squares]
+    Tensor moments = torch::stack({torch::full({}, advantages.numel(), advantages.options()),
+                                   advantages.sum(), advantages.square().sum()});
+    this->all_reduce_(moments);
+    mean = moments[1] / moments[0];
+    std = ((moments[2] - moments[0] * mean.square()) / (moments[0] - 1.f)).sqrt();
+  } else {
+    mean = advantages.mean();
+    std = advantages.std();
+  }
+  this->transitions_.advantages.copy_((advantages - mean) / (std + EPS));
 }
 
 void RolloutStorage::update_batches(std::vector<storage::Transition>& batches) {
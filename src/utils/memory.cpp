@@ -0,0 +1,76 @@
+#include "utils/memory.h"
+
+#include <fstream>
+#include <iomanip>
+
+namespace utils {
+
+constexpr float kMegabyte = 1024.f * 1024.f;
+
+int64_t module_bytes(const torch::nn::Module& module) {
+  int64_t bytes = 0;
+  for (const Tensor& parameter : module.parameters())
+    bytes += tensor_bytes(parameter) + tensor_bytes(parameter.grad());
+  for (const Tensor& buffer : module.buffers()) bytes += tensor_bytes(buffer);
+  return bytes;
+}
+
+int64_t optimizer_bytes(const torch::optim::Optimizer& optimizer) {
+  int64_t bytes = 0;
+  for (const auto& [key, state] : optimizer.state()) {
+    const auto* adam_state = dynamic_cast<const torch::optim::AdamParamState*>(state.get());
+    if (!adam_state) continue;
+    bytes += tensor_bytes(adam_state->exp_avg()) + tensor_bytes(adam_state->exp_avg_sq()) +
+             tensor_bytes(adam_state->max_exp_avg_sq());
+  }
+  return bytes;
+}
+
+int64_t peak_resident_bytes() {
+  std::ifstream status("/proc/self/status");
+  string line;
+  while (std::getline(status, line))
+    if (line.rfind("VmHWM:", 0) == 0) return std::stoll(line.substr(6)) * 1024;
+  return 0;
+}
+
+bool reset_peak_resident_bytes() {
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+  clear_refs.flush();
+  return static_cast<bool>(clear_refs);
+}
+
+int64_t MemoryReport::total() const {
+  int64_t bytes = 0;
+  for (const auto& [name, value] : this->entries_) bytes += value;
+  return bytes;
+}
+
+std::map<string, float> MemoryReport::to_megabytes() const {
+  std::map<string, float> values;
+  for (const auto& [name, bytes] : this->entries_) values[name + "_mb"] += bytes / kMegabyte;
+  values["total_mb"] = this->total() / kMegabyte;
+  return values;
+}
+
+std::ostream& operator<<(std::ostream& os, const MemoryReport& report) {
+  os << std::fixed << std::setprecision(2);
+  for (const auto& [name, bytes] : report.entries_)
+    os << std::setw(24) << std::left << name << std::setw(12) << std::right << bytes / kMegabyte
+       << " MB" << std::endl;
+  os << std::setw(24) << std::left << "total" << std::setw(12) << std::right
+     << report.total() / kMegabyte << " MB" << std::endl;
+  os << std::defaultfloat;
+  return os;
+}
+
+void AllocationCounter::reportMemoryUsage(void* ptr, int64_t alloc_size, size_t total_allocated,
+                                          size_t total_reserved, c10::Device device) {
+  // Frees are reported with a negative size
+  if (alloc_size <= 0) return;
+  this->allocations_.fetch_add(1, std::memory_order_relaxed);
+  this->bytes_.fetch_add(static_cast<uint64_t>(alloc_size), std::memory_order_relaxed);
+}
+
+}  // namespace utils
@@ -0,0 +1,255 @@
+#include "utils/perf_counters.h"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace utils {
+
+// Bytes moved by one memory controller CAS command
+constexpr uint64_t kCasBytes = 64;
+
+static int perf_event_open(perf_event_attr& attr, const pid_t& pid, const int& cpu,
+                           const int& group_fd) {
+  return static_cast<int>(::syscall(SYS_perf_event_open, &attr, pid, cpu, group_fd, 0));
+}
+
+static const char* phase_name(const PerfPhase& phase) {
+  switch (phase) {
+    case PerfPhase::kCollection:
+      return "collection";
+    case PerfPhase::kEnvStep:
+      return "env_step";
+    case PerfPhase::kLearning:
+      return "learning";
+    case PerfPhase::kNumPhases:
+      break;
+  }
+  return "unknown";
+}
+
+static int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+// "event=0x04,umask=0x03" of a sysfs event description into a raw config
+static uint64_t parse_event_config(const string& description) {
+  uint64_t config = 0;
+  std::stringstream stream(description);
+  string term;
+  while (std::getline(stream, term, ',')) {
+    const size_t separator = term.find('=');
+    if (separator == string::npos) continue;
+    const string& key = term.substr(0, separator);
+    const uint64_t value = std::stoull(term.substr(separator + 1), nullptr, 0);
+    if (key == "event") config |= value;
+    if (key == "umask") config |= value << 8;
+  }
+  return config;
+}
+
+// "0,18" or "0-3" of a sysfs cpumask into CPU indices, CPU 0 when the PMU does not list any
+static std::vector<int> parse_cpu_list(const string& list) {
+  std::vector<int> cpus;
+  std::stringstream stream(list);
+  string range;
+  while (std::getline(stream, range, ',')) {
+    if (range.empty()) continue;
+    const size_t separator = range.find('-');
+    const int first = std::stoi(range.substr(0, separator));
+    const int last = separator == string::npos ? first : std::stoi(range.substr(separator + 1));
+    for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+  }
+  if (cpus.empty()) cpus.push_back(0);
+  return cpus;
+}
+
+PerfCounters& PerfCounters::instance() {
+  static PerfCounters counters;
+  return counters;
+}
+
+PerfCounters::~PerfCounters() {
+  for (const int& fd : this->memory_fds_) ::close(fd);
+}
+
+PerfCounters::ThreadGroup::~ThreadGroup() {
+  for (const int& fd : this->fds)
+    if (fd >= 0) ::close(fd);
+}
+
+bool PerfCounters::enable() {
+  if (this->is_enabled()) return true;
+  // Opening on the calling thread tells whether counters are permitted at all
+  this->enabled_.store(true, std::memory_order_relaxed);
+  if (this->thread_group_().leader < 0) {
+    this->enabled_.store(false, std::memory_order_relaxed);
+    return false;
+  }
+  this->open_memory_counters_();
+  return true;
+}
+
+PerfCounters::ThreadGroup& PerfCounters::thread_group_() {
+  thread_local ThreadGroup group;
+  thread_local bool opened = false;
+  if (opened) return group;
+  opened = true;
+
+  const std::array<uint64_t, kNumEvents> configs{PERF_COUNT_HW_CPU_CYCLES,
+                                                 PERF_COUNT_HW_INSTRUCTIONS,
+                                                 PERF_COUNT_HW_CACHE_MISSES,
+                                                 PERF_COUNT_HW_BRANCH_MISSES};
+  for (size_t i = 0; i < kNumEvents; ++i) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[i];
+    // User space only, allowed by the default perf_event_paranoid level
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+      PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    const int fd = perf_event_open(attr, 0, -1, group.leader);
+    if (fd < 0) {
+      if (i == kCycles) {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        std::cerr << "Hardware counters unavailable (" << std::strerror(errno)
+                  << "), check /proc/sys/kernel/perf_event_paranoid" << std::endl;
+        return group;
+      }
+      continue;
+    }
+    if (i == kCycles) group.leader = fd;
+    group.fds[i] = fd;
+    group.slots[i] = group.num_slots++;
+  }
+  return group;
+}
+
+void PerfCounters::open_memory_counters_() {
+  const std::filesystem::path devices = "/sys/bus/event_source/devices";
+  std::error_code error_code;
+  for (const auto& entry : std::filesystem::directory_iterator(devices, error_code)) {
+    if (entry.path().filename().string().rfind("uncore_imc", 0) != 0) continue;
+    uint32_t type = 0;
+    std::ifstream(entry.path() / "type") >> type;
+    // Uncore counters are per socket, the PMU lists one CPU of each socket it covers
+    string cpumask;
+    std::ifstream(entry.path() / "cpumask") >> cpumask;
+    const std::vector<int>& cpus = parse_cpu_list(cpumask);
+    for (const char* event : {"cas_count_read", "cas_count_write"}) {
+      string description;
+      std::ifstream(entry.path() / "events" / event) >> description;
+      if (description.empty()) continue;
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = parse_event_config(description);
+      // Counted for every process, once per socket
+      for (const int& cpu : cpus) {
+        const int fd = perf_event_open(attr, -1, cpu, -1);
+        if (fd >= 0) this->memory_fds_.push_back(fd);
+      }
+    }
+  }
+  if (this->memory_fds_.empty())
+    std::cerr << "Memory bandwidth counters unavailable, reporting core counters only"
+              << std::endl;
+}
+
+bool PerfCounters::read_(Reading& reading) {
+  const ThreadGroup& group = this->thread_group_();
+  if (group.leader < 0) return false;
+
+  // nr, time_enabled, time_running, values[nr]
+  uint64_t buffer[3 + kNumEvents];
+  if (::read(group.leader, buffer, sizeof(buffer)) < static_cast<ssize_t>(3 * sizeof(uint64_t)))
+    return false;
+  // Scaled up when the kernel had to multiplex the group
+  const double scale =
+    buffer[2] > 0 ? static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]) : 1.;
+  for (size_t i = 0; i < kNumEvents; ++i)
+    reading.values[i] = group.slots[i] >= 0 ? buffer[3 + group.slots[i]] * scale : 0.;
+
+  reading.memory_bytes = 0;
+  for (const int& fd : this->memory_fds_) {
+    uint64_t count = 0;
+    if (::read(fd, &count, sizeof(count)) == sizeof(count))
+      reading.memory_bytes += count * kCasBytes;
+  }
+  return true;
+}
+
+void PerfCounters::add_(const PerfPhase& phase, const Reading& start, const Reading& end,
+                        const int64_t& time_ns) {
+  Accumulator& accumulator = this->accumulators_[static_cast<size_t>(phase)];
+  for (size_t i = 0; i < kNumEvents; ++i)
+    accumulator.values[i].fetch_add(
+      static_cast<uint64_t>(std::max(0., end.values[i] - start.values[i])),
+      std::memory_order_relaxed);
+  accumulator.memory_bytes.fetch_add(end.memory_bytes - start.memory_bytes,
+                                     std::memory_order_relaxed);
+  accumulator.time_ns.fetch_add(time_ns, std::memory_order_relaxed);
+  accumulator.count.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::map<string, float> PerfCounters::pop_metrics() {
+  std::map<string, float> metrics;
+  if (!this->is_enabled()) return metrics;
+  const uint64_t num_env_steps =
+    this->accumulators_[static_cast<size_t>(PerfPhase::kEnvStep)].count.exchange(0);
+  for (size_t phase = 0; phase < this->accumulators_.size(); ++phase) {
+    Accumulator& accumulator = this->accumulators_[phase];
+    std::array<uint64_t, kNumEvents> values;
+    for (size_t i = 0; i < kNumEvents; ++i) values[i] = accumulator.values[i].exchange(0);
+    const uint64_t memory_bytes = accumulator.memory_bytes.exchange(0);
+    const uint64_t time_ns = accumulator.time_ns.exchange(0);
+    const uint64_t count = accumulator.count.exchange(0);
+    if (time_ns == 0) continue;
+
+    const string& name = phase_name(static_cast<PerfPhase>(phase));
+    if (values[kCycles] > 0)
+      metrics[name + "_ipc"] = static_cast<float>(values[kInstructions]) / values[kCycles];
+    // Misses of the rollout phases per Env::step call, those of the learner per update
+    const bool learning = static_cast<PerfPhase>(phase) == PerfPhase::kLearning;
+    const uint64_t num_units = learning ? count : num_env_steps;
+    const string& unit = learning ? "_per_iteration" : "_per_step";
+    if (num_units > 0) {
+      metrics[name + "_cache_misses" + unit] = static_cast<float>(values[kCacheMisses]) / num_units;
+      metrics[name + "_branch_misses" + unit] =
+        static_cast<float>(values[kBranchMisses]) / num_units;
+    }
+    if (!this->memory_fds_.empty())
+      metrics[name + "_memory_gbs"] = static_cast<float>(memory_bytes) / time_ns;
+  }
+  return metrics;
+}
+
+PerfScope::PerfScope(const PerfPhase& phase) : phase_(phase) {
+  PerfCounters& counters = PerfCounters::instance();
+  if (!counters.is_enabled()) return;
+  this->active_ = counters.read_(this->start_);
+  this->start_ns_ = now_ns();
+}
+
+PerfScope::~PerfScope() {
+  if (!this->active_) return;
+  const int64_t end_ns = now_ns();
+  PerfCounters::Reading end;
+  PerfCounters& counters = PerfCounters::instance();
+  if (counters.read_(end)) counters.add_(this->phase_, this->start_, end, end_ns - this->start_ns_);
+}
+
+}  // namespace utils
@@ -0,0 +1,162 @@
+#include "utils/trace.h"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <iostream>
+
+namespace utils {
+
+// Events reserved per thread when a capture starts, avoids reallocation inside hot loops
+constexpr size_t kReservedEvents = 1 << 16;
+
+static const char* span_name(const Span& span) {
+  switch (span) {
+    case Span::kAct:
+      return "act";
+    case Span::kEnvStep:
+      return "env_step";
+    case Span::kMemorize:
+      return "memorize";
+    case Span::kReset:
+      return "reset";
+    case Span::kProcessStep:
+      return "process_step";
+    case Span::kComputeAdvantage:
+      return "compute_advantage";
+    case Span::kMinibatchGather:
+      return "minibatch_gather";
+    case Span::kForward:
+      return "forward";
+    case Span::kBackward:
+      return "backward";
+    case Span::kOptimizerStep:
+      return "optimizer_step";
+    case Span::kLogging:
+      return "logging";
+    case Span::kNumSpans:
+      break;
+  }
+  return "unknown";
+}
+
+Tracer& Tracer::instance() {
+  static Tracer tracer;
+  return tracer;
+}
+
+Tracer::ThreadBuffer& Tracer::thread_buffer_() {
+  thread_local std::shared_ptr<ThreadBuffer> buffer;
+  if (!buffer) {
+    buffer = std::make_shared<ThreadBuffer>();
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    buffer->thread_id = this->buffers_.size();
+    this->buffers_.push_back(buffer);
+  }
+  return *buffer;
+}
+
+void Tracer::record(const Span& span, const int64_t& start_ns, const int64_t& end_ns) {
+  this->histograms_[static_cast<size_t>(span)].record(end_ns - start_ns);
+  if (!this->is_capturing()) return;
+  // Only contended while a capture is being exported
+  ThreadBuffer& buffer = this->thread_buffer_();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.events.push_back({span, start_ns, end_ns - start_ns});
+}
+
+void Tracer::start_capture() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    for (const auto& buffer : this->buffers_) {
+      std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+      buffer->events.clear();
+      buffer->events.reserve(kReservedEvents);
+    }
+    this->capture_start_ns_ = trace_clock_ns();
+  }
+  this->capturing_.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::stop_capture(const string& path) {
+  this->capturing_.store(false, std::memory_order_relaxed);
+  std::ofstream file(path);
+  if (!file) throw std::runtime_error("Cannot write trace " + path);
+  const pid_t pid = ::getpid();
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  for (const auto& buffer : this->buffers_) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    for (const Event& event : buffer->events) {
+      // Chrome trace timestamps are in microseconds
+      file << (first ? "" : ",") << "\n{\"name\":\"" << span_name(event.span)
+           << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << buffer->thread_id
+           << ",\"ts\":" << (event.start_ns - this->capture_start_ns_) / 1e3
+           << ",\"dur\":" << event.duration_ns / 1e3 << "}";
+      first = false;
+    }
+    buffer->events.clear();
+  }
+  file << "\n]}\n";
+}
+
+std::map<string, float> Tracer::pop_timings() {
+  std::map<string, float> timings;
+  for (size_t i = 0; i < this->histograms_.size(); ++i) {
+    LatencyHistogram& histogram = this->histograms_[i];
+    if (histogram.count() == 0) continue;
+    const string& name = span_name(static_cast<Span>(i));
+    timings[name + "_p50"] = histogram.percentile(0.5) / 1e6;
+    timings[name + "_p99"] = histogram.percentile(0.99) / 1e6;
+    histogram.reset();
+  }
+  return timings;
+}
+
+TraceSession::TraceSession(const string& run_path,
+                           const std::vector<std::pair<unsigned int, unsigned int>>& windows,
+                           const bool& autograd)
+  : run_path_(run_path), windows_(windows), autograd_(autograd), active_(windows.size()) {}
+
+TraceSession::~TraceSession() {
+  // A window running past the last iteration is written with what it captured
+  if (this->active_ >= this->windows_.size()) return;
+  try {
+    this->stop_();
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << std::endl;
+  }
+}
+
+void TraceSession::begin_iteration(const unsigned int& iteration) {
+  if (this->active_ < this->windows_.size()) return;
+  for (size_t i = 0; i < this->windows_.size(); ++i) {
+    if (this->windows_[i].first != iteration || this->windows_[i].second == 0) continue;
+    this->active_ = i;
+    const string& path = this->run_path_ + "/trace_" + std::to_string(iteration);
+    if (this->autograd_)
+      this->profile_ =
+        std::make_unique<torch::autograd::profiler::RecordProfile>(path + "_autograd.json");
+    Tracer::instance().start_capture();
+    return;
+  }
+}
+
+void TraceSession::end_iteration(const unsigned int& iteration) {
+  if (this->active_ >= this->windows_.size()) return;
+  const auto& [start, length] = this->windows_[this->active_];
+  if (iteration + 1 >= start + length) this->stop_();
+}
+
+void TraceSession::stop_() {
+  const unsigned int start = this->windows_[this->active_].first;
+  const string& path = this->run_path_ + "/trace_" + std::to_string(start) + ".json";
+  Tracer::instance().stop_capture(path);
+  // The autograd profile is written when the guard is destroyed
+  this->profile_.reset();
+  this->active_ = this->windows_.size();
+  std::cout << "Trace written to " << path << std::endl;
+}
+
+}  // namespace utils
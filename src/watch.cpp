@@ -0,0 +1,78 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "runners/live_metrics.h"
+
+void print(const runners::LiveCounters& counters) {
+  const double age =
+    (std::chrono::duration_cast<std::chrono::nanoseconds>(
+       std::chrono::system_clock::now().time_since_epoch())
+       .count() -
+     static_cast<int64_t>(counters.update_time_ns)) /
+    1e9;
+  std::cout << std::fixed << std::setprecision(2) << "pid " << counters.pid << " | it "
+            << counters.iteration << "/" << counters.end_iteration << " | "
+            << runners::phase_name(counters.phase) << " | fps " << std::setprecision(0)
+            << counters.fps << " | collect " << std::setprecision(3) << counters.collection_time
+            << " s | learn " << counters.learn_time << " s | reward " << counters.mean_reward
+            << " | length " << std::setprecision(1) << counters.mean_length << " | episodes "
+            << counters.num_episodes << " | lr " << std::scientific << std::setprecision(2)
+            << counters.learning_rate << " | kl " << counters.kl << std::fixed << " | rss "
+            << counters.rss_bytes / (1 << 20) << " MiB | updated " << age << " s ago";
+}
+
+// Segment of the run with the given pid, or of the only live run of the task when pid is 0
+std::string segment_name(const std::string& task, const int64_t& pid) {
+  if (pid != 0) return runners::live_metrics_name(task, pid);
+  const std::vector<int64_t>& pids = runners::live_metrics_pids(task);
+  if (pids.empty())
+    throw std::runtime_error("No live metrics for " + task + ", is the job running?");
+  if (pids.size() > 1) {
+    std::string message = "Several runs of " + task + ", pass one of the pids:";
+    for (const int64_t& live_pid : pids) message += " " + std::to_string(live_pid);
+    throw std::runtime_error(message);
+  }
+  return runners::live_metrics_name(task, pids.front());
+}
+
+// Usage: cpp_rl_watch <task> [interval_ms] [pid]
+// Polls the live counters of a running `cpp_rl train <task>`, interval 0 prints once and exits.
+// The pid selects one of several concurrent runs of the same task.
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <task> [interval_ms] [pid]" << std::endl;
+    return 1;
+  }
+  const unsigned int interval_ms = argc > 2 ? std::stoul(argv[2]) : 500;
+  const int64_t pid = argc > 3 ? std::stoll(argv[3]) : 0;
+  try {
+    const runners::LiveMetricsReader reader(segment_name(argv[1], pid));
+    while (true) {
+      const std::optional<runners::LiveCounters>& counters = reader.read();
+      if (!counters) {
+        std::cerr << std::endl << "Live metrics are stale, the writer stopped inside an update"
+                  << std::endl;
+        return 1;
+      }
+      if (interval_ms == 0) {
+        print(*counters);
+        break;
+      }
+      std::cout << "\r\033[K";
+      print(*counters);
+      std::cout << std::flush;
+      if (counters->phase == runners::Phase::kFinished) break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    }
+    std::cout << std::endl;
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+}
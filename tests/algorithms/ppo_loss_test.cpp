@@ -0,0 +1,146 @@
+#include "algorithms/ppo_loss.h"
+
+#include <gtest/gtest.h>
+#include <torch/torch.h>
+
+#include <sstream>
+#include <string>
+#include <tuple>
+
+// use_clipped_value_loss, scale of the policy and value change, device ("cpu" or "gpu"),
+// double precision (the CPU kernel only handles float, double takes the generic path)
+using PPOLossTestParams = std::tuple<bool, float, std::string, bool>;
+
+static configs::PPOCfg make_ppo_cfg(const bool& use_clipped_value_loss) {
+  return configs::PPOCfg{0.5f,  0.2f,  use_clipped_value_loss, 0.01f, 0.f, 0.01f, 0.99f,
+                         0.95f, 1.f,   1e-3f, 1e-6f, 1e-2f, 2, 8, "adaptive", false};
+}
+
+// Reference loss and metrics built from differentiable torch ops. Inside the trust region both
+// sides of the maximum are equal and their gradients add up to the unclipped one.
+static torch::autograd::variable_list reference_loss(
+  const torch::Tensor& log_probs, const torch::Tensor& values, const torch::Tensor& entropy,
+  const torch::Tensor& old_log_probs, const torch::Tensor& old_values,
+  const torch::Tensor& advantages, const torch::Tensor& returns, const configs::PPOCfg& cfg) {
+  const torch::Tensor& ratio = torch::exp(log_probs - old_log_probs);
+  const torch::Tensor& surrogate = -advantages * ratio;
+  const torch::Tensor& surrogate_clipped =
+    -advantages * ratio.clamp(1.f - cfg.clip_param, 1.f + cfg.clip_param);
+  const torch::Tensor& surrogate_mean = torch::maximum(surrogate, surrogate_clipped).mean();
+
+  const torch::Tensor& value_loss = (values - returns).square();
+  torch::Tensor value_mean;
+  if (cfg.use_clipped_value_loss) {
+    const torch::Tensor& value_clipped =
+      old_values + (values - old_values).clamp(-cfg.clip_param, cfg.clip_param);
+    value_mean = torch::maximum(value_loss, (value_clipped - returns).square()).mean();
+  } else {
+    value_mean = value_loss.mean();
+  }
+
+  const torch::Tensor& entropy_mean = entropy.mean();
+  const torch::Tensor& loss =
+    surrogate_mean + cfg.value_loss_coef * value_mean - cfg.entropy_coef * entropy_mean;
+  return {loss, torch::stack({surrogate_mean, value_mean, entropy_mean}).detach()};
+}
+
+// Parameterized fixture: a random minibatch with fresh values perturbed from the old ones.
+class PPOLossParameterizedTest : public ::testing::TestWithParam<PPOLossTestParams> {
+ protected:
+  void SetUp() override {
+    const auto& [use_clipped_value_loss, scale, device_str, double_precision] = GetParam();
+    if (device_str == "gpu") {
+      if (!torch::cuda::is_available()) GTEST_SKIP() << "CUDA not available, skipping GPU test.";
+      this->device_ = torch::Device(torch::kCUDA);
+    }
+    const torch::TensorOptions options =
+      torch::TensorOptions().device(this->device_).dtype(double_precision ? torch::kDouble
+                                                                          : torch::kFloat);
+
+    torch::manual_seed(0);
+    this->old_log_probs_ = torch::randn({num_samples_, 1}, options) - 1.f;
+    this->old_values_ = torch::randn({num_samples_, 1}, options);
+    this->advantages_ = torch::randn({num_samples_, 1}, options);
+    this->returns_ = this->old_values_ + torch::randn({num_samples_, 1}, options);
+    this->log_probs_ = this->old_log_probs_ + scale * torch::randn({num_samples_, 1}, options);
+    this->values_ = this->old_values_ + scale * torch::randn({num_samples_, 1}, options);
+    this->entropy_ = torch::rand({num_samples_, 1}, options);
+  }
+
+  const int num_samples_ = 256;
+  torch::Device device_ = torch::Device(torch::kCPU);
+  torch::Tensor log_probs_;
+  torch::Tensor values_;
+  torch::Tensor entropy_;
+  torch::Tensor old_log_probs_;
+  torch::Tensor old_values_;
+  torch::Tensor advantages_;
+  torch::Tensor returns_;
+};
+
+TEST_P(PPOLossParameterizedTest, MatchesReferenceLossAndGradients) {
+  const auto& [use_clipped_value_loss, scale, device_str, double_precision] = GetParam();
+  const configs::PPOCfg cfg = make_ppo_cfg(use_clipped_value_loss);
+
+  // Leaves for the fused loss and for the reference one
+  const torch::Tensor log_probs = this->log_probs_.clone().requires_grad_(true);
+  const torch::Tensor values = this->values_.clone().requires_grad_(true);
+  const torch::Tensor entropy = this->entropy_.clone().requires_grad_(true);
+  const torch::Tensor reference_log_probs = this->log_probs_.clone().requires_grad_(true);
+  const torch::Tensor reference_values = this->values_.clone().requires_grad_(true);
+  const torch::Tensor reference_entropy = this->entropy_.clone().requires_grad_(true);
+
+  const torch::autograd::variable_list& outputs =
+    algorithms::PPOLoss::apply(log_probs, values, entropy, this->old_log_probs_, this->old_values_,
+                               this->advantages_, this->returns_, cfg);
+  const torch::autograd::variable_list& reference_outputs =
+    reference_loss(reference_log_probs, reference_values, reference_entropy, this->old_log_probs_,
+                   this->old_values_, this->advantages_, this->returns_, cfg);
+  outputs[0].backward();
+  reference_outputs[0].backward();
+
+  const double tolerance = double_precision ? 1e-8 : 1e-5;
+  EXPECT_TRUE(torch::allclose(outputs[0], reference_outputs[0], tolerance, tolerance))
+    << "Loss mismatch: " << outputs[0].item<double>() << " vs "
+    << reference_outputs[0].item<double>();
+  EXPECT_TRUE(torch::allclose(outputs[1], reference_outputs[1], tolerance, tolerance))
+    << "Metrics mismatch";
+  EXPECT_TRUE(torch::allclose(log_probs.grad(), reference_log_probs.grad(), tolerance, tolerance))
+    << "Log-prob gradient mismatch";
+  EXPECT_TRUE(torch::allclose(values.grad(), reference_values.grad(), tolerance, tolerance))
+    << "Value gradient mismatch";
+  EXPECT_TRUE(torch::allclose(entropy.grad(), reference_entropy.grad(), tolerance, tolerance))
+    << "Entropy gradient mismatch";
+}
+
+TEST_P(PPOLossParameterizedTest, CoversClippedAndUnclippedSamples) {
+  const auto& [use_clipped_value_loss, scale, device_str, double_precision] = GetParam();
+  const configs::PPOCfg cfg = make_ppo_cfg(use_clipped_value_loss);
+  const torch::Tensor& ratio = torch::exp(this->log_probs_ - this->old_log_probs_);
+  const torch::Tensor& clipped_ratio = (ratio - 1.f).abs() > cfg.clip_param;
+
+  // Small changes stay in the trust region, large ones leave it for a good share of the samples
+  EXPECT_GT(clipped_ratio.logical_not().sum().item<int64_t>(), 0) << "No unclipped sample";
+  if (scale > cfg.clip_param)
+    EXPECT_GT(clipped_ratio.sum().item<int64_t>(), 0) << "No clipped sample";
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  PPOLossTests, PPOLossParameterizedTest,
+  ::testing::Combine(
+    // use_clipped_value_loss: false or true
+    ::testing::Values(false, true),
+    // scale: inside the trust region or mostly outside of it
+    ::testing::Values(0.05f, 1.f),
+    // device: "cpu" or "gpu"
+    ::testing::Values(std::string("cpu"), std::string("gpu")),
+    // precision: float (fused CPU kernel) or double (generic path)
+    ::testing::Values(false, true)),
+  [](const ::testing::TestParamInfo<PPOLossTestParams>& info) {
+    const auto& [use_clipped_value_loss, scale, device_str, double_precision] = info.param;
+    std::stringstream ss;
+    ss << (use_clipped_value_loss ? "ClippedValue" : "PlainValue") << "_"
+       << (scale > 0.2f ? "Large" : "Small") << "_" << device_str << "_"
+       << (double_precision ? "Double" : "Float");
+    return ss.str();
+  });
@@ -0,0 +1,131 @@
+#include "algorithms/impala.h"
+
+#include <gtest/gtest.h>
+#include <torch/torch.h>
+
+// Reference V-trace from the definition, no recursion:
+// vs_t = V_t + sum_{s>=t} (prod_{i<s} discount_i c_i) delta_s,
+// delta_s = rho_s (r_s + discount_s V_{s+1} - V_s)
+static torch::Tensor reference_vtrace(const torch::Tensor& log_rhos, const torch::Tensor& rewards,
+                                      const torch::Tensor& dones, const torch::Tensor& values,
+                                      const torch::Tensor& bootstrap_values, const float& gamma,
+                                      const float& lam, const float& rho_clip,
+                                      const float& c_clip) {
+  const int64_t num_steps = values.size(0);
+  const torch::Tensor& rhos = log_rhos.exp().clamp_max(rho_clip);
+  const torch::Tensor& cs = lam * log_rhos.exp().clamp_max(c_clip);
+  const torch::Tensor& discounts = gamma * (1.f - dones);
+  torch::Tensor vs = values.clone();
+  for (int64_t t = 0; t < num_steps; ++t) {
+    torch::Tensor trace = torch::ones_like(bootstrap_values);
+    for (int64_t s = t; s < num_steps; ++s) {
+      const torch::Tensor& next_values = s + 1 < num_steps ? values[s + 1] : bootstrap_values;
+      vs[t] += trace * rhos[s] * (rewards[s] + discounts[s] * next_values - values[s]);
+      trace = trace * discounts[s] * cs[s];
+    }
+  }
+  return vs;
+}
+
+// Fixture: random time-major trajectories of a few envs.
+class VTraceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    torch::manual_seed(0);
+    this->rewards_ = torch::randn({num_steps_, num_envs_, 1});
+    this->values_ = torch::randn({num_steps_, num_envs_, 1});
+    this->bootstrap_values_ = torch::randn({num_envs_, 1});
+    this->dones_ = torch::zeros({num_steps_, num_envs_, 1});
+  }
+
+  void compute_(const torch::Tensor& log_rhos, const float& lam, const float& rho_clip,
+                const float& c_clip) {
+    algorithms::compute_vtrace(log_rhos, this->rewards_, this->dones_, this->values_,
+                               this->bootstrap_values_, gamma_, lam, rho_clip, c_clip, this->vs_,
+                               this->advantages_);
+  }
+
+  const int64_t num_steps_ = 6;
+  const int64_t num_envs_ = 3;
+  const float gamma_ = 0.9f;
+  torch::Tensor rewards_;
+  torch::Tensor values_;
+  torch::Tensor bootstrap_values_;
+  torch::Tensor dones_;
+  torch::Tensor vs_;
+  torch::Tensor advantages_;
+};
+
+TEST_F(VTraceTest, OnPolicyIsDiscountedReturn) {
+  this->compute_(torch::zeros_like(this->values_), 1.f, 1.f, 1.f);
+
+  // n-step return bootstrapped with the value after the last step
+  torch::Tensor expected = this->bootstrap_values_.clone();
+  for (int64_t step = num_steps_ - 1; step >= 0; --step) {
+    expected = this->rewards_[step] + gamma_ * expected;
+    EXPECT_TRUE(torch::allclose(this->vs_[step], expected, 1e-5, 1e-5))
+      << "vs mismatch at step " << step;
+
+    const torch::Tensor& next_vs =
+      step + 1 < num_steps_ ? this->vs_[step + 1] : this->bootstrap_values_;
+    EXPECT_TRUE(torch::allclose(this->advantages_[step],
+                                this->rewards_[step] + gamma_ * next_vs - this->values_[step],
+                                1e-5, 1e-5))
+      << "Advantage mismatch at step " << step;
+  }
+}
+
+TEST_F(VTraceTest, DonesCutTheTrace) {
+  // Env 0 ends an episode at step 2, env 1 at the last step, env 2 never
+  this->dones_[2][0] = 1.f;
+  this->dones_[num_steps_ - 1][1] = 1.f;
+  this->compute_(torch::zeros_like(this->values_), 1.f, 1.f, 1.f);
+
+  const torch::Tensor& expected =
+    reference_vtrace(torch::zeros_like(this->values_), this->rewards_, this->dones_,
+                     this->values_, this->bootstrap_values_, gamma_, 1.f, 1.f, 1.f);
+  EXPECT_TRUE(torch::allclose(this->vs_, expected, 1e-5, 1e-5));
+
+  // Up to the done, the target is the episode's discounted return without bootstrap
+  torch::Tensor episode_return = torch::zeros({1});
+  for (int64_t step = 2; step >= 0; --step) {
+    episode_return = this->rewards_[step][0] + gamma_ * episode_return;
+    EXPECT_TRUE(torch::allclose(this->vs_[step][0], episode_return, 1e-5, 1e-5))
+      << "Env 0 leaks past its done at step " << step;
+  }
+  EXPECT_TRUE(torch::allclose(this->vs_[num_steps_ - 1][1], this->rewards_[num_steps_ - 1][1],
+                              1e-5, 1e-5))
+    << "Env 1 bootstraps past its done";
+}
+
+TEST_F(VTraceTest, TruncatesRhoAndC) {
+  // Importance ratios on both sides of the clipping thresholds
+  const torch::Tensor& log_rhos = torch::randn({num_steps_, num_envs_, 1});
+  this->dones_[3][1] = 1.f;
+  const float lam = 0.95f;
+  const float rho_clip = 1.2f;
+  const float c_clip = 0.8f;
+  this->compute_(log_rhos, lam, rho_clip, c_clip);
+
+  const torch::Tensor& expected =
+    reference_vtrace(log_rhos, this->rewards_, this->dones_, this->values_,
+                     this->bootstrap_values_, gamma_, lam, rho_clip, c_clip);
+  EXPECT_TRUE(torch::allclose(this->vs_, expected, 1e-5, 1e-5));
+
+  // Without truncation the targets differ
+  const torch::Tensor& unclipped =
+    reference_vtrace(log_rhos, this->rewards_, this->dones_, this->values_,
+                     this->bootstrap_values_, gamma_, lam, 1e6f, 1e6f);
+  EXPECT_FALSE(torch::allclose(this->vs_, unclipped, 1e-3, 1e-3));
+}
+
+TEST_F(VTraceTest, LargeRatiosClipToOnPolicy) {
+  // Every ratio above both thresholds of 1 behaves as on-policy
+  this->compute_(torch::full_like(this->values_, 2.f), 1.f, 1.f, 1.f);
+  const torch::Tensor vs = this->vs_.clone();
+  const torch::Tensor advantages = this->advantages_.clone();
+  this->compute_(torch::zeros_like(this->values_), 1.f, 1.f, 1.f);
+
+  EXPECT_TRUE(torch::allclose(vs, this->vs_, 1e-5, 1e-5));
+  EXPECT_TRUE(torch::allclose(advantages, this->advantages_, 1e-5, 1e-5));
+}
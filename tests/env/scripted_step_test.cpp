@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <torch/torch.h>
+
+#include <sstream>
+#include <string>
+#include <tuple>
+
+#include "configs/configs.h"
+#include "env/task_manager.h"
+
+// task, integrator
+using ScriptedStepTestParams = std::tuple<std::string, std::string>;
+
+// Parameterized fixture: an eager and a scripted env of the same task, reset to the same states.
+class ScriptedStepParameterizedTest : public ::testing::TestWithParam<ScriptedStepTestParams> {
+ protected:
+  void SetUp() override {
+    const auto& [task, integrator] = GetParam();
+    // Short episodes, so that truncation and the resets that follow are part of the rollout
+    const configs::EnvCfg cfg{0, task, num_envs_, 0, max_iterations_, integrator, 0.02f};
+    this->eager_ = env::TaskManager::create(task, cfg, torch::kCPU);
+    this->scripted_ = env::TaskManager::create(task, cfg, torch::kCPU);
+    this->eager_->initialize();
+    this->scripted_->initialize();
+    this->scripted_->enable_scripted_step();
+
+    this->eager_results_ = this->make_results_();
+    this->scripted_results_ = this->make_results_();
+    this->reset_({});
+  }
+
+  env::Results make_results_() const {
+    env::Results results;
+    results.actor_obs = torch::zeros({num_envs_, this->eager_->get_actor_obs_size()});
+    results.critic_obs = torch::zeros({num_envs_, this->eager_->get_critic_obs_size()});
+    results.rewards = torch::zeros({num_envs_});
+    results.terminated = torch::zeros({num_envs_}, torch::kBool);
+    results.truncated = torch::zeros({num_envs_}, torch::kBool);
+    return results;
+  }
+
+  // The reset states are sampled from the global generator, reseeded so that both envs match
+  void reset_(const torch::Tensor& indices) {
+    torch::manual_seed(num_resets_);
+    this->eager_->reset(this->eager_results_, indices);
+    torch::manual_seed(num_resets_);
+    this->scripted_->reset(this->scripted_results_, indices);
+    num_resets_ += 1;
+  }
+
+  const unsigned int num_envs_ = 16;
+  const int max_iterations_ = 10;
+  const unsigned int num_steps_ = 25;
+  int num_resets_ = 0;
+  env::EnvPointer eager_;
+  env::EnvPointer scripted_;
+  env::Results eager_results_;
+  env::Results scripted_results_;
+};
+
+TEST_P(ScriptedStepParameterizedTest, MatchesEagerStep) {
+  torch::manual_seed(42);
+  for (unsigned int step = 0; step < num_steps_; ++step) {
+    const torch::Tensor& actions = 2.f * torch::randn({num_envs_, this->eager_->get_action_size()});
+    this->eager_->step(this->eager_results_, actions);
+    this->scripted_->step(this->scripted_results_, actions);
+
+    EXPECT_TRUE(torch::allclose(this->scripted_results_.actor_obs, this->eager_results_.actor_obs,
+                                1e-4, 1e-5))
+      << "Actor obs mismatch at step " << step;
+    EXPECT_TRUE(torch::allclose(this->scripted_results_.critic_obs,
+                                this->eager_results_.critic_obs, 1e-4, 1e-5))
+      << "Critic obs mismatch at step " << step;
+    EXPECT_TRUE(
+      torch::allclose(this->scripted_results_.rewards, this->eager_results_.rewards, 1e-4, 1e-5))
+      << "Reward mismatch at step " << step;
+    EXPECT_TRUE(torch::equal(this->scripted_results_.terminated, this->eager_results_.terminated))
+      << "Terminated mismatch at step " << step;
+    EXPECT_TRUE(torch::equal(this->scripted_results_.truncated, this->eager_results_.truncated))
+      << "Truncated mismatch at step " << step;
+
+    const torch::Tensor& dones = this->eager_results_.terminated | this->eager_results_.truncated;
+    if (dones.any().item<bool>()) this->reset_(dones);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  ScriptedStepTests, ScriptedStepParameterizedTest,
+  ::testing::Combine(
+    // task: every task with a model script
+    ::testing::Values(std::string("pendulum"), std::string("pendulum_cart")),
+    // integrator
+    ::testing::Values(std::string("euler"), std::string("rk2"), std::string("rk4"))),
+  [](const ::testing::TestParamInfo<ScriptedStepTestParams>& info) {
+    const auto& [task, integrator] = info.param;
+    std::stringstream ss;
+    ss << task << "_" << integrator;
+    return ss.str();
+  });
@@ -0,0 +1,86 @@
+#include "modules/distributions/beta.h"
+
+#include <gtest/gtest.h>
+#include <torch/torch.h>
+
+// Two-sample Kolmogorov-Smirnov statistic between two 1D samples.
+static float ks_statistic(const torch::Tensor& first, const torch::Tensor& second) {
+  const torch::Tensor& support = std::get<0>(torch::cat({first, second}).sort());
+  const torch::Tensor& first_cdf =
+    torch::searchsorted(std::get<0>(first.sort()), support, false, /*right=*/true)
+      .to(torch::kFloat) /
+    first.numel();
+  const torch::Tensor& second_cdf =
+    torch::searchsorted(std::get<0>(second.sort()), support, false, /*right=*/true)
+      .to(torch::kFloat) /
+    second.numel();
+  return (first_cdf - second_cdf).abs().max().item<float>();
+}
+
+// Parameterized fixture: a batch of identical Beta(alpha, beta) parameters.
+class BetaSamplerParameterizedTest : public ::testing::TestWithParam<std::tuple<float, float>> {
+ protected:
+  void SetUp() override {
+    const auto& [alpha, beta] = GetParam();
+    torch::manual_seed(0);
+    this->alpha_ = torch::full({num_samples_}, alpha);
+    this->beta_ = torch::full({num_samples_}, beta);
+  }
+
+  const int num_samples_ = 100000;
+  torch::Tensor alpha_;
+  torch::Tensor beta_;
+};
+
+TEST_P(BetaSamplerParameterizedTest, MatchesAnalyticMoments) {
+  const auto& [alpha, beta] = GetParam();
+  torch::Tensor samples = torch::empty_like(this->alpha_);
+  modules::sample_beta(this->alpha_, this->beta_, samples);
+
+  const float mean = alpha / (alpha + beta);
+  const float var = alpha * beta / ((alpha + beta) * (alpha + beta) * (alpha + beta + 1.f));
+  EXPECT_GE(samples.min().item<float>(), 0.f);
+  EXPECT_LE(samples.max().item<float>(), 1.f);
+  EXPECT_NEAR(samples.mean().item<float>(), mean, 5.f * std::sqrt(var / num_samples_));
+  EXPECT_NEAR(samples.var().item<float>() / var, 1.f, 0.05f);
+}
+
+TEST_P(BetaSamplerParameterizedTest, MatchesReferenceSampler) {
+  torch::Tensor samples = torch::empty_like(this->alpha_);
+  modules::sample_beta(this->alpha_, this->beta_, samples);
+  const torch::Tensor& reference =
+    at::_sample_dirichlet(torch::stack({this->alpha_, this->beta_}, /*dim=*/-1)).select(-1, 0);
+
+  // 1% critical value of the two-sample statistic is 1.63 * sqrt(2 / n)
+  EXPECT_LT(ks_statistic(samples, reference), 1.63f * std::sqrt(2.f / num_samples_));
+}
+
+// Shapes below one take the boosted path, large ones the plain Marsaglia-Tsang path
+INSTANTIATE_TEST_SUITE_P(BetaSamplerTests, BetaSamplerParameterizedTest,
+                         ::testing::Values(std::make_tuple(0.3f, 0.5f), std::make_tuple(0.8f, 2.f),
+                                           std::make_tuple(1.f, 1.f), std::make_tuple(2.5f, 7.f),
+                                           std::make_tuple(50.f, 20.f)));
+
+TEST(GammaSamplerTest, MatchesAnalyticMoments) {
+  torch::manual_seed(0);
+  for (const float& shape : {0.1f, 0.5f, 1.f, 3.f, 20.f}) {
+    const torch::Tensor& samples = modules::sample_log_gamma(torch::full({100000}, shape)).exp();
+    // Gamma(shape, 1) has mean and variance both equal to shape
+    EXPECT_NEAR(samples.mean().item<float>() / shape, 1.f, 0.03f) << "shape " << shape;
+    EXPECT_NEAR(samples.var().item<float>() / shape, 1.f, 0.1f) << "shape " << shape;
+  }
+}
+
+TEST(BetaDistributionTest, SamplesMatchActionShapeAndBounds) {
+  configs::DistributionCfg cfg{0.1f, "beta"};
+  cfg.update(torch::tensor({-1.f, 0.f, -2.f}), torch::tensor({1.f, 1.f, 3.f}));
+  modules::Beta beta(cfg);
+
+  torch::manual_seed(0);
+  beta.update(0.25f + 0.5f * torch::rand({64, 3}));
+  const torch::Tensor& actions = beta.sample();
+
+  EXPECT_EQ(actions.sizes(), beta.get_mean().sizes());
+  EXPECT_TRUE((actions >= cfg.action_min).all().item<bool>());
+  EXPECT_TRUE((actions <= cfg.action_max).all().item<bool>());
+}
@@ -0,0 +1,229 @@
+#include "modules/mlp.h"
+
+#include <ATen/autocast_mode.h>
+#include <gtest/gtest.h>
+#include <torch/torch.h>
+
+// Relative distance between two tensors.
+static float relative_error(const torch::Tensor& actual, const torch::Tensor& expected) {
+  return ((actual - expected).norm() / (expected.norm() + 1e-6)).item<float>();
+}
+
+// Parameterized fixture: a float32 MLP and a bfloat16 MLP sharing the same weights.
+class MLPPrecisionParameterizedTest
+    : public ::testing::TestWithParam<std::tuple<std::string, int>> {
+ protected:
+  void SetUp() override {
+    const auto& [activation, depth] = GetParam();
+
+    configs::MLPCfg float_cfg{2, static_cast<unsigned int>(depth), activation, "float32"};
+    configs::MLPCfg bfloat16_cfg{2, static_cast<unsigned int>(depth), activation, "bfloat16"};
+    float_cfg.update(num_inputs_, num_outputs_);
+    bfloat16_cfg.update(num_inputs_, num_outputs_);
+
+    torch::manual_seed(0);
+    this->float_mlp_ = std::make_shared<modules::MLP>(float_cfg);
+    this->bfloat16_mlp_ = std::make_shared<modules::MLP>(bfloat16_cfg);
+
+    torch::NoGradGuard no_grad;
+    const auto float_parameters = this->float_mlp_->parameters();
+    const auto bfloat16_parameters = this->bfloat16_mlp_->parameters();
+    for (size_t i = 0; i < float_parameters.size(); ++i)
+      bfloat16_parameters[i].copy_(float_parameters[i]);
+
+    this->inputs_ = torch::randn({num_envs_, num_inputs_});
+  }
+
+  const int num_envs_ = 64;
+  const int num_inputs_ = 4;
+  const int num_outputs_ = 2;
+  modules::MLPPointer float_mlp_;
+  modules::MLPPointer bfloat16_mlp_;
+  torch::Tensor inputs_;
+};
+
+// The bfloat16 forward returns float32 outputs close to the float32 path.
+TEST_P(MLPPrecisionParameterizedTest, ForwardMatchesFloat32) {
+  const auto expected = this->float_mlp_->forward(this->inputs_);
+  const auto actual = this->bfloat16_mlp_->forward(this->inputs_);
+
+  EXPECT_EQ(actual.scalar_type(), torch::kFloat) << "Outputs are not float32";
+  EXPECT_EQ(actual.sizes(), expected.sizes()) << "Mismatch in output size";
+  EXPECT_LT(relative_error(actual, expected), 5e-2) << "Mismatch in outputs";
+}
+
+// Gradients reach the float32 master weights and match the float32 path.
+TEST_P(MLPPrecisionParameterizedTest, BackwardMatchesFloat32) {
+  this->float_mlp_->forward(this->inputs_).square().mean().backward();
+  this->bfloat16_mlp_->forward(this->inputs_).square().mean().backward();
+
+  const auto float_parameters = this->float_mlp_->parameters();
+  const auto bfloat16_parameters = this->bfloat16_mlp_->parameters();
+  for (size_t i = 0; i < float_parameters.size(); ++i) {
+    ASSERT_TRUE(bfloat16_parameters[i].grad().defined()) << "Missing gradient " << i;
+    EXPECT_EQ(bfloat16_parameters[i].grad().scalar_type(), torch::kFloat)
+      << "Gradient " << i << " is not float32";
+    EXPECT_LT(relative_error(bfloat16_parameters[i].grad(), float_parameters[i].grad()), 5e-2)
+      << "Mismatch in gradient " << i;
+  }
+}
+
+// Optimizer steps keep the weights in float32.
+TEST_P(MLPPrecisionParameterizedTest, MasterWeightsStayFloat32) {
+  torch::optim::Adam optimizer(this->bfloat16_mlp_->parameters(),
+                               torch::optim::AdamOptions(1e-3));
+  for (int i = 0; i < 3; ++i) {
+    optimizer.zero_grad();
+    this->bfloat16_mlp_->forward(this->inputs_).square().mean().backward();
+    optimizer.step();
+  }
+  for (const auto& parameter : this->bfloat16_mlp_->parameters())
+    EXPECT_EQ(parameter.scalar_type(), torch::kFloat) << "Weights are not float32";
+}
+
+// Autocast does not leak outside of the forward.
+TEST_P(MLPPrecisionParameterizedTest, AutocastStateIsRestored) {
+  this->bfloat16_mlp_->forward(this->inputs_);
+  EXPECT_FALSE(at::autocast::is_autocast_enabled(torch::kCPU)) << "Autocast left enabled";
+  const auto outputs = torch::mm(this->inputs_, this->inputs_.t());
+  EXPECT_EQ(outputs.scalar_type(), torch::kFloat) << "Ops after the forward are autocast";
+}
+
+TEST(MLPPrecisionTest, InvalidPrecisionThrows) {
+  configs::MLPCfg cfg{2, 1, "elu", "float16"};
+  cfg.update(4, 2);
+  EXPECT_THROW(modules::MLP{cfg}, std::invalid_argument);
+}
+
+// Parameterized fixture: a torch MLP and a native MLP sharing the same weights.
+class MLPBackendParameterizedTest
+    : public ::testing::TestWithParam<std::tuple<std::string, int, int>> {
+ protected:
+  void SetUp() override {
+    const auto& [activation, depth, num_envs] = GetParam();
+
+    configs::MLPCfg torch_cfg{32, static_cast<unsigned int>(depth), activation, "float32", "torch"};
+    configs::MLPCfg native_cfg{32, static_cast<unsigned int>(depth), activation, "float32",
+                               "native"};
+    torch_cfg.update(num_inputs_, num_outputs_);
+    native_cfg.update(num_inputs_, num_outputs_);
+
+    torch::manual_seed(0);
+    this->torch_mlp_ = std::make_shared<modules::MLP>(torch_cfg);
+    this->native_mlp_ = std::make_shared<modules::MLP>(native_cfg);
+
+    torch::NoGradGuard no_grad;
+    const auto torch_parameters = this->torch_mlp_->parameters();
+    const auto native_parameters = this->native_mlp_->parameters();
+    for (size_t i = 0; i < torch_parameters.size(); ++i)
+      native_parameters[i].copy_(torch_parameters[i]);
+
+    this->inputs_ = torch::randn({num_envs, num_inputs_});
+  }
+
+  const int num_inputs_ = 7;
+  const int num_outputs_ = 3;
+  modules::MLPPointer torch_mlp_;
+  modules::MLPPointer native_mlp_;
+  torch::Tensor inputs_;
+};
+
+// The native kernels match torch with and without gradient tracking.
+TEST_P(MLPBackendParameterizedTest, ForwardMatchesTorch) {
+  const auto expected = this->torch_mlp_->forward(this->inputs_);
+  const auto actual = this->native_mlp_->forward(this->inputs_);
+  EXPECT_EQ(actual.sizes(), expected.sizes()) << "Mismatch in output size";
+  EXPECT_LT(relative_error(actual, expected), 1e-5) << "Mismatch in outputs";
+
+  torch::NoGradGuard no_grad;
+  const auto actual_no_grad = this->native_mlp_->forward(this->inputs_);
+  EXPECT_LT(relative_error(actual_no_grad, expected), 1e-5) << "Mismatch in no-grad outputs";
+}
+
+// The native backward matches torch for the inputs and every parameter.
+TEST_P(MLPBackendParameterizedTest, BackwardMatchesTorch) {
+  const auto torch_inputs = this->inputs_.clone().requires_grad_(true);
+  const auto native_inputs = this->inputs_.clone().requires_grad_(true);
+  this->torch_mlp_->forward(torch_inputs).square().mean().backward();
+  this->native_mlp_->forward(native_inputs).square().mean().backward();
+
+  EXPECT_LT(relative_error(native_inputs.grad(), torch_inputs.grad()), 1e-4)
+    << "Mismatch in input gradient";
+  const auto torch_parameters = this->torch_mlp_->parameters();
+  const auto native_parameters = this->native_mlp_->parameters();
+  for (size_t i = 0; i < torch_parameters.size(); ++i) {
+    ASSERT_TRUE(native_parameters[i].grad().defined()) << "Missing gradient " << i;
+    EXPECT_LT(relative_error(native_parameters[i].grad(), torch_parameters[i].grad()), 1e-4)
+      << "Mismatch in gradient " << i;
+  }
+}
+
+// Prepacked weights follow optimizer updates.
+TEST_P(MLPBackendParameterizedTest, TracksOptimizerSteps) {
+  torch::optim::Adam optimizer(this->native_mlp_->parameters(), torch::optim::AdamOptions(1e-2));
+  torch::NoGradGuard no_grad;
+  const auto before = this->native_mlp_->forward(this->inputs_);
+  {
+    torch::AutoGradMode enable_grad(true);
+    optimizer.zero_grad();
+    this->native_mlp_->forward(this->inputs_).square().mean().backward();
+    optimizer.step();
+  }
+  const auto torch_parameters = this->torch_mlp_->parameters();
+  const auto native_parameters = this->native_mlp_->parameters();
+  for (size_t i = 0; i < torch_parameters.size(); ++i)
+    torch_parameters[i].copy_(native_parameters[i]);
+
+  const auto after = this->native_mlp_->forward(this->inputs_);
+  EXPECT_FALSE(torch::allclose(before, after)) << "Outputs did not change after the step";
+  EXPECT_LT(relative_error(after, this->torch_mlp_->forward(this->inputs_)), 1e-5)
+    << "Stale prepacked weights";
+}
+
+TEST(MLPBackendTest, InvalidBackendThrows) {
+  configs::MLPCfg cfg{2, 1, "elu", "float32", "cuda"};
+  cfg.update(4, 2);
+  EXPECT_THROW(modules::MLP{cfg}, std::invalid_argument);
+
+  configs::MLPCfg bfloat16_cfg{2, 1, "elu", "bfloat16", "native"};
+  bfloat16_cfg.update(4, 2);
+  EXPECT_THROW(modules::MLP{bfloat16_cfg}, std::invalid_argument);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  MLPBackendTests, MLPBackendParameterizedTest,
+  ::testing::Combine(
+    // activation
+    ::testing::Values(std::string("elu"), std::string("relu"), std::string("tanh"),
+                      std::string("sigmoid")),
+    // depth: 0, 1 or 2
+    ::testing::Values(0, 1, 2),
+    // batch size: below, off and on the register block
+    ::testing::Values(1, 5, 64)),
+  [](const ::testing::TestParamInfo<std::tuple<std::string, int, int>>& info) {
+    std::string activation;
+    int depth;
+    int num_envs;
+    std::tie(activation, depth, num_envs) = info.param;
+    std::stringstream ss;
+    ss << activation << "_D" << depth << "_N" << num_envs;
+    return ss.str();
+  });
+
+// Instantiate tests using Cartesian product of all parameter sets.
+INSTANTIATE_TEST_SUITE_P(
+  MLPPrecisionTests, MLPPrecisionParameterizedTest,
+  ::testing::Combine(
+    // activation
+    ::testing::Values(std::string("elu"), std::string("relu"), std::string("tanh"),
+                      std::string("sigmoid")),
+    // depth: 0, 1 or 2
+    ::testing::Values(0, 1, 2)),
+  [](const ::testing::TestParamInfo<std::tuple<std::string, int>>& info) {
+    std::string activation;
+    int depth;
+    std::tie(activation, depth) = info.param;
+    std::stringstream ss;
+    ss << activation << "_D" << depth;
+    return ss.str();
+  });
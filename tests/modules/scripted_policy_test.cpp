@@ -0,0 +1,98 @@
+#include "modules/scripted_policy.h"
+
+#include <gtest/gtest.h>
+#include <torch/torch.h>
+
+#include <sstream>
+#include <string>
+#include <tuple>
+
+// distribution type, normalizer type
+using ScriptedPolicyTestParams = std::tuple<std::string, std::string>;
+
+// Parameterized fixture: an ActorCritic with trained normalizer statistics and the scripted
+// rollout step compiled from the same configs.
+class ScriptedPolicyParameterizedTest
+    : public ::testing::TestWithParam<ScriptedPolicyTestParams> {
+ protected:
+  void SetUp() override {
+    const auto& [distribution, normalizer] = GetParam();
+    configs::ActorCfg actor_cfg{configs::NormalizerCfg(normalizer),
+                                configs::MLPCfg(2, 2, "elu"),
+                                configs::DistributionCfg(0.5f, distribution)};
+    configs::CriticCfg critic_cfg{configs::NormalizerCfg(normalizer),
+                                  configs::MLPCfg(2, 2, "elu")};
+    // Wide bounds keep the beta mean away from them, so that alpha and beta stay positive
+    actor_cfg.update(num_actor_obs_, torch::full({num_actions_}, -5.f),
+                     torch::full({num_actions_}, 5.f));
+    critic_cfg.update(num_critic_obs_);
+
+    torch::manual_seed(0);
+    this->actor_critic_ = std::make_unique<modules::ActorCritic>(actor_cfg, critic_cfg);
+    this->scripted_policy_ = std::make_unique<modules::ScriptedPolicy>(actor_cfg, critic_cfg);
+
+    torch::NoGradGuard no_grad;
+    this->actor_critic_->update_normalizers(2.f * torch::randn({num_envs_, num_actor_obs_}) + 1.f,
+                                            2.f * torch::randn({num_envs_, num_critic_obs_}) - 1.f);
+    this->actor_obs_ = torch::randn({num_envs_, num_actor_obs_});
+    this->critic_obs_ = torch::randn({num_envs_, num_critic_obs_});
+  }
+
+  const int64_t num_envs_ = 32;
+  const int64_t num_actor_obs_ = 5;
+  const int64_t num_critic_obs_ = 7;
+  const int64_t num_actions_ = 3;
+  modules::ActorCriticPointer actor_critic_;
+  modules::ScriptedPolicyPointer scripted_policy_;
+  torch::Tensor actor_obs_;
+  torch::Tensor critic_obs_;
+};
+
+TEST_P(ScriptedPolicyParameterizedTest, MatchesEagerDistribution) {
+  const auto& [distribution, normalizer] = GetParam();
+  torch::NoGradGuard no_grad;
+
+  // Same seed for both samplers, the beta ones go through the same op
+  torch::manual_seed(1);
+  const modules::PolicyStep& step =
+    this->scripted_policy_->forward(*this->actor_critic_, this->actor_obs_, this->critic_obs_);
+  torch::manual_seed(1);
+  const auto& [actions, values] =
+    this->actor_critic_->forward_evaluate(this->actor_obs_, this->critic_obs_);
+
+  EXPECT_TRUE(torch::allclose(step.values, values, 1e-5, 1e-5)) << "Value mismatch";
+  EXPECT_EQ(step.actions.sizes(), actions.sizes()) << "Action size mismatch";
+  if (distribution == "beta")
+    EXPECT_TRUE(torch::allclose(step.actions, actions, 1e-5, 1e-5)) << "Beta sample mismatch";
+
+  // Log-probabilities of the scripted actions under the eager distribution
+  const torch::Tensor& log_probs = this->actor_critic_->get_actions_log_prob(step.actions);
+  EXPECT_TRUE(torch::allclose(step.log_probs, log_probs, 1e-4, 1e-5)) << "Log-prob mismatch";
+
+  const DictTensor& kl_params = this->actor_critic_->get_distribution_kl_params();
+  ASSERT_EQ(step.kl_params.size(), kl_params.size()) << "KL parameter names mismatch";
+  for (const auto& [name, value] : kl_params) {
+    ASSERT_TRUE(step.kl_params.count(name)) << "Missing KL parameter " << name;
+    EXPECT_TRUE(torch::allclose(step.kl_params.at(name), value.expand_as(step.kl_params.at(name)),
+                                1e-5, 1e-5))
+      << "KL parameter " << name << " mismatch";
+  }
+  if (distribution == "beta")
+    EXPECT_TRUE((kl_params.at("alpha") > 0.f).all().item<bool>() &&
+                (kl_params.at("beta") > 0.f).all().item<bool>())
+      << "Degenerate beta parameters";
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  ScriptedPolicyTests, ScriptedPolicyParameterizedTest,
+  ::testing::Combine(
+    // distribution
+    ::testing::Values(std::string("normal"), std::string("beta")),
+    // normalizer
+    ::testing::Values(std::string("identity"), std::string("empirical"))),
+  [](const ::testing::TestParamInfo<ScriptedPolicyTestParams>& info) {
+    const auto& [distribution, normalizer] = info.param;
+    std::stringstream ss;
+    ss << distribution << "_" << normalizer;
+    return ss.str();
+  });
@@ -0,0 +1,153 @@
+#include "storage/mmap_checkpoint.h"
+
+#include <gtest/gtest.h>
+#include <torch/torch.h>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "modules/actor_critic.h"
+
+// Fixture: two ActorCritics with different weights and statistics, the first serialized to a
+// temporary mapped checkpoint.
+class MmapCheckpointTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    torch::manual_seed(0);
+    this->source_ = this->make_actor_critic_();
+    this->target_ = this->make_actor_critic_();
+    torch::NoGradGuard no_grad;
+    this->source_->update_normalizers(torch::randn({16, num_actor_obs_}) + 1.f,
+                                      torch::randn({16, num_critic_obs_}) - 1.f);
+
+    this->path_ = (std::filesystem::temp_directory_path() /
+                   ("cpp_rl_mmap_checkpoint_test_" + std::to_string(::getpid()) + ".map"))
+                    .string();
+    this->buffer_ = storage::MmapCheckpoint::serialize(*this->source_);
+  }
+
+  void TearDown() override { std::filesystem::remove(this->path_); }
+
+  modules::ActorCriticPointer make_actor_critic_() const {
+    configs::ActorCfg actor_cfg{configs::NormalizerCfg("empirical"), configs::MLPCfg(2, 2, "elu"),
+                                configs::DistributionCfg(1.f, "normal")};
+    configs::CriticCfg critic_cfg{configs::NormalizerCfg("empirical"),
+                                  configs::MLPCfg(2, 2, "elu")};
+    actor_cfg.update(num_actor_obs_, -torch::ones({num_actions_}), torch::ones({num_actions_}));
+    critic_cfg.update(num_critic_obs_);
+    return std::make_unique<modules::ActorCritic>(actor_cfg, critic_cfg);
+  }
+
+  void write_(const std::string& buffer) const {
+    std::ofstream file(this->path_, std::ios::binary | std::ios::trunc);
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  }
+
+  // Position of a field of the first index entry, after its name
+  size_t first_entry_field_(const size_t& field_offset) const {
+    uint32_t name_size;
+    std::memcpy(&name_size, this->buffer_.data() + kHeaderSize, sizeof(name_size));
+    return kHeaderSize + sizeof(uint32_t) + name_size + field_offset;
+  }
+
+  // magic, version, number of entries
+  static constexpr size_t kHeaderSize = 8 + 2 * sizeof(uint32_t);
+  const int64_t num_actor_obs_ = 5;
+  const int64_t num_critic_obs_ = 7;
+  const int64_t num_actions_ = 3;
+  modules::ActorCriticPointer source_;
+  modules::ActorCriticPointer target_;
+  std::string path_;
+  std::string buffer_;
+};
+
+TEST_F(MmapCheckpointTest, RoundTripLoadsInferenceTensorsOnly) {
+  ASSERT_EQ(this->buffer_.size() % storage::MmapCheckpoint::kCheckpointAlignment, 0u);
+  this->write_(this->buffer_);
+
+  std::map<std::string, torch::Tensor> critic_before;
+  for (const auto& item : this->target_->named_parameters())
+    if (item.key().rfind("critic.", 0) == 0) critic_before[item.key()] = item.value().clone();
+  for (const auto& item : this->target_->named_buffers())
+    if (item.key().rfind("critic.", 0) == 0) critic_before[item.key()] = item.value().clone();
+  ASSERT_FALSE(critic_before.empty());
+
+  const storage::MmapCheckpoint checkpoint(this->path_);
+  checkpoint.load(*this->target_, modules::kInferencePrefixes);
+
+  std::map<std::string, torch::Tensor> source;
+  for (const auto& item : this->source_->named_parameters()) source[item.key()] = item.value();
+  for (const auto& item : this->source_->named_buffers()) source[item.key()] = item.value();
+
+  unsigned int num_loaded = 0;
+  const auto& check = [&](const std::string& name, const torch::Tensor& value) {
+    bool inference = false;
+    for (const std::string& prefix : modules::kInferencePrefixes)
+      inference = inference || name.rfind(prefix, 0) == 0;
+    if (inference) {
+      EXPECT_TRUE(torch::equal(value, source.at(name))) << name << " not loaded";
+      num_loaded += 1;
+    } else if (critic_before.count(name)) {
+      EXPECT_TRUE(torch::equal(value, critic_before.at(name))) << name << " overwritten";
+    }
+  };
+  for (const auto& item : this->target_->named_parameters()) check(item.key(), item.value());
+  for (const auto& item : this->target_->named_buffers()) check(item.key(), item.value());
+  EXPECT_GT(num_loaded, 0u);
+
+  // The mapping outlives the checkpoint object and the inference forward uses it
+  const torch::Tensor& observations = torch::randn({4, num_actor_obs_});
+  EXPECT_TRUE(torch::allclose(this->target_->get_inference_policy()(observations),
+                              this->source_->get_inference_policy()(observations)));
+}
+
+TEST_F(MmapCheckpointTest, RejectsInvalidType) {
+  std::string buffer = this->buffer_;
+  const uint32_t dtype = 1000;
+  std::memcpy(buffer.data() + this->first_entry_field_(0), &dtype, sizeof(dtype));
+  this->write_(buffer);
+  EXPECT_THROW(storage::MmapCheckpoint checkpoint(this->path_), std::runtime_error);
+}
+
+TEST_F(MmapCheckpointTest, RejectsMisalignedOffset) {
+  std::string buffer = this->buffer_;
+  uint32_t dim;
+  std::memcpy(&dim, buffer.data() + this->first_entry_field_(sizeof(uint32_t)), sizeof(dim));
+  const size_t offset_position = this->first_entry_field_(2 * sizeof(uint32_t) + dim * 8);
+  uint64_t offset;
+  std::memcpy(&offset, buffer.data() + offset_position, sizeof(offset));
+  offset += 4;
+  std::memcpy(buffer.data() + offset_position, &offset, sizeof(offset));
+  this->write_(buffer);
+  EXPECT_THROW(storage::MmapCheckpoint checkpoint(this->path_), std::runtime_error);
+}
+
+TEST_F(MmapCheckpointTest, RejectsOverflowingTensor) {
+  std::string buffer = this->buffer_;
+  uint32_t dim;
+  std::memcpy(&dim, buffer.data() + this->first_entry_field_(sizeof(uint32_t)), sizeof(dim));
+  ASSERT_GT(dim, 0u);
+  // A size whose byte count wraps around, and an offset past the end of the file
+  const int64_t size = INT64_MAX;
+  std::memcpy(buffer.data() + this->first_entry_field_(2 * sizeof(uint32_t)), &size, sizeof(size));
+  this->write_(buffer);
+  EXPECT_THROW(storage::MmapCheckpoint checkpoint(this->path_), std::runtime_error);
+
+  buffer = this->buffer_;
+  const size_t offset_position = this->first_entry_field_(2 * sizeof(uint32_t) + dim * 8);
+  const uint64_t offset = UINT64_MAX - storage::MmapCheckpoint::kCheckpointAlignment + 1;
+  std::memcpy(buffer.data() + offset_position, &offset, sizeof(offset));
+  this->write_(buffer);
+  EXPECT_THROW(storage::MmapCheckpoint checkpoint(this->path_), std::runtime_error);
+}
+
+TEST_F(MmapCheckpointTest, RejectsTruncatedFile) {
+  this->write_(this->buffer_.substr(0, this->buffer_.size() / 2));
+  EXPECT_THROW(storage::MmapCheckpoint checkpoint(this->path_), std::runtime_error);
+}
@@ -3,48 +3,33 @@
 #include <gtest/gtest.h>
 #include <torch/torch.h>
 
-// Structure to hold test parameters.
-struct ObsBufferTestParams {
-  int num_actor_obs;       // 1 or 2
-  int num_critic_obs;      // 1 or 2
-  int num_actions;         // 1, or 2
-  int num_envs;            // 1 or 2
-  int memory_length;       // 1 or 2
-  bool store_action;       // false or true
-  std::string device_str;  // "cpu" or "gpu"
-  bool use_indices;        // false: update all envs, true: update one env (index 0)
-};
+#include <sstream>
+#include <string>
+#include <tuple>
+
+#include "configs/configs.h"
+
+// num_actor_obs, num_critic_obs, num_actions, num_envs, memory_length, store_action,
+// device ("cpu" or "gpu"), use_indices (false: update all envs, true: update env 0 only)
+using ObsBufferTestParams = std::tuple<int, int, int, int, int, bool, std::string, bool>;
 
 // Parameterized test fixture.
 class ObservationBufferParameterizedTest : public ::testing::TestWithParam<ObsBufferTestParams> {
  protected:
   void SetUp() override {
-    // Get the test parameters.
-    const auto& params = GetParam();
-
-    // Create a dummy config.
-    const configs::EnvCfg env_cfg{.num_envs = params.num_envs};
-    const configs::RunnerCfg runner_cfg{.observation_memory_length = params.memory_length,
-                                        .observation_memory_store_action = params.store_action};
-    const configs::PPOCfg ppo_cfg{};
-    const configs::ActorCfg actor_cfg{};
-    const configs::CriticCfg critic_cfg{};
-    this->cfg_ =
-      std::make_shared<configs::Cfg>(env_cfg, runner_cfg, ppo_cfg, actor_cfg, critic_cfg);
-
-    this->num_actor_obs_ = params.num_actor_obs;
-    this->num_critic_obs_ = params.num_critic_obs;
-    this->num_actions_ = params.num_actions;
-    this->use_indices_ = params.use_indices;
+    std::string device_str;
+    bool store_action;
+    std::tie(num_actor_obs_, num_critic_obs_, num_actions_, num_envs_, memory_length_,
+             store_action, device_str, use_indices_) = GetParam();
+    this->cfg_ = configs::make_default_cfg("pendulum", num_envs_, "rk4", memory_length_, 32,
+                                           store_action);
 
     // Set device.
-    if (params.device_str == "gpu") {
+    if (device_str == "gpu") {
       if (!torch::cuda::is_available()) {
         GTEST_SKIP() << "CUDA not available, skipping GPU test.";
       }
-      device_ = Device(torch::kCUDA);
-    } else {
-      device_ = Device(torch::kCPU);
+      device_ = torch::Device(torch::kCUDA);
     }
   }
 
@@ -52,8 +37,10 @@ class ObservationBufferParameterizedTest : public ::testing::TestWithParam<ObsBu
   int num_actor_obs_;
   int num_critic_obs_;
   int num_actions_;
+  int num_envs_;
+  int memory_length_;
   bool use_indices_;
-  torch::Device device_;
+  torch::Device device_ = torch::Device(torch::kCPU);
 };
 
 // Test that reset fills the buffer correctly.
@@ -69,10 +56,9 @@ TEST_P(ObservationBufferParameterizedTest, ResetFillsBufferWithExtendedObs) {
   const auto critic_obs =
     torch::rand({num_envs_, num_critic_obs_}, torch::TensorOptions().device(device_));
 
-  const env::Results results{
-    .actor_obs = actor_obs,
-    .critic_obs = critic_obs,
-  };
+  env::Results results;
+  results.actor_obs = actor_obs;
+  results.critic_obs = critic_obs;
 
   // Prepare indices: if use_indices_ is true, update only env 0 via a boolean mask.
   torch::Tensor indices;
@@ -110,11 +96,28 @@ TEST_P(ObservationBufferParameterizedTest, ResetFillsBufferWithExtendedObs) {
   const auto buffer_actor_obs = obs_buffer.get_actor_obs().view({num_envs_, memory_length_, -1});
   const auto buffer_critic_obs = obs_buffer.get_critic_obs().view({num_envs_, memory_length_, -1});
 
-  EXPECT_EQ(buffer_actor_obs.sizes, expected_actor_obs.sizes()) << "Mismatch in actor obs size";
-  EXPECT_EQ(buffer_critic_obs.sizes, expected_critic_obs.sizes()) << "Mismatch in critic obs size";
-
-  EXPECT_TRUE(torch::allclose(buffer_actor_obs, expected_actor_obs)) << "Mismatch in actor obs";
-  EXPECT_TRUE(torch::allclose(buffer_critic_obs, expected_critic_obs)) << "Mismatch in critic obs";
+  // Every time slot of the updated envs holds the reset observation.
+  const int n_update = use_indices_ ? 1 : num_envs_;
+  const auto updated_actor_obs = buffer_actor_obs.slice(0, 0, n_update);
+  const auto updated_critic_obs = buffer_critic_obs.slice(0, 0, n_update);
+  const auto expected_actor_memory =
+    expected_actor_obs.unsqueeze(1).expand({-1, memory_length_, -1});
+  const auto expected_critic_memory =
+    expected_critic_obs.unsqueeze(1).expand({-1, memory_length_, -1});
+
+  EXPECT_EQ(updated_actor_obs.sizes(), expected_actor_memory.sizes())
+    << "Mismatch in actor obs size";
+  EXPECT_EQ(updated_critic_obs.sizes(), expected_critic_memory.sizes())
+    << "Mismatch in critic obs size";
+  EXPECT_TRUE(torch::allclose(updated_actor_obs, expected_actor_memory)) << "Mismatch in actor obs";
+  EXPECT_TRUE(torch::allclose(updated_critic_obs, expected_critic_memory))
+    << "Mismatch in critic obs";
+
+  // The remaining envs keep their zero initialization.
+  EXPECT_TRUE((buffer_actor_obs.slice(0, n_update) == 0).all().item<bool>())
+    << "Reset modified actor obs of other envs";
+  EXPECT_TRUE((buffer_critic_obs.slice(0, n_update) == 0).all().item<bool>())
+    << "Reset modified critic obs of other envs";
 }
 
 // Test that memorize shifts (rolls) the buffer and updates the last time step.
@@ -128,10 +131,9 @@ TEST_P(ObservationBufferParameterizedTest, MemorizeRollsBufferAndUpdatesLastStep
     torch::rand({num_envs_, num_actor_obs_}, torch::TensorOptions().device(device_));
   const auto reset_critic_obs =
     torch::rand({num_envs_, num_critic_obs_}, torch::TensorOptions().device(device_));
-  const env::Results reset_results{
-    .actor_obs = reset_actor_obs,
-    .critic_obs = reset_critic_obs,
-  };
+  env::Results reset_results;
+  reset_results.actor_obs = reset_actor_obs;
+  reset_results.critic_obs = reset_critic_obs;
 
   obs_buffer.reset(reset_results);
 
@@ -143,10 +145,9 @@ TEST_P(ObservationBufferParameterizedTest, MemorizeRollsBufferAndUpdatesLastStep
   const auto actions =
     torch::rand({num_envs_, num_actions_}, torch::TensorOptions().device(device_));
 
-  env::Results new_results{
-    .actor_obs = actor_obs,
-    .critic_obs = critic_obs,
-  };
+  env::Results new_results;
+  new_results.actor_obs = actor_obs;
+  new_results.critic_obs = critic_obs;
 
   // Call memorize.
   obs_buffer.memorize(new_results, actions);
@@ -164,22 +165,35 @@ TEST_P(ObservationBufferParameterizedTest, MemorizeRollsBufferAndUpdatesLastStep
   // The last time slot in each environment should now match the expected new extended observation.
   const auto buffer_actor_obs = obs_buffer.get_actor_obs().view({num_envs_, memory_length_, -1});
   const auto buffer_critic_obs = obs_buffer.get_critic_obs().view({num_envs_, memory_length_, -1});
+  const auto last_actor_obs = buffer_actor_obs.select(1, memory_length_ - 1);
+  const auto last_critic_obs = buffer_critic_obs.select(1, memory_length_ - 1);
 
-  EXPECT_EQ(buffer_actor_obs.sizes, expected_new_actor_obs.sizes()) << "Mismatch in actor obs size";
-  EXPECT_EQ(buffer_critic_obs.sizes, expected_new_critic_obs.sizes())
+  EXPECT_EQ(last_actor_obs.sizes(), expected_new_actor_obs.sizes()) << "Mismatch in actor obs size";
+  EXPECT_EQ(last_critic_obs.sizes(), expected_new_critic_obs.sizes())
     << "Mismatch in critic obs size";
-  EXPECT_TRUE(torch::allclose(buffer_actor_obs, expected_new_actor_obs))
+  EXPECT_TRUE(torch::allclose(last_actor_obs, expected_new_actor_obs))
     << "Memorize did not update actor obs correctly";
-  EXPECT_TRUE(torch::allclose(buffer_critic_obs, expected_new_critic_obs))
+  EXPECT_TRUE(torch::allclose(last_critic_obs, expected_new_critic_obs))
     << "Memorize did not update critic obs correctly";
 
   if (memory_length_ > 1) {
-    // Verify the shifting`of the buffer.
-    EXPECT_TRUE(torch::allclose(buffer_actor_obs.slice(1, 0, memory_length_ - 1),
-                                buffer_actor_obs.slice(1, 1, memory_length_)))
+    // The older slots were shifted by one and still hold the reset observation, with zero actions.
+    const auto options = torch::TensorOptions().device(device_);
+    const int num_stored_actions =
+      cfg_->runner_cfg.observation_memory_store_action ? num_actions_ : 0;
+    const auto reset_actor_memory =
+      torch::cat({reset_actor_obs, torch::zeros({num_envs_, num_stored_actions}, options)}, 1)
+        .unsqueeze(1)
+        .expand({-1, memory_length_ - 1, -1});
+    const auto reset_critic_memory =
+      torch::cat({reset_critic_obs, torch::zeros({num_envs_, num_stored_actions}, options)}, 1)
+        .unsqueeze(1)
+        .expand({-1, memory_length_ - 1, -1});
+    EXPECT_TRUE(
+      torch::allclose(buffer_actor_obs.slice(1, 0, memory_length_ - 1), reset_actor_memory))
       << "Shifted actor observations do not match.";
-    EXPECT_TRUE(torch::allclose(buffer_critic_obs.slice(1, 0, memory_length_ - 1),
-                                buffer_critic_obs.slice(1, 1, memory_length_)))
+    EXPECT_TRUE(
+      torch::allclose(buffer_critic_obs.slice(1, 0, memory_length_ - 1), reset_critic_memory))
       << "Shifted critic observations do not match.";
   }
 }
@@ -204,8 +218,7 @@ INSTANTIATE_TEST_SUITE_P(
     ::testing::Values(std::string("cpu"), std::string("gpu")),
     // indices: false (update all) or true (update only one env)
     ::testing::Values(false, true)),
-  [](const ::testing::TestParamInfo<std::tuple<int, int, int, int, int, bool, std::string, bool>>&
-       info) {
+  [](const ::testing::TestParamInfo<ObsBufferTestParams>& info) {
     int num_actor_obs, num_critic_obs, num_actions, num_envs, memory_length;
     bool store_action, use_indices;
     std::string device_str;
@@ -217,8 +230,3 @@ INSTANTIATE_TEST_SUITE_P(
        << device_str << "_" << (use_indices ? "Indices" : "NoIndices");
     return ss.str();
   });
-
-int main(int argc, char** argv) {
-  ::testing::InitGoogleTest(&argc, argv);
-  return RUN_ALL_TESTS();
-}